@@ -22,15 +22,20 @@ char *progname;
  */
 int main(int argc, char *argv[]) {
 	progname = *(argv);
+	//headless run, no curses at all
+	if (hds_batch_requested(argc, argv)) {
+		exit(hds_batch_main(argc, argv));
+	}
 	init_signals();
 
-	CDKparseParams(argc, argv, &hds_state.params, CDK_CLI_PARAMS);
+	CDKparseParams(argc, argv, &hds_ui_state.params, CDK_CLI_PARAMS);
 
 	//initialize hds_state
 	if (init_hds_state() != HDS_OK) {
 		fprintf(stderr, "hds_state_init: failed. Aborting");
 		exit(EXIT_FAILURE);
 	}
+	init_hds_ui_state();
 	//intialize configuration
 	if (load_config() == HDS_ERR_CONFIG_ABORT) {
 		exit(EXIT_FAILURE);
@@ -71,11 +76,11 @@ void process_user_response() {
 		switch (ch) {
 		case KEY_NPAGE: // pagedown
 			// pagedown key will be bound to output window
-			activateCDKSwindow(hds_state.console, 0);
+			activateCDKSwindow(hds_ui_state.console, 0);
 			break;
 		case KEY_PPAGE: //pageup
 			// pagedown key will be assigned to console window
-			activateCDKSwindow(hds_state.output_screen, 0);
+			activateCDKSwindow(hds_ui_state.output_screen, 0);
 			break;
 		case KEY_F(4):
 			hds_shutdown();
@@ -98,16 +103,16 @@ void process_user_response() {
 //			}
 			// if anything other than F4 was pressed inject it
 			// to entry widget.
-			injectCDKEntry(hds_state.read_input, ch);
+			injectCDKEntry(hds_ui_state.read_input, ch);
 			//read anything from user
-			info = activateCDKEntry(hds_state.read_input, 0);
-			if (hds_state.read_input->exitType == vESCAPE_HIT) {
+			info = activateCDKEntry(hds_ui_state.read_input, 0);
+			if (hds_ui_state.read_input->exitType == vESCAPE_HIT) {
 				sdebug("pressed ESC");
-			} else if (hds_state.read_input->exitType == vNORMAL) {
+			} else if (hds_ui_state.read_input->exitType == vNORMAL) {
 				//write_to_result_window(info,1);
 				execute_commands(info);
 			}
-			cleanCDKEntry(hds_state.read_input);
+			cleanCDKEntry(hds_ui_state.read_input);
 			break;
 		}
 	}
@@ -132,7 +137,7 @@ void hds_shutdown() {
 //	sleep(PARENT_WAIT_FOR_CHILD_THREADS);
 
 	//shut down GUI
-	if (hds_state.gui_ready == TRUE) {
+	if (hds_ui_state.gui_ready == TRUE) {
 		close_ui();
 	} else {
 		/* Exit CDK. */
@@ -140,17 +145,21 @@ void hds_shutdown() {
 		endCDK();
 	}
 	//collect master threads
-	if (pthread_join(hds_state.hds_dispatcher, NULL ) != 0) {
-		fprintf(stderr, "\nError in collecting thread: hds_dispatcher");
-		exit(EXIT_FAILURE);
-	}
-	if (pthread_join(hds_state.hds_scheduler, NULL ) != 0) {
-		fprintf(stderr, "\nError in collecting thread: hds_scheduler");
-		exit(EXIT_FAILURE);
-	}
-	if (pthread_join(hds_state.hds_cpu, NULL ) != 0) {
-		fprintf(stderr, "\nError in collecting thread: hds_cpu");
-		exit(EXIT_FAILURE);
+	if (hds_config.engine == HDS_ENGINE_EVENT) {
+		if (pthread_join(hds_state.hds_sim_engine, NULL ) != 0) {
+			fprintf(stderr, "\nError in collecting thread: hds_sim_engine");
+			exit(EXIT_FAILURE);
+		}
+	} else {
+		if (pthread_join(hds_state.hds_dispatcher, NULL ) != 0) {
+			fprintf(stderr, "\nError in collecting thread: hds_dispatcher");
+			exit(EXIT_FAILURE);
+		}
+		if (pthread_join(hds_state.hds_scheduler, NULL ) != 0) {
+			fprintf(stderr, "\nError in collecting thread: hds_scheduler");
+			exit(EXIT_FAILURE);
+		}
+		hds_cpus_join();
 	}
 	if (pthread_join(hds_state.hds_stats_manager, NULL ) != 0) {
 		fprintf(stderr, "\nError in collecting thread: hds_stats_manager");
@@ -208,22 +217,31 @@ int start_main_worker_threads() {
 	//first init the hds_core state
 	init_hds_core_state();
 
-	//create main hds_dispatcher thread
-	if (pthread_create(&hds_state.hds_dispatcher, NULL, hds_dispatcher, NULL )
-			!= 0) {
-		serror("\nFailed to create dispatcher thread");
-		return HDS_ERR_THREAD_INIT;
-	}
-	//create scheduler thread
-	if (pthread_create(&hds_state.hds_scheduler, NULL, hds_scheduler, NULL )
-			!= 0) {
-		serror("\nFailed to create scheduler thread");
-		return HDS_ERR_THREAD_INIT;
-	}
-	//create cpu_thread
-	if (pthread_create(&hds_state.hds_cpu, NULL, hds_cpu, NULL ) != 0) {
-		serror("\nFailed to create cpu thread");
-		return HDS_ERR_THREAD_INIT;
+	if (hds_config.engine == HDS_ENGINE_EVENT) {
+		//event engine replaces dispatcher, scheduler and cpu threads
+		if (pthread_create(&hds_state.hds_sim_engine, NULL, hds_sim_engine,
+				NULL ) != 0) {
+			serror("\nFailed to create event engine thread");
+			return HDS_ERR_THREAD_INIT;
+		}
+	} else {
+		//create main hds_dispatcher thread
+		if (pthread_create(&hds_state.hds_dispatcher, NULL, hds_dispatcher,
+				NULL ) != 0) {
+			serror("\nFailed to create dispatcher thread");
+			return HDS_ERR_THREAD_INIT;
+		}
+		//create scheduler thread
+		if (pthread_create(&hds_state.hds_scheduler, NULL, hds_scheduler, NULL )
+				!= 0) {
+			serror("\nFailed to create scheduler thread");
+			return HDS_ERR_THREAD_INIT;
+		}
+		//create one thread per cpu
+		if (hds_cpus_start() != HDS_OK) {
+			serror("\nFailed to create cpu thread");
+			return HDS_ERR_THREAD_INIT;
+		}
 	}
 	// create_stats thread
 	if (pthread_create(&hds_state.hds_stats_manager, NULL, hds_stats_manager,
@@ -12,5 +12,7 @@
 #include "hds_common.h"
 #include "hds_ui.h"
 #include "hds_core.h"
+#include "hds_sim.h"
+#include "hds_batch.h"
 
 #endif
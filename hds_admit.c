@@ -0,0 +1,170 @@
+/**
+ * @file hds_admit.c
+ * @brief Admission tests over many queued processes at once. The needs of a
+ * 		  run queue level sit one after the other, so a kernel can compare
+ * 		  every lane of a need against what is available with one or two
+ * 		  vector compares and go on to the next need without a branch per
+ * 		  lane. The kernel is picked when the core starts, the best one the
+ * 		  cpu supports unless 'admission_kernel' in hds.conf names one; every
+ * 		  kernel gives the same answers.
+ */
+#include "hds_admit.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HDS_ADMIT_X86
+#endif
+//=========== routines declaration============
+static unsigned int first_scalar(const hds_resvec_t *need, unsigned int n,
+		const hds_resvec_t *avail);
+#ifdef HDS_ADMIT_X86
+static unsigned int first_sse2(const hds_resvec_t *need, unsigned int n,
+		const hds_resvec_t *avail);
+static unsigned int first_avx2(const hds_resvec_t *need, unsigned int n,
+		const hds_resvec_t *avail);
+#endif
+static bool supported(hds_admit_kernel_t kernel);
+//===========================================
+static struct hds_admit_ops_t kernels[HDS_ADMIT_KERNELS] = {
+	[HDS_ADMIT_SCALAR] = { "scalar", first_scalar },
+#ifdef HDS_ADMIT_X86
+	[HDS_ADMIT_SSE2] = { "sse2", first_sse2 },
+	[HDS_ADMIT_AVX2] = { "avx2", first_avx2 },
+#else
+	[HDS_ADMIT_SSE2] = { "sse2", first_scalar },
+	[HDS_ADMIT_AVX2] = { "avx2", first_scalar },
+#endif
+};
+static struct hds_admit_ops_t *admit = &kernels[HDS_ADMIT_SCALAR];
+/**
+ * @brief Use a kernel for every admission test from now on.
+ * @param kernel HDS_ADMIT_AUTO for the best one the cpu supports.
+ * @return HDS_OK, or HDS_ERR_GENERIC if the cpu does not support it; then
+ * 		the best one it does support is used.
+ */
+int hds_admit_select(hds_admit_kernel_t kernel) {
+	int rc = HDS_OK;
+	if (kernel != HDS_ADMIT_AUTO && !supported(kernel)) {
+		var_warn("Admission kernel %s is not supported by this cpu",
+				kernels[kernel].name);
+		rc = HDS_ERR_GENERIC;
+		kernel = HDS_ADMIT_AUTO;
+	}
+	if (kernel == HDS_ADMIT_AUTO) {
+		kernel = HDS_ADMIT_KERNELS - 1;
+		while (!supported(kernel)) {
+			kernel--;
+		}
+	}
+	admit = &kernels[kernel];
+	var_debug("Admission kernel: %s", admit->name);
+	return rc;
+}
+/**
+ * @brief Name of the kernel in use.
+ */
+const char *hds_admit_name() {
+	return admit->name;
+}
+/**
+ * @brief Kernel of a name as given for 'admission_kernel' in hds.conf.
+ * @return The kernel, HDS_ADMIT_AUTO for "auto" or -1 if there is none.
+ */
+int hds_admit_lookup(const char *name) {
+	int i;
+	if (strcmp(name, "auto") == 0) {
+		return HDS_ADMIT_AUTO;
+	}
+	for (i = 0; i < HDS_ADMIT_KERNELS; i++) {
+		if (strcmp(kernels[i].name, name) == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
+/**
+ * @brief Index of the first of n needs which fits in avail.
+ * @return The index, n if none fits.
+ */
+unsigned int hds_admit_first(const hds_resvec_t *need, unsigned int n,
+		const hds_resvec_t *avail) {
+	return admit->first(need, n, avail);
+}
+static bool supported(hds_admit_kernel_t kernel) {
+#ifdef HDS_ADMIT_X86
+	// the vector kernels load a whole need as 8 ints
+	if (kernel != HDS_ADMIT_SCALAR && HDS_MAX_RESOURCES != 8) {
+		return false;
+	}
+	__builtin_cpu_init();
+	switch (kernel) {
+	case HDS_ADMIT_SSE2:
+		return __builtin_cpu_supports("sse2");
+	case HDS_ADMIT_AVX2:
+		return __builtin_cpu_supports("avx2");
+	default:
+		break;
+	}
+	return true;
+#else
+	return kernel == HDS_ADMIT_SCALAR;
+#endif
+}
+// //////////// scalar ////////////////////////////////
+static unsigned int first_scalar(const hds_resvec_t *need, unsigned int n,
+		const hds_resvec_t *avail) {
+	unsigned int i;
+	for (i = 0; i < n; i++) {
+		if (hds_resvec_fits(&need[i], avail)) {
+			return i;
+		}
+	}
+	return n;
+}
+#ifdef HDS_ADMIT_X86
+/*
+ * A need fits when no lane of it is greater than that lane of avail: the
+ * lanes of a signed compare for greater are or'ed together and tested for
+ * zero. Needs are only aligned like an int, so they are loaded unaligned.
+ */
+// //////////// sse2 //////////////////////////////////
+__attribute__((target("sse2")))
+static inline bool fits_sse2(const hds_resvec_t *need, __m128i lo,
+		__m128i hi) {
+	const __m128i *v = (const __m128i *) need;
+	__m128i over = _mm_or_si128(_mm_cmpgt_epi32(_mm_loadu_si128(v), lo),
+			_mm_cmpgt_epi32(_mm_loadu_si128(v + 1), hi));
+	return _mm_movemask_epi8(over) == 0;
+}
+__attribute__((target("sse2")))
+static unsigned int first_sse2(const hds_resvec_t *need, unsigned int n,
+		const hds_resvec_t *avail) {
+	const __m128i *a = (const __m128i *) avail;
+	__m128i lo = _mm_loadu_si128(a), hi = _mm_loadu_si128(a + 1);
+	unsigned int i;
+	for (i = 0; i < n; i++) {
+		if (fits_sse2(&need[i], lo, hi)) {
+			return i;
+		}
+	}
+	return n;
+}
+// //////////// avx2 //////////////////////////////////
+__attribute__((target("avx2")))
+static inline bool fits_avx2(const hds_resvec_t *need, __m256i a) {
+	__m256i over = _mm256_cmpgt_epi32(
+			_mm256_loadu_si256((const __m256i *) need), a);
+	return _mm256_testz_si256(over, over);
+}
+__attribute__((target("avx2")))
+static unsigned int first_avx2(const hds_resvec_t *need, unsigned int n,
+		const hds_resvec_t *avail) {
+	__m256i a = _mm256_loadu_si256((const __m256i *) avail);
+	unsigned int i;
+	for (i = 0; i < n; i++) {
+		if (fits_avx2(&need[i], a)) {
+			return i;
+		}
+	}
+	return n;
+}
+#endif
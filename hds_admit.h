@@ -0,0 +1,30 @@
+/**
+ * @file hds_admit.h
+ * @brief header file for hds_admit.c
+ */
+#ifndef HDS_ADMIT_H_
+#define HDS_ADMIT_H_
+
+#include "hds_common.h"
+#include "hds_resource.h"
+#include <stdint.h>
+
+/**
+ * @struct hds_admit_ops_t
+ * @brief An admission kernel. Its test runs over needs laid out one after
+ * 		the other and admits a need which fits in avail in every lane.
+ */
+struct hds_admit_ops_t {
+	const char *name; /**< As given for 'admission_kernel' in hds.conf */
+	/** Index of the first of n needs which fits, n if none does */
+	unsigned int (*first)(const hds_resvec_t *need, unsigned int n,
+			const hds_resvec_t *avail);
+};
+
+// --------routines-----------
+int hds_admit_select(hds_admit_kernel_t kernel);
+const char *hds_admit_name();
+int hds_admit_lookup(const char *name);
+unsigned int hds_admit_first(const hds_resvec_t *need, unsigned int n,
+		const hds_resvec_t *avail);
+#endif /* HDS_ADMIT_H_ */
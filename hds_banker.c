@@ -0,0 +1,239 @@
+/**
+ * @file hds_banker.c
+ * @brief Deadlock avoidance with the Banker's algorithm ('deadlock_avoidance
+ * 		  = "banker"' in hds.conf). The claim of a process is what it asked
+ * 		  for; a grant is made only if afterwards every holder can still get
+ * 		  the rest of its claim in some order and finish.
+ *
+ * 		  The system is safe before every grant and the holders are kept in
+ * 		  the order of a safe sequence, so a grant is checked against that
+ * 		  sequence rather than from scratch. A grant only takes from what
+ * 		  is free for the holders ahead of the requester: from the
+ * 		  requester on, every holder finishes on the same units as before.
+ * 		  So if the requester can finish on what is left, it moves to the
+ * 		  front, one O(kinds) compare; else the holders ahead of it are
+ * 		  checked again, O(kinds * holders ahead). Only if one of them can
+ * 		  no longer finish is a new sequence looked for among all holders,
+ * 		  in O(holders^2 * kinds); a refusal always takes that, as it has to
+ * 		  show that no order is safe. Releases never make the system unsafe
+ * 		  and keep the order of the others.
+ */
+#include "hds_banker.h"
+//=========== routines declaration============
+static bool is_safe(struct hds_banker_t *b, const hds_resvec_t *avail);
+static bool ahead_can_finish(struct hds_banker_t *b, int pos,
+		const hds_resvec_t *avail);
+static void move_to_front(struct hds_banker_t *b, int slot);
+static int new_slot(struct hds_banker_t *b);
+static int grow(struct hds_banker_t *b);
+//===========================================
+/**
+ * @brief Initialise an empty table.
+ * @return HDS_OK on success else an error code.
+ */
+int hds_banker_init(struct hds_banker_t *b) {
+	memset(b, 0, sizeof(struct hds_banker_t));
+	if (grow(b) != HDS_OK) {
+		serror("Failed to allocate banker's table");
+		return HDS_ERR_NO_MEM;
+	}
+	return HDS_OK;
+}
+/**
+ * @brief Decide whether a process may be given req now, and if so record it.
+ * @param slot Slot of the process, -1 if it holds nothing yet. A new slot is
+ * 		stored here when the grant is made.
+ * @param claim Most the process may ever hold.
+ * @param req Units asked for, must fit in avail.
+ * @param avail Units free before the grant.
+ * @return HDS_OK if granted, HDS_ERR_UNSAFE if refused or HDS_ERR_NO_MEM.
+ */
+int hds_banker_grant(struct hds_banker_t *b, int *slot,
+		const hds_resvec_t *claim, const hds_resvec_t *req,
+		const hds_resvec_t *avail) {
+	struct hds_banker_holder_t *h = NULL;
+	hds_resvec_t left = *avail - *req, need;
+	struct timespec start, end;
+	unsigned long int ns;
+	bool safe, added = false;
+
+	if (*slot < 0) {
+		if ((*slot = new_slot(b)) < 0) {
+			return HDS_ERR_NO_MEM;
+		}
+		b->holder[*slot].claim = *claim;
+		added = true;
+	}
+	h = &b->holder[*slot];
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	h->alloc += *req;
+	need = h->claim - h->alloc;
+	if (hds_resvec_fits(&need, &left)) {
+		// it finishes first, then every other holder as before
+		move_to_front(b, *slot);
+		safe = true;
+	} else if (ahead_can_finish(b, h->pos, &left)) {
+		safe = true;
+	} else {
+		b->full_checks++;
+		safe = is_safe(b, &left);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	ns = (end.tv_sec - start.tv_sec) * 1000000000UL + end.tv_nsec
+			- start.tv_nsec;
+	b->checks++;
+	b->check_ns += ns;
+	if (ns > b->check_ns_max) {
+		b->check_ns_max = ns;
+	}
+	if (safe) {
+		return HDS_OK;
+	}
+	b->refusals++;
+	h->alloc -= *req;
+	if (added) {
+		hds_banker_release(b, *slot);
+		*slot = -1;
+	}
+	return HDS_ERR_UNSAFE;
+}
+/**
+ * @brief A process has given back everything it held; forget it. The
+ * 		holders after it move up, in the same order.
+ */
+void hds_banker_release(struct hds_banker_t *b, int slot) {
+	int i;
+	b->count--;
+	for (i = b->holder[slot].pos; i < b->count; i++) {
+		b->live[i] = b->live[i + 1];
+		b->holder[b->live[i]].pos = i;
+	}
+	b->live[b->count] = slot;
+	b->holder[slot].pos = b->count;
+}
+/**
+ * @brief Check the holders ahead of pos in the safe sequence, each on what
+ * 		is free once those before it have finished.
+ * @param avail Units free after the grant.
+ * @return true if each of them can still finish.
+ */
+static bool ahead_can_finish(struct hds_banker_t *b, int pos,
+		const hds_resvec_t *avail) {
+	struct hds_banker_holder_t *h = NULL;
+	hds_resvec_t work = *avail, need;
+	int i;
+	for (i = 0; i < pos; i++) {
+		h = &b->holder[b->live[i]];
+		need = h->claim - h->alloc;
+		if (!hds_resvec_fits(&need, &work)) {
+			b->holders_checked += i + 1;
+			return false;
+		}
+		work += h->alloc;
+	}
+	b->holders_checked += pos;
+	return true;
+}
+/**
+ * @brief Make slot the first of the safe sequence.
+ */
+static void move_to_front(struct hds_banker_t *b, int slot) {
+	int i;
+	for (i = b->holder[slot].pos; i > 0; i--) {
+		b->live[i] = b->live[i - 1];
+		b->holder[b->live[i]].pos = i;
+	}
+	b->live[0] = slot;
+	b->holder[slot].pos = 0;
+}
+/**
+ * @brief Full safety check: finish holders one by one, each time one whose
+ * 		remaining claim fits in what is free, and give back what it holds.
+ * 		If all of them can, the order they finished in becomes the safe
+ * 		sequence.
+ * @param avail Units free.
+ * @return true if every holder can finish.
+ */
+static bool is_safe(struct hds_banker_t *b, const hds_resvec_t *avail) {
+	struct hds_banker_holder_t *h = NULL;
+	hds_resvec_t work = *avail, need;
+	int i, left = b->count;
+	bool progress = true;
+
+	memset(b->done, 0, b->count * sizeof(bool));
+	while (left > 0 && progress) {
+		progress = false;
+		for (i = 0; i < b->count; i++) {
+			if (b->done[i]) {
+				continue;
+			}
+			h = &b->holder[b->live[i]];
+			need = h->claim - h->alloc;
+			if (hds_resvec_fits(&need, &work)) {
+				work += h->alloc;
+				b->done[i] = true;
+				b->order[b->count - left] = b->live[i];
+				left--;
+				progress = true;
+			}
+		}
+	}
+	if (left > 0) {
+		return false;
+	}
+	for (i = 0; i < b->count; i++) {
+		b->live[i] = b->order[i];
+		b->holder[b->live[i]].pos = i;
+	}
+	return true;
+}
+/**
+ * @brief Take a free slot, growing the table if there is none.
+ * @return The slot or -1 if the table could not grow.
+ */
+static int new_slot(struct hds_banker_t *b) {
+	int slot;
+	if (b->count == b->capacity && grow(b) != HDS_OK) {
+		return -1;
+	}
+	// last in the safe sequence: it holds nothing, it can finish after all
+	slot = b->live[b->count++];
+	hds_resvec_fill(&b->holder[slot].alloc, 0);
+	return slot;
+}
+static int grow(struct hds_banker_t *b) {
+	int capacity = b->capacity ? 2 * b->capacity : HDS_BANKER_INITIAL_HOLDERS;
+	struct hds_banker_holder_t *holder = NULL;
+	int *live = NULL, *order = NULL, i;
+	bool *done = NULL;
+
+	holder = (struct hds_banker_holder_t *) realloc(b->holder,
+			capacity * sizeof(struct hds_banker_holder_t));
+	if (!holder) {
+		return HDS_ERR_NO_MEM;
+	}
+	b->holder = holder;
+	live = (int *) realloc(b->live, capacity * sizeof(int));
+	if (!live) {
+		return HDS_ERR_NO_MEM;
+	}
+	b->live = live;
+	done = (bool *) realloc(b->done, capacity * sizeof(bool));
+	if (!done) {
+		return HDS_ERR_NO_MEM;
+	}
+	b->done = done;
+	order = (int *) realloc(b->order, capacity * sizeof(int));
+	if (!order) {
+		return HDS_ERR_NO_MEM;
+	}
+	b->order = order;
+	for (i = b->capacity; i < capacity; i++) {
+		b->live[i] = i;
+		b->holder[i].pos = i;
+	}
+	b->capacity = capacity;
+	return HDS_OK;
+}
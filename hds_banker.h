@@ -0,0 +1,60 @@
+/**
+ * @file hds_banker.h
+ * @brief header file for hds_banker.c
+ */
+#ifndef HDS_BANKER_H_
+#define HDS_BANKER_H_
+
+#include "hds_common.h"
+#include "hds_resource.h"
+
+/**
+ * @def HDS_BANKER_INITIAL_HOLDERS
+ * @brief Holders the table has room for before it has to grow.
+ */
+#define HDS_BANKER_INITIAL_HOLDERS 64
+
+/**
+ * @struct hds_banker_holder_t
+ * @brief A process holding resources: what it declared it may ever hold and
+ * 		what it holds now.
+ */
+struct hds_banker_holder_t {
+	hds_resvec_t claim; /**< Declared maximum claim: what the process asked for */
+	hds_resvec_t alloc; /**< Units it holds */
+	int pos; /**< Index of this slot in live */
+};
+/**
+ * @struct hds_banker_t
+ * @brief Claims and allocations of every process which holds resources.
+ * 		Processes which hold nothing need not be tracked: their claim fits
+ * 		in the total, so they can always finish after every holder has.
+ * 		The slots in use are kept in an order in which every holder can
+ * 		finish, the last safe sequence found.
+ * 		Not locked here: callers hold avail_resource_mutex.
+ */
+struct hds_banker_t {
+	struct hds_banker_holder_t *holder; /**< Slots, a process keeps its slot */
+	int *live; /**< Every slot, the count in use first in safe order */
+	bool *done; /**< Scratch of the full check, one per live slot */
+	int *order; /**< Scratch of the full check, slots as they finish */
+	int capacity; /**< No. of slots */
+	int count; /**< No. of slots in use */
+
+	unsigned long int checks; /**< Grants which were checked */
+	unsigned long int holders_checked; /**< Holders ahead of the requester
+		looked at by checks which kept the safe sequence */
+	unsigned long int full_checks; /**< Checks which had to look for a new
+		safe sequence, every refusal among them */
+	unsigned long int refusals; /**< Grants refused as unsafe */
+	unsigned long int check_ns; /**< Wall time spent checking */
+	unsigned long int check_ns_max; /**< Longest single check */
+};
+
+// --------routines-----------
+int hds_banker_init(struct hds_banker_t *b);
+int hds_banker_grant(struct hds_banker_t *b, int *slot,
+		const hds_resvec_t *claim, const hds_resvec_t *req,
+		const hds_resvec_t *avail);
+void hds_banker_release(struct hds_banker_t *b, int slot);
+#endif /* HDS_BANKER_H_ */
@@ -0,0 +1,289 @@
+/**
+ * @file hds_batch.c
+ * @brief Headless batch mode. Loads hds.conf, runs the workload to completion
+ * 		  without curses and writes per-job and aggregate results as CSV or
+ * 		  JSON. Only the core is used here so hds can be scripted for
+ * 		  parameter sweeps and compared against other schedulers.
+ */
+#include "hds_batch.h"
+//=========== routines declaration============
+static void print_usage(const char *progname);
+static void batch_signal_handler(int sig);
+static int run_realtime_threads();
+//===========================================
+static struct option batch_options[] = {
+	{ "batch", no_argument, NULL, 'b' },
+	{ "output", required_argument, NULL, 'o' },
+	{ "format", required_argument, NULL, 'f' },
+	{ "engine", required_argument, NULL, 'e' },
+	{ "trace", required_argument, NULL, 't' },
+	{ "convert", required_argument, NULL, 'c' },
+	{ "seed", required_argument, NULL, 's' },
+	{ "dump", required_argument, NULL, 'd' },
+	{ "cpus", required_argument, NULL, 'n' },
+	{ "policy", required_argument, NULL, 'p' },
+	{ "help", no_argument, NULL, 'h' },
+	{ NULL, 0, NULL, 0 }
+};
+/**
+ * @brief Check whether hds has been asked to run without the UI.
+ * @param argc No. of parameters passed to this program
+ * @param argv A pointer to list of parameters
+ * @return true if -b or --batch is present
+ */
+bool hds_batch_requested(int argc, char *argv[]) {
+	int i;
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-b") == 0 || strcmp(argv[i], "--batch") == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+/**
+ * @brief Entry point for batch mode.
+ * @param argc No. of parameters passed to this program
+ * @param argv A pointer to list of parameters
+ * @return EXIT_SUCCESS if the workload was run and results written else
+ * 		EXIT_FAILURE.
+ */
+int hds_batch_main(int argc, char *argv[]) {
+	const char *output = "-", *trace = NULL, *convert = NULL, *dump = NULL;
+	hds_report_format_t format = HDS_REPORT_CSV;
+	int engine = -1, cpus = 0, policy = -1, opt, rc = HDS_OK;
+	bool seed_given = false;
+	unsigned long int seed = 0;
+	char *end_ptr = NULL;
+	struct timespec start, end;
+	struct sigaction sa;
+
+	while ((opt = getopt_long(argc, argv, "bo:f:e:t:c:s:d:n:p:h", batch_options, NULL ))
+			!= -1) {
+		switch (opt) {
+		case 'b':
+			break;
+		case 'o':
+			output = optarg;
+			break;
+		case 'f':
+			if (strcmp(optarg, "csv") == 0) {
+				format = HDS_REPORT_CSV;
+			} else if (strcmp(optarg, "json") == 0) {
+				format = HDS_REPORT_JSON;
+			} else {
+				fprintf(stderr, "Unknown format '%s'\n", optarg);
+				print_usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'e':
+			if (strcmp(optarg, "event") == 0) {
+				engine = HDS_ENGINE_EVENT;
+			} else if (strcmp(optarg, "realtime") == 0) {
+				engine = HDS_ENGINE_REALTIME;
+			} else {
+				fprintf(stderr, "Unknown engine '%s'\n", optarg);
+				print_usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 't':
+			trace = optarg;
+			break;
+		case 'c':
+			convert = optarg;
+			break;
+		case 's':
+			errno = 0;
+			seed = strtoul(optarg, &end_ptr, 10);
+			if (errno != 0 || end_ptr == optarg || *end_ptr != '\0') {
+				fprintf(stderr, "Invalid seed '%s'\n", optarg);
+				print_usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			seed_given = true;
+			break;
+		case 'd':
+			dump = optarg;
+			break;
+		case 'n':
+			cpus = strtol(optarg, &end_ptr, 10);
+			if (end_ptr == optarg || *end_ptr != '\0' || cpus < 1
+					|| cpus > HDS_MAX_CPUS) {
+				fprintf(stderr, "Invalid no. of cpus '%s', 1 to %d\n", optarg,
+						HDS_MAX_CPUS);
+				print_usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'p':
+			policy = hds_policy_lookup(optarg);
+			if (policy == -1) {
+				fprintf(stderr, "Unknown policy '%s'\n", optarg);
+				print_usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'h':
+			print_usage(argv[0]);
+			return EXIT_SUCCESS;
+		default:
+			print_usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = batch_signal_handler;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGINT, &sa, NULL );
+	sigaction(SIGTERM, &sa, NULL );
+
+	if (init_hds_state() != HDS_OK) {
+		fprintf(stderr, "hds_state_init: failed. Aborting\n");
+		return EXIT_FAILURE;
+	}
+	hds_state.headless = true;
+	if (load_config() == HDS_ERR_CONFIG_ABORT) {
+		return EXIT_FAILURE;
+	}
+	if (engine != -1) {
+		hds_config.engine = engine;
+	}
+	if (cpus > 0) {
+		hds_config.cpus = cpus;
+	}
+	if (policy != -1) {
+		hds_config.policy = policy;
+	}
+	if (trace) {
+		snprintf(hds_config.trace_file, sizeof(hds_config.trace_file), "%s",
+				trace);
+	}
+	if (seed_given == true) {
+		// a seed alone is enough to run a generated workload
+		hds_config.generator.seed = seed;
+		hds_config.generator.enabled = true;
+	}
+	if (open_log_file() != HDS_OK) {
+		return EXIT_FAILURE;
+	}
+	if (convert) {
+		//write the workload as a binary job file instead of running it
+		rc = hds_source_convert(convert);
+		cleanup_process_dispatch_list();
+		fclose(hds_state.log_ptr);
+		return rc == HDS_OK ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+	if (dump) {
+		//write the workload as a CSV trace instead of running it
+		rc = hds_source_dump(dump);
+		cleanup_process_dispatch_list();
+		fclose(hds_state.log_ptr);
+		return rc == HDS_OK ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+	if (hds_report_open(output, format) != HDS_OK) {
+		fclose(hds_state.log_ptr);
+		return EXIT_FAILURE;
+	}
+	init_hds_resource_state();
+	init_hds_core_state();
+
+	sdebug("batch: Running workload");
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	if (hds_config.engine == HDS_ENGINE_EVENT) {
+		rc = hds_sim_run();
+	} else {
+		rc = run_realtime_threads();
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	hds_report_close(
+			(end.tv_sec - start.tv_sec) * 1000000000L
+					+ (end.tv_nsec - start.tv_nsec));
+	sdebug("batch: Done");
+	fclose(hds_state.log_ptr);
+	return rc == HDS_OK ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+static void print_usage(const char *progname) {
+	fprintf(stderr,
+			"Usage: %s -b [-o FILE] [-f csv|json] [-e event|realtime] [-t TRACE]\n"
+			"       %s -b --convert FILE|--dump FILE [-t TRACE] [-s SEED]\n"
+			"  -b, --batch          run without UI and write results\n"
+			"  -o, --output FILE    write results to FILE (default: stdout)\n"
+			"  -f, --format FMT     csv or json (default: csv)\n"
+			"  -e, --engine ENGINE  override engine from hds.conf\n"
+			"  -t, --trace FILE     stream jobs from FILE (CSV or binary job file)\n"
+			"  -s, --seed N         generate the workload with seed N\n"
+			"  -n, --cpus N         override no. of cpus from hds.conf\n"
+			"  -p, --policy NAME    feedback, mlfq, srtf, lottery or cfs\n"
+			"  -c, --convert FILE   write workload as a binary job file and exit\n"
+			"  -d, --dump FILE      write workload as a CSV trace and exit\n"
+			"  -h, --help           show this help\n", progname, progname);
+}
+static void batch_signal_handler(int sig) {
+	if (hds_state.parent_pid != getpid()) {
+		//forked child of the cpu thread is being killed
+		_exit(EXIT_SUCCESS);
+	}
+	hds_state.recieved_signal_code = sig;
+	hds_state.shutdown_in_progress = true;
+}
+/**
+ * @brief Run dispatcher, scheduler and cpu threads until every process has
+ * 		left the system, then stop them.
+ * @return HDS_OK on success else HDS_ERR_THREAD_INIT.
+ */
+static int run_realtime_threads() {
+	unsigned long int rows = 0;
+	int idle = 0;
+
+	if (pthread_create(&hds_state.hds_dispatcher, NULL, hds_dispatcher, NULL )
+			!= 0) {
+		serror("batch: Failed to create dispatcher thread");
+		return HDS_ERR_THREAD_INIT;
+	}
+	if (pthread_create(&hds_state.hds_scheduler, NULL, hds_scheduler, NULL )
+			!= 0) {
+		serror("batch: Failed to create scheduler thread");
+		hds_state.shutdown_in_progress = true;
+		pthread_join(hds_state.hds_dispatcher, NULL );
+		return HDS_ERR_THREAD_INIT;
+	}
+	if (hds_cpus_start() != HDS_OK) {
+		serror("batch: Failed to create cpu threads");
+		hds_state.shutdown_in_progress = true;
+		hds_core_wake_all();
+		pthread_join(hds_state.hds_dispatcher, NULL );
+		pthread_join(hds_state.hds_scheduler, NULL );
+		hds_cpus_join();
+		return HDS_ERR_THREAD_INIT;
+	}
+
+	while (hds_state.shutdown_in_progress == false
+			&& hds_core_workload_done() == false) {
+		sleep(1);
+		// every process has arrived, cpu idle and nothing has left the
+		// system for a while: the rest can not be admitted
+		if (hds_config.job_dispatch_list == NULL
+				&& hds_heap_empty(&hds_core_state.arrival_q)
+				&& hds_source_done()
+				&& hds_core_cpus_idle()
+				&& hds_report.rows == rows) {
+			if (++idle >= HDS_BATCH_STALL_TIMEOUT) {
+				serror("batch: Remaining processes can not be admitted");
+				break;
+			}
+		} else {
+			idle = 0;
+		}
+		rows = hds_report.rows;
+	}
+	hds_state.shutdown_in_progress = true;
+	hds_core_wake_all();
+
+	pthread_join(hds_state.hds_dispatcher, NULL );
+	pthread_join(hds_state.hds_scheduler, NULL );
+	hds_cpus_join();
+	return HDS_OK;
+}
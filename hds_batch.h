@@ -0,0 +1,27 @@
+/**
+ * @file hds_batch.h
+ * @brief header file for hds_batch.c
+ */
+#ifndef HDS_BATCH_H_
+#define HDS_BATCH_H_
+
+#include "hds_common.h"
+#include "hds_config.h"
+#include "hds_core.h"
+#include "hds_sim.h"
+#include "hds_report.h"
+#include <getopt.h>
+
+/**
+ * @def HDS_BATCH_STALL_TIMEOUT
+ * @brief With the realtime engine, a run is given up if the cpu stays idle and
+ * 		no process leaves the system for these many seconds after the last
+ * 		process was dispatched. Processes which can never be admitted would
+ * 		otherwise keep a batch run waiting forever.
+ */
+#define HDS_BATCH_STALL_TIMEOUT 10
+
+// --------routines-----------
+bool hds_batch_requested(int argc, char *argv[]);
+int hds_batch_main(int argc, char *argv[]);
+#endif /* HDS_BATCH_H_ */
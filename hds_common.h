@@ -13,7 +13,6 @@
 #include<execinfo.h>
 #include<stdlib.h>
 #include <pthread.h>
-#include<curses.h>
 #include<signal.h>
 #include <stdarg.h>
 #include <sys/types.h>
@@ -30,11 +29,7 @@
 
 #include "hds_config.h"
 #include "hds_error.h"
-#include "cdk_wrap.h"
 
-#ifdef HAVE_XCURSES
-char *XCursesProgramName = "HOST";
-#endif
 #ifndef __USE_GNU
 #define __USE_GNU
 #endif
@@ -50,16 +45,6 @@ char *XCursesProgramName = "HOST";
  */
 #define LOG_BUFF_SIZE 512
 #define HDS_PAGE_SIZE 4096
-/**
- * @struct window_state_t
- * @brief A structure for holding window related information.
- */
-struct window_state_t {
-	WINDOW *wptr;
-	int beg_x, beg_y, height, width; //window coordinates
-	int cur_x, cur_y;
-	CDKSCREEN *cdksptr;
-};
 /**
  * @enum storage_loc_t
  * @brief Tells about current location of a given page.
@@ -76,25 +61,15 @@ typedef enum {
  * variables in this structure are accessible throughout hds.
  */
 struct HDS_STATE {
-	struct window_state_t output_win, input_win, console_win;
-	// ----------global labels------------------------
-	bool color_ok;
 	char log_buffer[LOG_BUFF_SIZE];
-	char result_msg[LOG_BUFF_SIZE];
-
-	bool curses_ready;
-	bool gui_ready;
-	int hori_pad, vert_pad;
-
-	//cdk specific window pointers
-	CDK_PARAMS params;
-	CDKSWINDOW *console;
-	CDKSWINDOW *output_screen;
-	CDKSCREEN *master_screen;
-	WINDOW *cursesWin; //main curses window--stdscr
-	CDKENTRY *read_input;
 	// mutex for getting lock if log_buffer
 	pthread_mutex_t log_buffer_lock;
+	/*
+	 * A frontend which displays log messages itself (the curses UI) sets this.
+	 * Messages are always written to the log file first.
+	 */
+	void (*log_sink)(const char *msg, log_level_t log_level);
+	bool headless; /**< Running without any UI, see hds_batch.c */
 	bool shutdown_in_progress;
 	bool shutdown_completed;
 	int recieved_signal_code;
@@ -102,18 +77,12 @@ struct HDS_STATE {
 
 	pthread_t hds_dispatcher;
 	pthread_t hds_scheduler;
-	pthread_t hds_cpu;
 	pthread_t hds_stats_manager;
+	pthread_t hds_sim_engine;
 	pid_t parent_pid;
 	bool stats_manager_active;
 } hds_state;
 
-#define sprint_result(s) snprintf(hds_state.result_msg, LOG_BUFF_SIZE,s );\
-		write_to_result_window(hds_state.result_msg,1);
-
-#define vprint_result(s,...) snprintf(hds_state.result_msg, LOG_BUFF_SIZE,s,__VA_ARGS__ );\
-		write_to_result_window(hds_state.result_msg,1);
-
 //some debug,warning and error macros
 /**
  * @def sdebug(s)
@@ -196,16 +165,7 @@ struct HDS_STATE {
 int init_hds_state();
 void log_generic(const char* msg, log_level_t log_level);
 void report_error(error_codes_t error_code); //report errors which are fatal
-void close_ui();
-void destroy_win(WINDOW *local_win);
-void set_focus_to_console();
-void destroy_cdkscreens();
-void display_help();
 long int gettime_in_nsecs();
 int open_log_file();
-void write_to_result_window(const char* msg,int num_rows);
-void print_help();
-void execute_commands(const char *command);
-void clear_result_window();
 
 #endif
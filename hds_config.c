@@ -5,9 +5,18 @@
  * accessible.
  */
 #include "hds_config.h"
+#include "hds_policy.h"
+#include "hds_admit.h"
+#include "hds_exec.h"
+#include "hds_kernel.h"
 //-----------------------------------
 //define routine before using them
 static void print_loaded_configs();
+static void load_priority_array(config_t *cfg, const char *name, int *dst);
+static void init_generator_config();
+static int load_generator_config(config_setting_t *gen);
+static int load_max_resources(config_setting_t *max_res);
+static bool load_process_req(config_setting_t *proc, hds_resvec_t *req);
 //-----------------------------------
 /**
  * @brief Initialise hds_config structure with default values
@@ -16,10 +25,304 @@ static void init_hds_config() {
 	strcpy(hds_config.log_filename, "hds_output.log");
 	hds_config.job_dispatch_list = NULL;
 	hds_config.job_dispatch_list_last_ele = NULL;
+	hds_config.job_id_counter = 0;
 
-	hds_config.max_resources.memory = 0;
-	hds_config.max_resources.printer = 0;
-	hds_config.max_resources.scanner = 0;
+	memset(&hds_config.max_resources, 0, sizeof(hds_config.max_resources));
+	hds_config.max_resources.kinds = HDS_RES_BUILTIN;
+	strcpy(hds_config.max_resources.name[HDS_RES_MEMORY], "memory");
+	strcpy(hds_config.max_resources.name[HDS_RES_PRINTER], "printer");
+	strcpy(hds_config.max_resources.name[HDS_RES_SCANNER], "scanner");
+	hds_config.engine = HDS_ENGINE_EVENT;
+	hds_config.cpus = 1;
+	hds_config.policy = HDS_POLICY_FEEDBACK;
+	hds_config.mlfq_quanta[0] = 1;
+	hds_config.mlfq_quanta[1] = 2;
+	hds_config.mlfq_quanta[2] = 4;
+	hds_config.policy_weights[0] = 4;
+	hds_config.policy_weights[1] = 2;
+	hds_config.policy_weights[2] = 1;
+	hds_config.aging_interval = 0;
+	hds_config.acquisition = HDS_ACQUIRE_UPFRONT;
+	hds_config.deadlock_avoidance = HDS_AVOID_NONE;
+	hds_config.admission_kernel = HDS_ADMIT_AUTO;
+	hds_config.submit_ring_size = 0;
+	hds_config.worker_pool = HDS_WORKER_POOL;
+	hds_config.exec_backend = HDS_EXEC_PROCESS;
+	hds_config.cpu_accounting = HDS_ACCOUNT_WALL;
+	hds_config.trace_file[0] = '\0';
+	hds_config.trace_lookahead = HDS_TRACE_LOOKAHEAD;
+	init_generator_config();
+}
+/**
+ * @brief Read max_resources. memory, printer and scanner must be there; any
+ * 		other integer member adds a kind of resource, in the order given.
+ * @return HDS_OK or HDS_ERR_NO_SUCH_ELEMENT.
+ */
+static int load_max_resources(config_setting_t *max_res) {
+	struct max_resources_t *m = &hds_config.max_resources;
+	config_setting_t *elem = NULL;
+	const char *name = NULL;
+	int i, k, count, units;
+
+	for (k = 0; k < HDS_RES_BUILTIN; k++) {
+		if (!config_setting_lookup_int(max_res, m->name[k], &units)) {
+			return HDS_ERR_NO_SUCH_ELEMENT;
+		}
+		m->units[k] = units;
+	}
+	count = config_setting_length(max_res);
+	for (i = 0; i < count; i++) {
+		elem = config_setting_get_elem(max_res, i);
+		name = config_setting_name(elem);
+		if (config_setting_type(elem) != CONFIG_TYPE_INT || !name) {
+			continue;
+		}
+		for (k = 0; k < m->kinds && strcmp(m->name[k], name) != 0; k++)
+			;
+		if (k < m->kinds) {
+			continue;
+		}
+		if (m->kinds == HDS_MAX_RESOURCES
+				|| strlen(name) + 1 > HDS_RES_NAME_LEN) {
+			fprintf(stderr,
+					"\nError: max_resources: can not add '%s', at most %d kinds of %d characters! Ignoring it",
+					name, HDS_MAX_RESOURCES, HDS_RES_NAME_LEN - 1);
+			continue;
+		}
+		strcpy(m->name[m->kinds], name);
+		m->units[m->kinds] = config_setting_get_int(elem);
+		m->kinds++;
+	}
+	return HDS_OK;
+}
+/**
+ * @brief Read what a process_list entry needs: memory_req, printer_req and
+ * 		scanner_req must be there, '<name>_req' of a kind added in
+ * 		max_resources is 0 when left out.
+ * @return false if a required field is missing.
+ */
+static bool load_process_req(config_setting_t *proc, hds_resvec_t *req) {
+	char field[HDS_RES_NAME_LEN + 4];
+	int k, units;
+
+	hds_resvec_fill(req, 0);
+	for (k = 0; k < hds_config.max_resources.kinds; k++) {
+		snprintf(field, sizeof(field), "%s_req",
+				hds_config.max_resources.name[k]);
+		if (config_setting_lookup_int(proc, field, &units)) {
+			(*req)[k] = units;
+		} else if (k < HDS_RES_BUILTIN) {
+			return false;
+		}
+	}
+	return true;
+}
+/**
+ * @brief Defaults of the workload generator, used for whatever the
+ * 		'generator' group leaves out.
+ */
+static void init_generator_config() {
+	struct hds_generator_config_t *gen = &hds_config.generator;
+	memset(gen, 0, sizeof(struct hds_generator_config_t));
+	gen->seed = 1;
+	gen->jobs = 1000;
+	gen->arrival = HDS_GEN_POISSON;
+	gen->rate = 0.5;
+	gen->burst_size = 8;
+	gen->cpu = HDS_GEN_EXPONENTIAL;
+	gen->cpu_mean = 4;
+	gen->pareto_alpha = 1.5;
+	gen->cpu_max = 1000;
+	gen->memory_mix_len = 3;
+	gen->memory_sizes[0] = 4;
+	gen->memory_weights[0] = 5;
+	gen->memory_sizes[1] = 16;
+	gen->memory_weights[1] = 3;
+	gen->memory_sizes[2] = 64;
+	gen->memory_weights[2] = 2;
+	gen->priority_ratio[0] = 1;
+	gen->priority_ratio[1] = 3;
+	gen->priority_ratio[2] = 3;
+	gen->priority_ratio[3] = 3;
+	gen->kernel_ratio[HDS_KERNEL_SLEEP] = 1;
+}
+/**
+ * @brief Read the 'generator' group of config file. Fields which are missing
+ * 		keep their defaults.
+ * @param gen The group setting.
+ * @return HDS_OK if settings are usable else HDS_ERR_CONFIG_ABORT.
+ */
+static int load_generator_config(config_setting_t *gen) {
+	struct hds_generator_config_t *g = &hds_config.generator;
+	config_setting_t *list, *elem;
+	const char *s_val = NULL;
+	int i_val, i, count;
+	long long l_val;
+	double d_val, total;
+
+	if (config_setting_lookup_int64(gen, "seed", &l_val)) {
+		g->seed = (unsigned long int) l_val;
+	}
+	if (config_setting_lookup_int(gen, "jobs", &i_val)) {
+		if (i_val < 0) {
+			fprintf(stderr, "\nError: generator: jobs can not be negative!");
+			return HDS_ERR_CONFIG_ABORT;
+		}
+		g->jobs = i_val;
+	}
+	if (config_setting_lookup_string(gen, "arrival", &s_val)) {
+		if (strcmp(s_val, "poisson") == 0) {
+			g->arrival = HDS_GEN_POISSON;
+		} else if (strcmp(s_val, "bursty") == 0) {
+			g->arrival = HDS_GEN_BURSTY;
+		} else {
+			fprintf(stderr, "\nError: generator: Unknown arrival '%s'!",
+					s_val);
+			return HDS_ERR_CONFIG_ABORT;
+		}
+	}
+	if (config_setting_lookup_float(gen, "rate", &d_val)) {
+		g->rate = d_val;
+	}
+	if (config_setting_lookup_float(gen, "burst_size", &d_val)) {
+		g->burst_size = d_val;
+	}
+	if (config_setting_lookup_string(gen, "cpu", &s_val)) {
+		if (strcmp(s_val, "exponential") == 0) {
+			g->cpu = HDS_GEN_EXPONENTIAL;
+		} else if (strcmp(s_val, "pareto") == 0) {
+			g->cpu = HDS_GEN_PARETO;
+		} else {
+			fprintf(stderr, "\nError: generator: Unknown cpu '%s'!", s_val);
+			return HDS_ERR_CONFIG_ABORT;
+		}
+	}
+	if (config_setting_lookup_float(gen, "cpu_mean", &d_val)) {
+		g->cpu_mean = d_val;
+	}
+	if (config_setting_lookup_float(gen, "pareto_alpha", &d_val)) {
+		g->pareto_alpha = d_val;
+	}
+	if (config_setting_lookup_int(gen, "cpu_max", &i_val)) {
+		g->cpu_max = i_val;
+	}
+	if (g->rate <= 0 || g->burst_size < 1 || g->cpu_mean < 1
+			|| g->pareto_alpha <= 1 || g->cpu_max < 1) {
+		fprintf(stderr,
+				"\nError: generator: rate and cpu_max must be positive,"
+				" burst_size and cpu_mean at least 1, pareto_alpha above 1!");
+		return HDS_ERR_CONFIG_ABORT;
+	}
+
+	// memory_mix = ( { size = 4; weight = 5; }, ... );
+	list = config_setting_get_member(gen, "memory_mix");
+	if (list != NULL ) {
+		count = config_setting_length(list);
+		if (count < 1 || count > HDS_GEN_MAX_MIX) {
+			fprintf(stderr,
+					"\nError: generator: memory_mix must have 1 to %d entries!",
+					HDS_GEN_MAX_MIX);
+			return HDS_ERR_CONFIG_ABORT;
+		}
+		total = 0;
+		for (i = 0; i < count; i++) {
+			elem = config_setting_get_elem(list, i);
+			if (!(config_setting_lookup_int(elem, "size", &g->memory_sizes[i])
+					&& config_setting_lookup_float(elem, "weight",
+							&g->memory_weights[i])) || g->memory_sizes[i] < 0
+					|| g->memory_weights[i] < 0) {
+				fprintf(stderr,
+						"\nError: generator: memory_mix entry %d needs a size and a weight!",
+						i + 1);
+				return HDS_ERR_CONFIG_ABORT;
+			}
+			total += g->memory_weights[i];
+		}
+		if (total <= 0) {
+			fprintf(stderr, "\nError: generator: memory_mix weights are all 0!");
+			return HDS_ERR_CONFIG_ABORT;
+		}
+		g->memory_mix_len = count;
+	}
+
+	// priority_ratio = [ 1, 3, 3, 3 ];
+	list = config_setting_get_member(gen, "priority_ratio");
+	if (list != NULL ) {
+		if (config_setting_length(list) != 4) {
+			fprintf(stderr,
+					"\nError: generator: priority_ratio needs 4 weights!");
+			return HDS_ERR_CONFIG_ABORT;
+		}
+		total = 0;
+		for (i = 0; i < 4; i++) {
+			g->priority_ratio[i] = config_setting_get_float_elem(list, i);
+			if (g->priority_ratio[i] < 0) {
+				fprintf(stderr,
+						"\nError: generator: priority_ratio can not be negative!");
+				return HDS_ERR_CONFIG_ABORT;
+			}
+			total += g->priority_ratio[i];
+		}
+		if (total <= 0) {
+			fprintf(stderr,
+					"\nError: generator: priority_ratio weights are all 0!");
+			return HDS_ERR_CONFIG_ABORT;
+		}
+	}
+
+	// kernel_ratio = [ 1, 0, 0, 0, 0 ]; sleep, simd, stream, chase, io
+	list = config_setting_get_member(gen, "kernel_ratio");
+	if (list != NULL ) {
+		if (config_setting_length(list) != HDS_KERNELS) {
+			fprintf(stderr,
+					"\nError: generator: kernel_ratio needs %d weights!",
+					HDS_KERNELS);
+			return HDS_ERR_CONFIG_ABORT;
+		}
+		total = 0;
+		for (i = 0; i < HDS_KERNELS; i++) {
+			g->kernel_ratio[i] = config_setting_get_float_elem(list, i);
+			if (g->kernel_ratio[i] < 0) {
+				fprintf(stderr,
+						"\nError: generator: kernel_ratio can not be negative!");
+				return HDS_ERR_CONFIG_ABORT;
+			}
+			total += g->kernel_ratio[i];
+		}
+		if (total <= 0) {
+			fprintf(stderr,
+					"\nError: generator: kernel_ratio weights are all 0!");
+			return HDS_ERR_CONFIG_ABORT;
+		}
+		g->kernel_mix = true;
+	}
+	g->enabled = true;
+	return HDS_OK;
+}
+/**
+ * @brief Read an array of one positive integer per user priority (p1 to p3).
+ * 		The defaults in dst are kept if the array is missing or invalid.
+ */
+static void load_priority_array(config_t *cfg, const char *name, int *dst) {
+	config_setting_t *list = config_lookup(cfg, name);
+	int val[HDS_USER_PRIORITIES], i;
+	if (list == NULL ) {
+		return;
+	}
+	if (config_setting_length(list) != HDS_USER_PRIORITIES) {
+		fprintf(stderr, "\nError: %s needs %d values! Using defaults", name,
+				HDS_USER_PRIORITIES);
+		return;
+	}
+	for (i = 0; i < HDS_USER_PRIORITIES; i++) {
+		val[i] = config_setting_get_int_elem(list, i);
+		if (val[i] < 1) {
+			fprintf(stderr, "\nError: %s values must be positive! Using defaults",
+					name);
+			return;
+		}
+	}
+	memcpy(dst, val, sizeof(val));
 }
 /**
  * @brief Adds a new entry in process_config_list.
@@ -38,12 +341,13 @@ int add_new_process_config(struct hds_process_t node) {
 	tmp_node->next = NULL;
 	//assign values to tmp_node
 	tmp_node->priority = node.priority;
-	tmp_node->memory_req = node.memory_req;
-	tmp_node->scanner_req = node.scanner_req;
-	tmp_node->printer_req = node.printer_req;
+	tmp_node->req = node.req;
+	tmp_node->kernel = node.kernel;
 	tmp_node -> cpu_req = node.cpu_req;
+	tmp_node->arrival = node.arrival;
 
 	tmp_node->pid = 0;
+	tmp_node->job_id = ++hds_config.job_id_counter;
 
 	if (hds_config.job_dispatch_list == NULL ) {
 		// this is first time
@@ -78,9 +382,12 @@ void cleanup_process_dispatch_list() {
 int load_config() {
 	config_t cfg;
 	const char* s_val = NULL; // will be used to store string values
+	int i_val; // will be used to store int values
 	config_setting_t *setting;
 	config_setting_t *max_res_setting;
 	struct hds_process_t tmp_config;
+	int arrival;
+	unsigned long int next_arrival = 0;
 	tmp_config.next = NULL;
 
 	// initialize hds_config state
@@ -88,6 +395,8 @@ int load_config() {
 
 	/*Initialization */
 	config_init(&cfg);
+	// let integer values be given where a fraction is expected
+	config_set_auto_convert(&cfg, CONFIG_TRUE);
 	/* Read the file. If there is an error, report it and exit. */
 	if (!config_read_file(&cfg, HDS_CONF_FILE)) {
 		printf("\n%s:%d - %s", config_error_file(&cfg), config_error_line(&cfg),
@@ -104,15 +413,159 @@ int load_config() {
 				hds_config.log_filename);
 	}
 
+	// read which engine should drive the simulation
+	if (config_lookup_string(&cfg, "engine", &s_val)) {
+		if (strcmp(s_val, "event") == 0) {
+			hds_config.engine = HDS_ENGINE_EVENT;
+		} else if (strcmp(s_val, "realtime") == 0) {
+			hds_config.engine = HDS_ENGINE_REALTIME;
+		} else {
+			fprintf(stderr,
+					"\nError: Unknown engine '%s' in config file! Using default: event",
+					s_val);
+		}
+	}
+
+	// no. of cpus, each one has its own run queue
+	if (config_lookup_int(&cfg, "cpus", &i_val)) {
+		if (i_val >= 1 && i_val <= HDS_MAX_CPUS) {
+			hds_config.cpus = i_val;
+		} else {
+			fprintf(stderr,
+					"\nError: cpus must be between 1 and %d! Using default: %d",
+					HDS_MAX_CPUS, hds_config.cpus);
+		}
+	}
+
+	// scheduling policy and its settings
+	if (config_lookup_string(&cfg, "policy", &s_val)) {
+		if ((i_val = hds_policy_lookup(s_val)) != -1) {
+			hds_config.policy = i_val;
+		} else {
+			fprintf(stderr,
+					"\nError: Unknown policy '%s' in config file! Using default: feedback",
+					s_val);
+		}
+	}
+	load_priority_array(&cfg, "mlfq_quanta", hds_config.mlfq_quanta);
+	load_priority_array(&cfg, "policy_weights", hds_config.policy_weights);
+	// how long a user process may wait on one level before it moves up
+	if (config_lookup_int(&cfg, "aging_interval", &i_val)) {
+		if (i_val >= 0) {
+			hds_config.aging_interval = i_val;
+		} else {
+			fprintf(stderr,
+					"\nError: aging_interval can not be negative! Using default: %u",
+					hds_config.aging_interval);
+		}
+	}
+
+	// when resources are taken, and whether grants are checked for safety
+	if (config_lookup_string(&cfg, "resource_acquisition", &s_val)) {
+		if (strcmp(s_val, "upfront") == 0) {
+			hds_config.acquisition = HDS_ACQUIRE_UPFRONT;
+		} else if (strcmp(s_val, "staged") == 0) {
+			hds_config.acquisition = HDS_ACQUIRE_STAGED;
+		} else {
+			fprintf(stderr,
+					"\nError: Unknown resource_acquisition '%s' in config file! Using default: upfront",
+					s_val);
+		}
+	}
+	if (config_lookup_string(&cfg, "deadlock_avoidance", &s_val)) {
+		if (strcmp(s_val, "none") == 0) {
+			hds_config.deadlock_avoidance = HDS_AVOID_NONE;
+		} else if (strcmp(s_val, "banker") == 0) {
+			hds_config.deadlock_avoidance = HDS_AVOID_BANKER;
+		} else {
+			fprintf(stderr,
+					"\nError: Unknown deadlock_avoidance '%s' in config file! Using default: none",
+					s_val);
+		}
+	}
+
+	// how queued processes are tested against available resources
+	if (config_lookup_string(&cfg, "admission_kernel", &s_val)) {
+		if ((i_val = hds_admit_lookup(s_val)) != -1) {
+			hds_config.admission_kernel = i_val;
+		} else {
+			fprintf(stderr,
+					"\nError: Unknown admission_kernel '%s' in config file! Using default: auto",
+					s_val);
+		}
+	}
+
+	// size of the ring used for submitting processes at run time
+	if (config_lookup_int(&cfg, "submit_ring_size", &i_val)) {
+		if (i_val > 0) {
+			hds_config.submit_ring_size = i_val;
+		} else {
+			fprintf(stderr,
+					"\nError: submit_ring_size must be positive! Using default");
+		}
+	}
+
+	// what a process of the realtime engine is
+	if (config_lookup_string(&cfg, "exec_backend", &s_val)) {
+		if ((i_val = hds_exec_lookup(s_val)) != -1) {
+			hds_config.exec_backend = i_val;
+		} else {
+			fprintf(stderr,
+					"\nError: Unknown exec_backend '%s' in config file! Using default: process",
+					s_val);
+		}
+	}
+	// what a quantum of the realtime engine takes off cpu_req
+	if (config_lookup_string(&cfg, "cpu_accounting", &s_val)) {
+		if (strcmp(s_val, "wall") == 0) {
+			hds_config.cpu_accounting = HDS_ACCOUNT_WALL;
+		} else if (strcmp(s_val, "cpu") == 0) {
+			hds_config.cpu_accounting = HDS_ACCOUNT_CPU;
+		} else {
+			fprintf(stderr,
+					"\nError: Unknown cpu_accounting '%s' in config file! Using default: wall",
+					s_val);
+		}
+	}
+	// processes forked ahead of need, for the realtime engine to start
+	if (config_lookup_int(&cfg, "worker_pool", &i_val)) {
+		if (i_val >= 0 && i_val <= HDS_MAX_WORKERS) {
+			hds_config.worker_pool = i_val;
+		} else {
+			fprintf(stderr,
+					"\nError: worker_pool must be between 0 and %d! Using default: %u",
+					HDS_MAX_WORKERS, hds_config.worker_pool);
+		}
+	}
+
+	// jobs can also be streamed from a trace file
+	if (config_lookup_string(&cfg, "trace_file", &s_val)) {
+		snprintf(hds_config.trace_file, sizeof(hds_config.trace_file), "%s",
+				s_val);
+	}
+	if (config_lookup_int(&cfg, "trace_lookahead", &i_val)) {
+		if (i_val >= 0) {
+			hds_config.trace_lookahead = i_val;
+		} else {
+			fprintf(stderr,
+					"\nError: trace_lookahead can not be negative! Using default: %u",
+					hds_config.trace_lookahead);
+		}
+	}
+
+	// or generated from a seeded random distribution
+	setting = config_lookup(&cfg, "generator");
+	if (setting != NULL ) {
+		if (load_generator_config(setting) != HDS_OK) {
+			config_destroy(&cfg);
+			return HDS_ERR_CONFIG_ABORT;
+		}
+	}
+
 	// find the max resources
 	max_res_setting = config_lookup(&cfg, "max_resources");
 	if (max_res_setting != NULL ) {
-		if (!(config_setting_lookup_int(max_res_setting, "printer",
-				&hds_config.max_resources.printer)
-				&& (config_setting_lookup_int(max_res_setting, "memory",
-						&hds_config.max_resources.memory))
-				&& (config_setting_lookup_int(max_res_setting, "scanner",
-						&hds_config.max_resources.scanner)))) {
+		if (load_max_resources(max_res_setting) != HDS_OK) {
 			fprintf(stderr,
 					"Error: Failed to determine max. resource limit from config file!");
 			return HDS_ERR_NO_SUCH_ELEMENT;
@@ -134,16 +587,41 @@ int load_config() {
 			/* Only output the record if all of the expected fields are present. */
 			if (!(config_setting_lookup_int(process_config_from_file, "priority",
 					&tmp_config.priority)
-					&& config_setting_lookup_int(process_config_from_file,
-							"memory_req", &tmp_config.memory_req)
-					&& config_setting_lookup_int(process_config_from_file,
-							"printer_req", &tmp_config.printer_req)
-					&& config_setting_lookup_int(process_config_from_file,
-							"scanner_req", &tmp_config.scanner_req)
+					&& load_process_req(process_config_from_file,
+							&tmp_config.req)
 					&& config_setting_lookup_int(process_config_from_file,
 							"cpu_req", &tmp_config.cpu_req)))
 				continue;
 
+			// arrival is optional, by default a process arrives one quantum
+			// after the one before it
+			if (config_setting_lookup_int(process_config_from_file, "arrival",
+					&arrival)) {
+				if (arrival < 0) {
+					fprintf(stderr,
+							"\nError: Negative arrival for process %d in config file! Skipping it",
+							i + 1);
+					continue;
+				}
+				tmp_config.arrival = arrival;
+			} else {
+				tmp_config.arrival = next_arrival;
+			}
+			next_arrival = tmp_config.arrival + SMALLEST_TIME_QUANTUM;
+
+			// kernel is optional too, by default a process sleeps
+			tmp_config.kernel = HDS_KERNEL_SLEEP;
+			if (config_setting_lookup_string(process_config_from_file,
+					"kernel", &s_val)) {
+				if ((i_val = hds_kernel_lookup(s_val)) != -1) {
+					tmp_config.kernel = i_val;
+				} else {
+					fprintf(stderr,
+							"\nError: Unknown kernel '%s' for process %d in config file! Using default: sleep",
+							s_val, i + 1);
+				}
+			}
+
 			//add this to process_config_list
 			if (add_new_process_config(tmp_config) != HDS_OK) {
 				// problem in mem IO
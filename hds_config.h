@@ -19,6 +19,7 @@
 #include "libconfig.h"
 #include <stdbool.h>
 #include "hds_error.h"
+#include "hds_resource.h"
 
 #define HDS_LOG_FILE "hds_output.log"
 /*
@@ -77,35 +78,223 @@
  * @brief Turn on/off cbreak feature of curses
  */
 #define CBREAK_MODE on
+/**
+ * @def SMALLEST_TIME_QUANTUM
+ * @brief Unit of cpu time and of arrival offsets. One second on the realtime
+ * 		engine, one tick on the event engine.
+ */
+#define SMALLEST_TIME_QUANTUM 1
+/**
+ * @def HDS_TRACE_LOOKAHEAD
+ * @brief Default no. of time quanta ahead of the current time up to which
+ * 		jobs are read from a trace file.
+ */
+#define HDS_TRACE_LOOKAHEAD 16
+/**
+ * @def HDS_MAX_CPUS
+ * @brief Most cpus hds can simulate ('cpus' in hds.conf).
+ */
+#define HDS_MAX_CPUS 64
+/**
+ * @def HDS_WORKER_POOL
+ * @brief Default no. of worker processes kept parked for the realtime
+ * 		engine ('worker_pool' in hds.conf).
+ */
+#define HDS_WORKER_POOL 4
+/**
+ * @def HDS_MAX_WORKERS
+ * @brief Most worker processes which can be kept parked.
+ */
+#define HDS_MAX_WORKERS 256
 /**
  * @def HDS_CONF_FILE
  * @brief Path of Configuration file
  */
 #define HDS_CONF_FILE "hds.conf"
+/**
+ * @enum hds_kernel_t
+ * @brief What a process of the realtime engine does while it runs ('kernel'
+ * 		of a process_list entry), see hds_kernel.c.
+ */
+typedef enum {
+	HDS_KERNEL_SLEEP, /**< Sleeps, or spins with cpu_accounting "cpu" */
+	HDS_KERNEL_SIMD, /**< Vector arithmetic on a few KB, bound by the cpu */
+	HDS_KERNEL_STREAM, /**< Sweeps over its memory_req, bound by bandwidth */
+	HDS_KERNEL_CHASE, /**< Follows pointers through its memory_req at random */
+	HDS_KERNEL_IO, /**< Writes a temporary file as large as its memory_req */
+	HDS_KERNELS /**< No. of kernels. Must be last. */
+} hds_kernel_t;
+
 /**
  * @struct hds_config_t
  * @brief Structure for storing information loaded from configuration file.
  */
 struct hds_process_t{
+	unsigned int job_id; // order in which process was loaded, starts from 1
+	unsigned long int arrival; // offset from start of run, in time quanta
 	int pid; // will be populated later on
 	int priority;
 	int cpu_req;
-	int memory_req;
-	int printer_req;
-	int scanner_req;
+	hds_resvec_t req; // units of every resource kind it needs, see hds_resource.h
+	hds_kernel_t kernel; // what it does while it runs
 	struct hds_process_t *next;
 };
 
+/**
+ * @enum hds_engine_t
+ * @brief Selects what drives the simulation.
+ */
+typedef enum {
+	HDS_ENGINE_EVENT, /**< Discrete event engine running on a virtual clock */
+	HDS_ENGINE_REALTIME /**< dispatcher,scheduler and cpu threads running on wall clock */
+} hds_engine_t;
+
+/**
+ * @enum hds_acquisition_t
+ * @brief When a process takes its resources ('resource_acquisition' in
+ * 		hds.conf).
+ */
+typedef enum {
+	HDS_ACQUIRE_UPFRONT, /**< Everything before it first runs */
+	HDS_ACQUIRE_STAGED /**< Memory first, every device kind when it gets to it */
+} hds_acquisition_t;
+/**
+ * @enum hds_avoidance_t
+ * @brief Deadlock avoidance ('deadlock_avoidance' in hds.conf).
+ */
+typedef enum {
+	HDS_AVOID_NONE, /**< Resources are granted whenever they are free */
+	HDS_AVOID_BANKER /**< Only grants which leave the system safe, see hds_banker.c */
+} hds_avoidance_t;
+/**
+ * @enum hds_admit_kernel_t
+ * @brief Kernel which runs admission tests over queued processes
+ * 		('admission_kernel' in hds.conf), see hds_admit.c.
+ */
+typedef enum {
+	HDS_ADMIT_SCALAR, /**< One lane at a time, runs everywhere */
+	HDS_ADMIT_SSE2, /**< Two 128 bit compares a process */
+	HDS_ADMIT_AVX2, /**< One 256 bit compare a process */
+	HDS_ADMIT_KERNELS, /**< No. of kernels. Must be after the last one. */
+	HDS_ADMIT_AUTO = HDS_ADMIT_KERNELS /**< Best one the cpu supports */
+} hds_admit_kernel_t;
+/**
+ * @enum hds_exec_backend_t
+ * @brief How the realtime engine runs processes ('exec_backend' in
+ * 		hds.conf), see hds_exec.c.
+ */
+typedef enum {
+	HDS_EXEC_PROCESS, /**< A child process each, stopped with SIGSTOP */
+	HDS_EXEC_FIBER, /**< A fiber each inside hds, run by its cpu thread */
+	HDS_EXEC_BACKENDS /**< No. of backends. Must be last. */
+} hds_exec_backend_t;
+/**
+ * @enum hds_accounting_t
+ * @brief What a process of the realtime engine is charged for a quantum
+ * 		('cpu_accounting' in hds.conf).
+ */
+typedef enum {
+	HDS_ACCOUNT_WALL, /**< How long it was let run */
+	HDS_ACCOUNT_CPU /**< How much CPU time it consumed meanwhile */
+} hds_accounting_t;
+
+/**
+ * @enum hds_policy_t
+ * @brief Scheduling policies ('policy' in hds.conf), see hds_policy.c.
+ */
+typedef enum {
+	HDS_POLICY_FEEDBACK, /**< Priority levels, one level down on every preemption */
+	HDS_POLICY_MLFQ, /**< Priority levels, one level down once mlfq_quanta are used */
+	HDS_POLICY_SRTF, /**< Shortest remaining cpu_req first */
+	HDS_POLICY_LOTTERY, /**< Draw weighted by policy_weights every quantum */
+	HDS_POLICY_CFS, /**< Smallest vruntime first, weighted by policy_weights */
+	HDS_POLICIES /**< No. of policies. Must be last. */
+} hds_policy_t;
+/**
+ * @def HDS_USER_PRIORITIES
+ * @brief No. of user priorities (1 to 3), i.e. entries of mlfq_quanta and
+ * 		policy_weights.
+ */
+#define HDS_USER_PRIORITIES 3
+
+/**
+ * @def HDS_GEN_MAX_MIX
+ * @brief Max. no. of entries in the generator's memory_mix.
+ */
+#define HDS_GEN_MAX_MIX 16
+/**
+ * @enum hds_gen_arrival_t
+ * @brief Arrival process of the workload generator.
+ */
+typedef enum {
+	HDS_GEN_POISSON, /**< Exponential gaps between single arrivals */
+	HDS_GEN_BURSTY /**< Poisson bursts, each of a geometric no. of jobs */
+} hds_gen_arrival_t;
+/**
+ * @enum hds_gen_cpu_t
+ * @brief Distribution of cpu_req drawn by the workload generator.
+ */
+typedef enum {
+	HDS_GEN_EXPONENTIAL,
+	HDS_GEN_PARETO /**< Heavy tailed, shape pareto_alpha */
+} hds_gen_cpu_t;
+/**
+ * @struct hds_generator_config_t
+ * @brief Settings of the synthetic workload generator ('generator' group in
+ * 		hds.conf). The same seed always gives the same jobs.
+ */
+struct hds_generator_config_t{
+	bool enabled;
+	unsigned long int seed;
+	unsigned long int jobs; // no. of jobs to generate
+	hds_gen_arrival_t arrival;
+	double rate; // mean jobs per time quantum
+	double burst_size; // mean jobs per burst
+	hds_gen_cpu_t cpu;
+	double cpu_mean; // mean cpu_req, in time quanta
+	double pareto_alpha;
+	int cpu_max;
+	unsigned int memory_mix_len;
+	int memory_sizes[HDS_GEN_MAX_MIX];
+	double memory_weights[HDS_GEN_MAX_MIX];
+	double priority_ratio[4]; // weight of priorities 0..3
+	bool kernel_mix; // kernel_ratio was given, else every job sleeps
+	double kernel_ratio[HDS_KERNELS]; // weight of each kernel, in enum order
+};
+
+/**
+ * @struct max_resources_t
+ * @brief Kinds of resources and how many units of each there are
+ * 		('max_resources' in hds.conf). memory, printer and scanner come first,
+ * 		kinds added in hds.conf after them.
+ */
 struct max_resources_t{
-	int memory;
-	int printer;
-	int scanner;
+	int kinds; //no. of resource kinds in use
+	char name[HDS_MAX_RESOURCES][HDS_RES_NAME_LEN];
+	hds_resvec_t units;
 };
 struct hds_config_t {
 	struct hds_process_t *job_dispatch_list; //list of processes loaded from config file.
 	struct hds_process_t *job_dispatch_list_last_ele;
+	unsigned int job_id_counter; //last job_id handed out
 	struct max_resources_t max_resources;
 	char log_filename[200];
+	hds_engine_t engine;
+	int cpus; //no. of simulated cpus
+	hds_policy_t policy;
+	int mlfq_quanta[HDS_USER_PRIORITIES]; //quanta a process gets on p1..p3
+	int policy_weights[HDS_USER_PRIORITIES]; //lottery tickets, cfs weights of p1..p3
+	unsigned int aging_interval; //quanta waited on p2q/p3q before moving up, 0 for never
+	hds_acquisition_t acquisition; //when processes take their resources
+	hds_avoidance_t deadlock_avoidance;
+	hds_admit_kernel_t admission_kernel;
+	unsigned int submit_ring_size; //slots in submission ring, 0 for default
+	unsigned int worker_pool; //parked worker processes, 0 to fork every process
+	hds_exec_backend_t exec_backend;
+	hds_accounting_t cpu_accounting;
+	char trace_file[200]; //CSV trace streamed during the run, empty for none
+	unsigned int trace_lookahead; //quanta ahead of current time to read jobs
+	struct hds_generator_config_t generator;
 } hds_config;
 
 // --------routines-----------
@@ -1,31 +1,40 @@
 /*
  */
 #include "hds_core.h"
-static int remove_first_ele_from_dispatcher_q(
-		struct hds_process_t **dispatcher_list_head);
+#include "hds_report.h"
+#include "hds_exec.h"
 static int insert_process_to_q_from_dispatch_list(
 		struct process_queue_t **qhead, struct process_queue_t **q_last,
 		struct hds_process_t *process_frm_dispatch_list);
-static bool can_process_be_admitted(struct process_queue_t *next_to_run);
-static struct process_queue_t *find_next_process_tobe_executed();
-static void remove_process_from_queue(struct process_queue_t *p);
-static void degrade_priority_and_save_to_q(struct process_queue_t *p);
-static void del_node(struct process_queue_t **qhead,
-		struct process_queue_t *to_be_deleted);
-static void child_function();
-static void process_user_jobq(struct process_queue_t **qhead);
-static int insert_process_to_q_from_user_job_q(struct process_queue_t **qhead,
-		struct process_queue_t **q_last,
+static struct process_queue_t *new_node_from_dispatch_list(
+		struct hds_process_t *process_frm_dispatch_list);
+static void process_user_jobq(struct hds_cpu_t *cpu,
+		struct process_queue_t **qhead);
+static int insert_process_to_runq_from_user_job_q(struct hds_cpu_t *cpu,
 		struct process_queue_t *process_frm_user_jobq);
-static int remove_first_ele_from_user_job_q(struct process_queue_t **user_job_q);
-static int allocate_resources(struct process_queue_t *process);
-static int free_resources(struct process_queue_t *process);
+static struct hds_cpu_t *least_loaded_cpu();
+static unsigned long int cpu_load(struct hds_cpu_t *cpu);
+static bool schedule_on_cpu(struct hds_cpu_t *cpu);
+static void init_cpu(struct hds_cpu_t *cpu, int id);
+static int enqueue_process(struct hds_cpu_t *cpu, struct process_queue_t *p);
+static struct process_queue_t *remove_first_ele_from_user_job_q(
+		struct process_queue_t **user_job_q);
 static int insert_mem_block_to_list(struct mem_block_t *mblock_to_attached);
 static int find_smallest_free_mblock(unsigned int pid, int mem_req);
 static void _consolidate_memory();
 static int allocate_from_free_pool(unsigned int pid, int mem_req);
 static void cleanup_mem_block_list();
 static MEM_HANDLE allocate_mem(unsigned int pid, unsigned int mem_req);
+static void avail_snapshot(hds_resvec_t *avail);
+static void first_request(struct process_queue_t *p);
+static int device_kinds(const struct process_queue_t *p);
+static int staged_kind(const struct process_queue_t *p, int step);
+static void wake_resource_waiters();
+static void wait_for_resources(struct hds_cpu_t *cpu);
+static void handoff_put(struct hds_cpu_t *cpu, struct process_queue_t *p);
+static struct process_queue_t *handoff_take(struct hds_cpu_t *cpu);
+static unsigned long int run_quantum(struct hds_cpu_t *cpu,
+		unsigned long int *used);
 void print_memory_maps();
 
 struct mem_block_t* SortedMerge(struct mem_block_t* a, struct mem_block_t* b);
@@ -38,67 +47,99 @@ void init_hds_resource_state() {
 	// we are reserving for realtime processes.
 	// NOTE: Any resource allocation/deallocation must explicittly update
 	// global hds_resource_state fields.
-	max_available_resource.avail_memory = hds_config.max_resources.memory - 64;
-
-	max_available_resource.avail_printer = hds_config.max_resources.printer;
-	max_available_resource.avail_scanner = hds_config.max_resources.scanner;
+	max_available_resource.avail = hds_config.max_resources.units;
+	max_available_resource.avail[HDS_RES_MEMORY] =
+			hds_config.max_resources.units[HDS_RES_MEMORY] - 64;
+	max_available_resource.total = max_available_resource.avail;
 }
 void init_hds_core_state() {
-	//init the process queues
-	hds_core_state.p1q = hds_core_state.p1q_last = hds_core_state.p2q =
-			hds_core_state.p2q_last = hds_core_state.p3q =
-					hds_core_state.p3q_last = hds_core_state.rtq =
-							hds_core_state.rtq_last = NULL;
+	int i;
+	//init the process queues, one run queue per cpu
+	hds_core_state.policy = hds_policy_get(hds_config.policy);
+	hds_core_state.ncpus = hds_config.cpus;
+	for (i = 0; i < hds_core_state.ncpus; i++) {
+		init_cpu(&hds_core_state.cpu[i], i);
+	}
 	hds_core_state.user_job_q = hds_core_state.user_job_q_last = NULL;
+	if (hds_heap_init(&hds_core_state.arrival_q, 0) != HDS_OK) {
+		serror("Failed to allocate arrival queue");
+	}
 
-	if (pthread_mutex_init(&hds_core_state.p1q_mutex, NULL ) != 0) {
-		serror("Failed to initialize mutex: p0q_mutex");
+	if (pthread_mutex_init(&max_available_resource.avail_resource_mutex, NULL )
+			!= 0) {
+		serror("Failed to initialize mutex: avail_resource_mutex");
 	}
-	if (pthread_mutex_init(&hds_core_state.p2q_mutex, NULL ) != 0) {
-		serror("Failed to initialize mutex: p1q_mutex");
+	if (pthread_mutex_init(&hds_core_state.mem_lock, NULL ) != 0) {
+		serror("Failed to initialize mutex: mem_lock");
 	}
-	if (pthread_mutex_init(&hds_core_state.p3q_mutex, NULL ) != 0) {
-		serror("Failed to initialize mutex: p2q_mutex");
+	if (hds_config.acquisition == HDS_ACQUIRE_STAGED
+			&& hds_config.engine == HDS_ENGINE_REALTIME) {
+		swarn("Staged resource acquisition needs the event engine, using upfront");
+		hds_config.acquisition = HDS_ACQUIRE_UPFRONT;
 	}
-	if (pthread_mutex_init(&hds_core_state.rtq_mutex, NULL ) != 0) {
-		serror("Failed to initialize mutex: rtq_mutex");
+	if (hds_config.deadlock_avoidance == HDS_AVOID_BANKER
+			&& hds_banker_init(&max_available_resource.banker) != HDS_OK) {
+		serror("Failed to initialize banker's table, deadlock avoidance is off");
+		hds_config.deadlock_avoidance = HDS_AVOID_NONE;
 	}
-
-	if (pthread_mutex_init(&hds_core_state.next_to_run_process_lock, NULL )
-			!= 0) {
-		serror("Failed to initialize mutex: next_to_run_process_mutex");
+	hds_core_state.resource_waitq = hds_core_state.resource_waitq_last = NULL;
+	hds_core_state.resource_waiting = 0;
+	if (pthread_mutex_init(&hds_core_state.resource_waitq_lock, NULL ) != 0) {
+		serror("Failed to initialize mutex: resource_waitq_lock");
 	}
-	if (pthread_mutex_init(&max_available_resource.avail_resource_mutex, NULL )
-			!= 0) {
-		serror("Failed to initialize mutex: avail_resource_mutex");
+	if (hds_pcb_init() != HDS_OK) {
+		serror("Failed to initialize process control blocks");
 	}
-	if (pthread_mutex_init(&hds_core_state.active_process_lock, NULL ) != 0) {
-		serror("Failed to initialize mutex: active_process_lock");
+	if (hds_admit_select(hds_config.admission_kernel) != HDS_OK) {
+		var_warn("Using admission kernel %s instead", hds_admit_name());
+	}
+	hds_wakeup_init(&hds_core_state.dispatcher_wakeup, "dispatcher_wakeup");
+	if (hds_submit_init(hds_config.submit_ring_size) != HDS_OK) {
+		serror("Failed to initialize submission ring");
 	}
-//	hds_core_state.active_process.pid = hds_core_state.next_to_run_process.pid =
-//			-1; //to check if next_to_run process has been seen by cpu
-//	hds_core_state.active_process.priority =
-//			hds_core_state.next_to_run_process.priority = -1; //to check if it's the first
-//															  //time we are running
-	hds_core_state.active_process_valid =
-			hds_core_state.next_to_run_process_valid = false;
+	hds_wakeup_init(&hds_core_state.scheduler_wakeup, "scheduler_wakeup");
+
+	// the event engine will switch over to its own clock once it starts
+	hds_core_state.virtual_clock = false;
+	hds_core_state.virtual_time = 0;
+	clock_gettime(CLOCK_MONOTONIC, &hds_core_state.clock_start);
 
 	// Initialize global memory pool info.
 	hds_core_state.mem_block_list = hds_core_state.mem_block_list_last = NULL;
 	hds_core_state.global_memory_info.max_mem_size =
-			(max_available_resource.avail_memory);
+			(max_available_resource.avail[HDS_RES_MEMORY]);
 	hds_core_state.global_memory_info.mem_available =
 			hds_core_state.global_memory_info.max_mem_size;
 	hds_core_state.global_memory_info.mem_block_id_counter = 1;
 	/*
 	 * We will first 64 MB for realtime processes. So free_pool will start from
-	 * 65 till hds_config.max_resources.memory
+	 * 65 till the memory in hds_config.max_resources
 	 */
 	hds_core_state.global_memory_info.free_pool_start = 65;
 	hds_core_state.global_memory_info.free_pool_end =
-			hds_config.max_resources.memory; // should always point to hds_config.max_resources.memory
+			hds_config.max_resources.units[HDS_RES_MEMORY]; // should always point to the end of memory
 
 }
+static void init_cpu(struct hds_cpu_t *cpu, int id) {
+	cpu->id = id;
+	if (hds_runq_init(&cpu->runq) != HDS_OK) {
+		var_error("Failed to allocate run queue of cpu %d", id);
+	}
+	if (pthread_mutex_init(&cpu->rq_lock, NULL ) != 0) {
+		serror("Failed to initialize mutex: rq_lock");
+	}
+	hds_policy_init_cpu(cpu);
+	if (pthread_mutex_init(&cpu->active_process_lock, NULL ) != 0) {
+		serror("Failed to initialize mutex: active_process_lock");
+	}
+	cpu->active_process_valid = false;
+	cpu->active_process = NULL;
+	cpu->next_to_run = HDS_PCB_NONE;
+	cpu->next_to_run_seq = 0;
+	hds_wakeup_init(&cpu->cpu_wakeup, "cpu_wakeup");
+	cpu->steals = 0;
+	cpu->rt_preemptions = 0;
+}
 /**
  * @brief Main routine for dispatcher thread
  * @param args
@@ -107,134 +148,482 @@ void *hds_dispatcher(void *args) {
 	/*
 	 * Working of dispatcher thread:
 	 * -----------------------------
-	 * 1. Read the next process from jb_dispatch_list
-	 * 2. Find its type and accordingly place this process in one out of the
-	 * 		four process queues that we have.
-	 * 		2.1) Also set the arrival time of this process before putting into
-	 * 				the target process queue.
-	 * 		2.2) Remove this process from job dispatch list.
-	 * 3. Sleep for 1 second
-	 * 4. Repeat step 1 till there  are no more processes left in the job dispatch
-	 * 		list.
-	 * 		4.1) when no more processes sleep for 1 seconds.
+	 * 1. Move every process from job dispatch list into the arrival queue,
+	 * 		a min-heap keyed on arrival offset.
+	 * 2. Drain processes submitted at run time into the arrival queue.
+	 * 3. Release every process whose arrival offset has been reached into
+	 * 		one of the four process queues, in a single batch.
+	 * 		2.1) arrival time of a process is set as it is queued.
+	 * 4. Sleep until the arrival offset of the next process or until a
+	 * 		process is submitted.
+	 * 5. Repeat step 2 till shutdown.
 	 */
+	unsigned long int seen, next;
+	struct timespec deadline;
 
+	if (load_arrival_queue() != HDS_OK) {
+		serror("dispatcher: Failed to load arrival queue");
+	}
 	while (1) {
 		if (hds_state.shutdown_in_progress == true) {
 			break;
 		}
-		if (!hds_config.job_dispatch_list) {
-			// no more processes in job dispatch list
-			sleep(1);
+		seen = hds_wakeup_seq(&hds_core_state.dispatcher_wakeup);
+		drain_submitted_jobs(hds_core_now());
+		release_due_arrivals(hds_core_now());
+
+		if (next_arrival_time(&next) == false) {
+			// every process has arrived, wait for submissions
+			hds_wakeup_wait(&hds_core_state.dispatcher_wakeup, seen);
 			continue;
 		}
-
-		/*
-		 * Since first element of the job dispatch list is the one at head of
-		 * the list, we will process first element of the list.
-		 */
-		switch (hds_config.job_dispatch_list->priority) {
-		case 0:
-			//realtime process -- highest priority and non-interruptable
-			pthread_mutex_lock(&hds_core_state.rtq_mutex);
-			if (insert_process_to_q_from_dispatch_list(&hds_core_state.rtq,
-					&hds_core_state.rtq_last,
-					hds_config.job_dispatch_list)!=HDS_OK) {
-				serror("Failed to insert a process in real time Q");
-				//perform cleanup if needed
-				break;
-			}
-			pthread_mutex_unlock(&hds_core_state.rtq_mutex);
-//			var_debug(
-//					"dispatcher: Adding process(PID:%d PRI:%d CPU:%d MEM:%d PRN:%d SCN:%d) to rtq",
-//					hds_config.job_dispatch_list->pid,
-//					hds_config.job_dispatch_list->priority,
-//					hds_config.job_dispatch_list->cpu_req,
-//					hds_config.job_dispatch_list->memory_req,
-//					hds_config.job_dispatch_list->printer_req,
-//					hds_config.job_dispatch_list->scanner_req)
-//			;
-
-			//remove this process from dispatch queue
-			remove_first_ele_from_dispatcher_q(&hds_config.job_dispatch_list);
+		//arrival offsets are in quanta of one second from clock_start
+		deadline = hds_core_state.clock_start;
+		deadline.tv_sec += next * SMALLEST_TIME_QUANTUM;
+		hds_wakeup_wait_until(&hds_core_state.dispatcher_wakeup, seen,
+				&deadline);
+	}
+	sdebug("dispatcher: Shutting down..");
+	//clean processes which never arrived
+	cleanup_arrival_queue();
+	pthread_exit(NULL );
+}
+/**
+ * @brief Move every process from the job dispatch list into the arrival queue
+ * 		and open the trace file, if one is configured. Processes are released
+ * 		from there in order of arrival offset, those with the same offset in
+ * 		the order they were loaded.
+ * @return HDS_OK on success else an error code.
+ */
+int load_arrival_queue() {
+	struct hds_process_t *process = NULL;
+	while ((process = hds_config.job_dispatch_list) != NULL) {
+		if (hds_heap_push(&hds_core_state.arrival_q, process->arrival, process)
+				!= HDS_OK) {
+			return HDS_ERR_NO_MEM;
+		}
+		hds_config.job_dispatch_list = process->next;
+		process->next = NULL;
+	}
+	hds_config.job_dispatch_list_last_ele = NULL;
+	if (hds_source_open() != HDS_OK) {
+		return HDS_ERR_FILE_IO;
+	}
+	refill_arrival_queue(0);
+	return HDS_OK;
+}
+/**
+ * @brief Read jobs from the streaming source into the arrival queue up to
+ * 		trace_lookahead quanta past now. Only this window of the source is
+ * 		ever held in memory.
+ * @param now Current time in quanta, see hds_core_now().
+ * @return No. of processes read.
+ */
+unsigned long int refill_arrival_queue(unsigned long int now) {
+	struct hds_process_t *process = NULL;
+	unsigned long int arrival, added = 0;
+
+	while (hds_source_peek(&arrival) == true
+			&& arrival <= now + hds_config.trace_lookahead) {
+		process = (struct hds_process_t *) malloc(sizeof(struct hds_process_t));
+		if (!process) {
+			serror("Failed to allocate memory for process from trace");
 			break;
-
-		default:
-			//this is a user process so we add it to user job queue.
-			// all processes other than realtime processes go this user_job_q
-			if (insert_process_to_q_from_dispatch_list(
-					&hds_core_state.user_job_q, &hds_core_state.user_job_q_last,
-					hds_config.job_dispatch_list) != HDS_OK) {
-				serror("Failed to insert a process in user job q");
-				//perform cleanup if needed
-				break;
+		}
+		hds_source_next(process);
+		process->next = NULL;
+		if (hds_heap_push(&hds_core_state.arrival_q, process->arrival, process)
+				!= HDS_OK) {
+			free(process);
+			break;
+		}
+		added++;
+	}
+	return added;
+}
+/**
+ * @brief Move processes from the submission ring into the arrival queue. Their
+ * 		arrival, a delay when submitted, becomes an offset from now.
+ * @param now Current time in quanta, see hds_core_now().
+ * @return No. of processes moved.
+ */
+unsigned long int drain_submitted_jobs(unsigned long int now) {
+	struct hds_process_t jobs[HDS_SUBMIT_DRAIN_BATCH];
+	struct hds_process_t *process = NULL;
+	unsigned long int moved = 0;
+	unsigned int n, i;
+
+	while ((n = hds_submit_drain(jobs, HDS_SUBMIT_DRAIN_BATCH)) > 0) {
+		for (i = 0; i < n; i++) {
+			process = (struct hds_process_t *) malloc(
+					sizeof(struct hds_process_t));
+			if (!process) {
+				serror("Failed to allocate memory for submitted process");
+				continue;
+			}
+			*process = jobs[i];
+			process->next = NULL;
+			process->pid = 0;
+			process->job_id = ++hds_config.job_id_counter;
+			process->arrival = now + jobs[i].arrival;
+			if (hds_heap_push(&hds_core_state.arrival_q, process->arrival,
+					process) != HDS_OK) {
+				free(process);
+				continue;
 			}
-			remove_first_ele_from_dispatcher_q(&hds_config.job_dispatch_list);
-			// now we need to process processes in job_q and put them to respective
-			// process queues
-			process_user_jobq(&hds_core_state.user_job_q);
+			moved++;
+		}
+	}
+	return moved;
+}
+/**
+ * @brief Dispatch every process whose arrival offset is not later than now.
+ * @param now Current time in quanta, see hds_core_now().
+ * @return No. of processes dispatched.
+ */
+unsigned long int release_due_arrivals(unsigned long int now) {
+	struct hds_process_t *process = NULL;
+	unsigned long int key, released = 0;
+	void *data = NULL;
+
+	refill_arrival_queue(now);
+	while (hds_heap_peek(&hds_core_state.arrival_q, &key, &data) == HDS_OK
+			&& key <= now) {
+		process = (struct hds_process_t *) data;
+		if (dispatch_process(process) != HDS_OK) {
+			// leave it at the top of arrival queue, retried next time
 			break;
 		}
+		hds_heap_pop(&hds_core_state.arrival_q, &key, &data);
+		free(process);
+		released++;
+	}
+	return released;
+}
+/**
+ * @brief Find when the next process arrives.
+ * @param t Set to the arrival offset of the next process.
+ * @return false if every process has already arrived.
+ */
+bool next_arrival_time(unsigned long int *t) {
+	unsigned long int from_source;
+	void *data = NULL;
+	if (hds_heap_peek(&hds_core_state.arrival_q, t, &data) != HDS_OK) {
+		return hds_source_peek(t);
+	}
+	// source may hold a job earlier than the queue, outside the lookahead
+	if (hds_source_peek(&from_source) == true && from_source < *t) {
+		*t = from_source;
+	}
+	return true;
+}
+/**
+ * @brief Free processes left in the arrival queue.
+ */
+void cleanup_arrival_queue() {
+	unsigned long int key;
+	void *data = NULL;
+	while (hds_heap_pop(&hds_core_state.arrival_q, &key, &data) == HDS_OK) {
+		free(data);
+	}
+	hds_source_close();
+}
+/**
+ * @brief Place a process from the job dispatch list into the process queues.
+ *
+ * Realtime processes go straight to rtq, all other processes go to the user
+ * job queue from where they are moved to their priority based queue. Shared
+ * by the dispatcher thread and the event engine.
+ * @param process The process which has just arrived.
+ * @return HDS_OK if the process was queued else an error code.
+ */
+int dispatch_process(struct hds_process_t *process) {
+	struct process_queue_t *node = NULL;
+	struct hds_cpu_t *cpu = least_loaded_cpu();
+	if (!hds_resvec_fits(&process->req, &max_available_resource.total)) {
+		// it would wait for ever and keep whatever it waits behind blocked
+		var_error("Job %u needs more resources than there are, dropped",
+				process->job_id);
+		if ((node = new_node_from_dispatch_list(process)) != NULL) {
+			hds_report_job(node, HDS_JOB_FAILED);
+			hds_pcb_free(node);
+		}
+		return HDS_OK;
+	}
+	switch (process->priority) {
+	case 0:
+		//realtime process -- highest priority and non-interruptable
+		if ((node = new_node_from_dispatch_list(process))
+				&& hds_core_state.virtual_clock == false) {
+			// how long it takes to get a cpu is measured from here
+			node->ready_ns = hds_core_clock_ns();
+		}
+		if (!node || enqueue_process(cpu, node) != HDS_OK) {
+			hds_pcb_free(node);
+			serror("Failed to insert a process in real time Q");
+			return HDS_ERR_NO_MEM;
+		}
+		break;
 
-		//now sleep for 1 seconds before going to look for a new process
-		sleep(1);
+	default:
+		//this is a user process so we add it to user job queue.
+		// all processes other than realtime processes go this user_job_q
+		if (insert_process_to_q_from_dispatch_list(&hds_core_state.user_job_q,
+				&hds_core_state.user_job_q_last, process) != HDS_OK) {
+			serror("Failed to insert a process in user job q");
+			return HDS_ERR_NO_MEM;
+		}
+		// now we need to process processes in job_q and put them to respective
+		// process queues
+		process_user_jobq(cpu, &hds_core_state.user_job_q);
+		break;
+	}
+	hds_wakeup_signal(&hds_core_state.scheduler_wakeup);
+	return HDS_OK;
+}
+/**
+ * @brief Find the cpu with the least work, counting queued processes and the
+ * 		active and next_to_run slots. Lowest id wins a tie. Counts are read
+ * 		without stopping the cpus, so this is a hint only; stealing evens
+ * 		out a bad placement.
+ */
+static struct hds_cpu_t *least_loaded_cpu() {
+	struct hds_cpu_t *best = &hds_core_state.cpu[0];
+	unsigned long int load, best_load;
+	int i;
+	best_load = cpu_load(best);
+	for (i = 1; i < hds_core_state.ncpus && best_load > 0; i++) {
+		load = cpu_load(&hds_core_state.cpu[i]);
+		if (load < best_load) {
+			best = &hds_core_state.cpu[i];
+			best_load = load;
+		}
+	}
+	return best;
+}
+static unsigned long int cpu_load(struct hds_cpu_t *cpu) {
+	return hds_core_queued(cpu) + (cpu->active_process_valid == true)
+			+ (hds_core_next_to_run(cpu, NULL ) == true);
+}
+/**
+ * @brief Returns the time used for stamping processes as they enter a queue.
+ *
+ * When the event engine is running this is its virtual time (in quanta),
+ * otherwise the no. of seconds since the core was started. As a quantum is one
+ * second in realtime mode, both are in the same unit.
+ */
+unsigned long int hds_core_now() {
+	struct timespec ts;
+	if (hds_core_state.virtual_clock == true) {
+		return hds_core_state.virtual_time;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	if (ts.tv_nsec < hds_core_state.clock_start.tv_nsec) {
+		//less than a full second since the last whole second
+		ts.tv_sec--;
+	}
+	return ts.tv_sec - hds_core_state.clock_start.tv_sec;
+}
+/**
+ * @brief Wall clock time on CLOCK_MONOTONIC in nanoseconds, for measuring
+ * 		intervals shorter than a quantum. Never 0.
+ */
+unsigned long int hds_core_clock_ns() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+/**
+ * @brief Count processes waiting in rtq and the priority queues, or for
+ * 		resources.
+ */
+unsigned long int count_queued_processes() {
+	unsigned long int count = 0;
+	int i;
+	for (i = 0; i < hds_core_state.ncpus; i++) {
+		count += hds_core_queued(&hds_core_state.cpu[i]);
+	}
+	pthread_mutex_lock(&hds_core_state.resource_waitq_lock);
+	count += hds_core_state.resource_waiting;
+	pthread_mutex_unlock(&hds_core_state.resource_waitq_lock);
+	return count;
+}
+/**
+ * @brief Tells if no cpu has an active or next_to_run process.
+ */
+bool hds_core_cpus_idle() {
+	int i;
+	for (i = 0; i < hds_core_state.ncpus; i++) {
+		if (hds_core_state.cpu[i].active_process_valid == true
+				|| hds_core_next_to_run(&hds_core_state.cpu[i], NULL )
+						== true) {
+			return false;
+		}
+	}
+	return true;
+}
+/**
+ * @brief No. of processes which were taken from one cpu by another.
+ */
+unsigned long int hds_core_steals() {
+	unsigned long int steals = 0;
+	int i;
+	for (i = 0; i < hds_core_state.ncpus; i++) {
+		steals += hds_core_state.cpu[i].steals;
+	}
+	return steals;
+}
+/**
+ * @brief No. of quanta cut short for a realtime process, on every cpu.
+ */
+unsigned long int hds_core_rt_preemptions() {
+	unsigned long int preemptions = 0;
+	int i;
+	for (i = 0; i < hds_core_state.ncpus; i++) {
+		preemptions += hds_core_state.cpu[i].rt_preemptions;
+	}
+	return preemptions;
+}
+/**
+ * @brief Tells if every process has left the system, i.e. nothing is left in
+ * 		the dispatch list, queues or on the cpu.
+ */
+bool hds_core_workload_done() {
+	return (hds_config.job_dispatch_list == NULL
+			&& hds_heap_empty(&hds_core_state.arrival_q)
+			&& hds_submit_pending() == 0
+			&& hds_source_done()
+			&& hds_core_state.user_job_q == NULL
+			&& hds_core_cpus_idle()
+			&& count_queued_processes() == 0);
+}
+/**
+ * @brief Copy of max_available_resource.avail taken without its mutex. Every
+ * 		lane is read atomically, lanes may be from slightly different moments.
+ */
+static void avail_snapshot(hds_resvec_t *avail) {
+	const int *lanes = (const int *) &max_available_resource.avail;
+	int i;
+	for (i = 0; i < HDS_MAX_RESOURCES; i++) {
+		(*avail)[i] = __atomic_load_n(&lanes[i], __ATOMIC_RELAXED);
+	}
+}
+/**
+ * @brief Set up a wakeup nobody has signalled yet.
+ */
+void hds_wakeup_init(struct hds_wakeup_t *w, const char *name) {
+	pthread_condattr_t attr;
+	w->seq = 0;
+	if (pthread_mutex_init(&w->lock, NULL ) != 0) {
+		var_error("Failed to initialize mutex: %s", name);
+	}
+	// timed waits are measured on the monotonic clock
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	if (pthread_cond_init(&w->cond, &attr) != 0) {
+		var_error("Failed to initialize condition variable: %s", name);
+	}
+	pthread_condattr_destroy(&attr);
+}
+/**
+ * @brief Read the no. of signals sent so far. Take it before looking for work
+ * 		and pass it to hds_wakeup_wait().
+ */
+unsigned long int hds_wakeup_seq(struct hds_wakeup_t *w) {
+	unsigned long int seq;
+	pthread_mutex_lock(&w->lock);
+	seq = w->seq;
+	pthread_mutex_unlock(&w->lock);
+	return seq;
+}
+/**
+ * @brief Wake the thread sleeping on w, or make its next wait return at once.
+ */
+void hds_wakeup_signal(struct hds_wakeup_t *w) {
+	pthread_mutex_lock(&w->lock);
+	w->seq++;
+	pthread_cond_signal(&w->cond);
+	pthread_mutex_unlock(&w->lock);
+}
+/**
+ * @brief Sleep until w is signalled after seen was read, shutdown begins or
+ * 		HDS_WAKEUP_TIMEOUT_MS has passed.
+ * @param w The wakeup to sleep on.
+ * @param seen Value returned by hds_wakeup_seq() before looking for work.
+ */
+void hds_wakeup_wait(struct hds_wakeup_t *w, unsigned long int seen) {
+	hds_wakeup_wait_until(w, seen, NULL );
+}
+/**
+ * @brief Same as hds_wakeup_wait() but also returns at deadline, an absolute
+ * 		time on CLOCK_MONOTONIC, if that comes first. NULL means no deadline.
+ */
+void hds_wakeup_wait_until(struct hds_wakeup_t *w, unsigned long int seen,
+		const struct timespec *deadline) {
+	struct timespec until;
+	clock_gettime(CLOCK_MONOTONIC, &until);
+	until.tv_sec += HDS_WAKEUP_TIMEOUT_MS / 1000;
+	until.tv_nsec += (HDS_WAKEUP_TIMEOUT_MS % 1000) * 1000000L;
+	if (until.tv_nsec >= 1000000000L) {
+		until.tv_sec++;
+		until.tv_nsec -= 1000000000L;
+	}
+	if (deadline
+			&& (deadline->tv_sec < until.tv_sec
+					|| (deadline->tv_sec == until.tv_sec
+							&& deadline->tv_nsec < until.tv_nsec))) {
+		until = *deadline;
+	}
+	pthread_mutex_lock(&w->lock);
+	while (w->seq == seen && hds_state.shutdown_in_progress == false) {
+		if (pthread_cond_timedwait(&w->cond, &w->lock, &until) == ETIMEDOUT) {
+			break;
+		}
+	}
+	pthread_mutex_unlock(&w->lock);
+}
+/**
+ * @brief Wake every sleeping thread, used once shutdown_in_progress is set.
+ */
+void hds_core_wake_all() {
+	int i;
+	hds_wakeup_signal(&hds_core_state.dispatcher_wakeup);
+	hds_wakeup_signal(&hds_core_state.scheduler_wakeup);
+	for (i = 0; i < hds_core_state.ncpus; i++) {
+		hds_wakeup_signal(&hds_core_state.cpu[i].cpu_wakeup);
 	}
-	sdebug("dispatcher: Shutting down..");
-	//clean dispatch list
-	cleanup_process_dispatch_list();
-	pthread_exit(NULL );
 }
 /**
  * @brief Move processes from user_jobq to their respective priority based queues.
+ * @param cpu The cpu whose run queue the process is placed on.
  * @param qhead The pointer to the head of the user job queue.
  */
-static void process_user_jobq(struct process_queue_t **qhead) {
-	switch ((*qhead)->priority) {
+static void process_user_jobq(struct hds_cpu_t *cpu,
+		struct process_queue_t **qhead) {
+	struct process_queue_t *p = NULL;
+	//remove this process from dispatch queue
+	if (!(p = remove_first_ele_from_user_job_q(qhead))) {
+		return;
+	}
+	switch (p->priority) {
 	case 1:
-		//user time process of priority 1 -- highest priority
-		pthread_mutex_lock(&hds_core_state.p1q_mutex);
-		if (insert_process_to_q_from_user_job_q(&hds_core_state.p1q,
-				&hds_core_state.p1q_last, *qhead) != HDS_OK) {
-			serror("Failed to insert a process in p1Q");
-			//perform cleanup if needed
-			break;
-		}
-		pthread_mutex_unlock(&hds_core_state.p1q_mutex);
-		//remove this process from dispatch queue
-		remove_first_ele_from_user_job_q(qhead);
-		break;
 	case 2:
-		//user time process of priority 2 -- medium priority
-		pthread_mutex_lock(&hds_core_state.p2q_mutex);
-		if (insert_process_to_q_from_user_job_q(&hds_core_state.p2q,
-				&hds_core_state.p2q_last, *qhead) != HDS_OK) {
-			serror("Failed to insert a process in p2Q");
-			//perform cleanup if needed
-			break;
-		}
-		pthread_mutex_unlock(&hds_core_state.p2q_mutex);
-		//remove this process from dispatch queue
-		remove_first_ele_from_user_job_q(qhead);
-		break;
 	case 3:
-		//user time process of priority 3 -- lowest priority
-		pthread_mutex_lock(&hds_core_state.p3q_mutex);
-		if (insert_process_to_q_from_user_job_q(&hds_core_state.p3q,
-				&hds_core_state.p3q_last, *qhead) != HDS_OK) {
-			serror("Failed to insert a process in p3Q");
-			//perform cleanup if needed
-			break;
+		//user time process of priority 1 (highest) to 3 (lowest)
+		if (insert_process_to_runq_from_user_job_q(cpu, p) != HDS_OK) {
+			var_error("Failed to insert a process in p%dQ", p->priority);
+			// it stays first in user job queue
+			p->next = *qhead;
+			*qhead = p;
+			hds_pcb_track(p, HDS_PCB_USER_JOBQ);
 		}
-		pthread_mutex_unlock(&hds_core_state.p3q_mutex);
-		//remove this process from dispatch queue
-		remove_first_ele_from_user_job_q(qhead);
 		break;
 	default:
 		//this is a process having unrecognized priority. we remove it
 		serror(
 				"Found a process with bogus priority. Removing from the user job list")
 		;
-		remove_first_ele_from_user_job_q(qhead);
+		hds_pcb_free(p);
 		break;
 	}
 }
@@ -246,332 +635,392 @@ void *hds_scheduler(void *args) {
 	/*
 	 * Basic working of scheduler
 	 * ---------------------------
+	 * For every cpu in turn:
 	 * 1. Searching for a process begins from the highest priority queue to
-	 * 		lower priority queues.
-	 * 2. Look for the first process that satisfies the admission test.
-	 * 3. Insert this process in hds_core_state.next_to_run_process.
-	 * 4. Remove this process from its current queue.
+	 * 		lower priority queues of that cpu.
+	 * 2. Look for the first process that satisfies the admission test. If
+	 * 		there is none and the cpu is idle, steal one from another cpu.
+	 * 3. Remove this process from its current queue.
+	 * 4. Hand it to the cpu through its next_to_run slot.
+	 * Sleep once no cpu got a new next_to_run process.
 	 */
-	struct process_queue_t *next_process = NULL, *tmp = NULL;
+	unsigned long int seen;
+	bool progress;
+	int i;
 	while (1) {
 		if (hds_state.shutdown_in_progress == true) {
 			break;
 		}
+		// anything signalled from here on makes the wait below return at once
+		seen = hds_wakeup_seq(&hds_core_state.scheduler_wakeup);
+		progress = false;
+		for (i = 0; i < hds_core_state.ncpus; i++) {
+			if (schedule_on_cpu(&hds_core_state.cpu[i]) == true) {
+				progress = true;
+			}
+		}
+		if (progress == false) {
+			hds_wakeup_wait(&hds_core_state.scheduler_wakeup, seen);
+		}
+	}
+	sdebug("scheduler: Shutting down..");
+	pthread_exit(NULL );
+}
+/**
+ * @brief Publish a next_to_run process for one cpu, if a suitable one is
+ * 		queued.
+ * @return true if next_to_run process of cpu was set.
+ */
+static bool schedule_on_cpu(struct hds_cpu_t *cpu) {
+	struct process_queue_t *next_process = NULL, *waiting = NULL;
+	bool preempts;
 //		var_debug("scheduler: parent: %d, I belong to %d process",hds_state.parent_pid,getpid());
-		//find next highest process which has passed the admission test.
-		next_process = find_next_process_tobe_executed();
+	//find next highest process which has passed the admission test.
+	next_process = find_next_process_tobe_executed(cpu);
+	if (next_process == NULL && cpu->active_process_valid == false
+			&& hds_core_next_to_run(cpu, NULL ) == false) {
+		// this cpu would stay idle, take work queued on another one
+		next_process = steal_process(cpu);
+	}
 
-		if (next_process == NULL ) {
-			//no process could pass the admission test possibly because, resources
-			// are held by older processes have not yet been released
+	if (next_process == NULL ) {
+		//no process could pass the admission test possibly because, resources
+		// are held by older processes have not yet been released
 //			sdebug(
 //					"Could not find a process to be scheduled for next execution.");
-			sleep(1);
-			continue;
-		}
+		return false;
+	}
 //		var_debug(
 //				"scheduler: Selected next process(PID:%d PRI:%d CPU:%d MEM:%d PRN:%d SCN:%d)",
 //				next_process->pid, next_process->priority,
-//				next_process->cpu_req, next_process->memory_req,
-//				next_process->printer_req, next_process->scanner_req);
-
-		// now we have a process which will be scheduled for execution in the
-		// next cycle. However we will schedule it only when it has higher
-		// priority than the currently executing process. If not then we will wait
-		// until execution of active process it over. However, while we are waiting
-		// a new process of higher priority might arrive from dispatch queue
-		// therefore better would be that we continue up.
-
-		//for the first time, since active_process and next_to_run process both
-		// have their priorities set to -1. to avoid this check for first time
-		// we will check if active_process's is valid
-		if ((hds_core_state.active_process.priority < next_process->priority)
-				&& (hds_core_state.active_process_valid == true)) {
+//				next_process->cpu_req, next_process->req[HDS_RES_MEMORY],
+//				next_process->req[HDS_RES_PRINTER],
+//				next_process->req[HDS_RES_SCANNER]);
+
+	// now we have a process which will be scheduled for execution in the
+	// next cycle. However we will schedule it only when it has higher
+	// priority than the currently executing process. If not then we will wait
+	// until execution of active process it over. However, while we are waiting
+	// a new process of higher priority might arrive from dispatch queue
+	// therefore better would be that we continue up.
+
+	//for the first time, since active_process and next_to_run process both
+	// have their priorities set to -1. to avoid this check for first time
+	// we will check if active_process's is valid
+	pthread_mutex_lock(&cpu->active_process_lock);
+	preempts = cpu->active_process_valid == false
+			|| hds_policy_precedes(cpu->active_process, next_process)
+					== false;
+	pthread_mutex_unlock(&cpu->active_process_lock);
+	if (preempts == false) {
 //			sdebug("scheduler: Active process cant be interrupted !");
-			sleep(1);
-			continue;
-		}
-
-		// here we have a process which is at higher priority than the currently
-		// executing process. Now we should save it in hds_core_state.next_to_run
-		// process such that in the next cycle cpu thread will find it and execute it.
-		// However what if next_to_run process has not yet run ? CPU might not have
-		// seen it as of now.
-		// To handle such case, we check if next_to_run process is a high priority
-		// process as compared to the next_process. If it's so then we will not
-		// interrupt it rather we will sleep and continue all the way up.
-		// however if it's at lower priority then we will replace it by
-		// next_process attributes and insert the next_to_run process into
-		// its queue *without* lowering the priority.
-		/*
-		 * how do we know that next_to_run process has been seen and serviced
-		 * by cpu_thread. If cpu has seen and started the next_to_run process,
-		 * then it will reset the next_to_run process->pid to -1. Note that
-		 * by default all pids are 0 unless they have been started, in that case
-		 * pid will be a valid linux PID.
-		 */
-
-		if (hds_core_state.next_to_run_process_valid == false) {
-			//it will be replaced for sure. this handles the initial case
-//			var_debug(
-//					"scheduler: Setting next to be executed process(PID:%d PRI:%d CPU:%d MEM:%d PRN:%d SCN:%d)",
-//					next_process->pid, next_process->priority,
-//					next_process->cpu_req, next_process->memory_req,
-//					next_process->printer_req, next_process->scanner_req);
-
-			pthread_mutex_lock(&hds_core_state.next_to_run_process_lock);
-			hds_core_state.next_to_run_process.arrival_time =
-					next_process->arrival_time;
-			hds_core_state.next_to_run_process.cpu_req = next_process->cpu_req;
-			hds_core_state.next_to_run_process.memory_req =
-					next_process->memory_req;
-			hds_core_state.next_to_run_process.pid = next_process->pid;
-			hds_core_state.next_to_run_process.printer_req =
-					next_process->printer_req;
-			hds_core_state.next_to_run_process.priority =
-					next_process->priority;
-			hds_core_state.next_to_run_process.scanner_req =
-					next_process->scanner_req;
-
-			//validate next_to_run process
-			hds_core_state.next_to_run_process_valid = true;
-			pthread_mutex_unlock(&hds_core_state.next_to_run_process_lock);
-			// now that next_process has been submitted to cpu remove it from
-			// its current queue.
-			remove_process_from_queue(next_process);
-			continue;
-		}
-		/*
-		 * if next_to_run process is valid one,then we will check if it can
-		 * be replaced.
-		 */
-		if ((hds_core_state.next_to_run_process.priority
-				<= next_process->priority)) {
-			// we will follow fcfs for processes with equal priority
-			//next_to_run process cant be replaced
-//			sdebug("Cant replace next_to_run process");
-			sleep(1);
-			continue;
-		} else {
-			// since next_to_run process is a valid process it means
-			// next_to_run process has not yet been executed even once and its
-			// priority is even less than next_process so we will replace
-			// it by next_process
-
-			// first degrade priority of next_to_run process and save it to
-			// appropriate queues
-//			var_debug(
-//					"scheduler: Replacing next_to_run process with(PID:%d PRI:%d CPU:%d MEM:%d PRN:%d SCN:%d)",
-//					next_process->pid, next_process->priority,
-//					next_process->cpu_req, next_process->memory_req,
-//					next_process->printer_req, next_process->scanner_req);
-
-			pthread_mutex_lock(&hds_core_state.next_to_run_process_lock);
-			// this process has not been executed even once. should it priority
-			// be degraded
-			degrade_priority_and_save_to_q(&hds_core_state.next_to_run_process);
-			pthread_mutex_unlock(&hds_core_state.next_to_run_process_lock);
-
-			//now copy next_process into next_to_run process
-			pthread_mutex_lock(&hds_core_state.next_to_run_process_lock);
-			hds_core_state.next_to_run_process.arrival_time =
-					next_process->arrival_time;
-			hds_core_state.next_to_run_process.cpu_req = next_process->cpu_req;
-			hds_core_state.next_to_run_process.memory_req =
-					next_process->memory_req;
-			hds_core_state.next_to_run_process.pid = next_process->pid;
-			hds_core_state.next_to_run_process.printer_req =
-					next_process->printer_req;
-			hds_core_state.next_to_run_process.priority =
-					next_process->priority;
-			hds_core_state.next_to_run_process.scanner_req =
-					next_process->scanner_req;
-
-			//validate next_to_run process
-			hds_core_state.next_to_run_process_valid = true;
-			pthread_mutex_unlock(&hds_core_state.next_to_run_process_lock);
+		return false;
+	}
 
-			// now that next_process has been submitted to cpu remove it from
-			// its current queue.
-			remove_process_from_queue(next_process);
-		}
-		//sleep for one second before going up
-		sleep(1);
+	// here we have a process which is at higher priority than the currently
+	// executing process. Now we should save it in hds_core_state.next_to_run
+	// process such that in the next cycle cpu thread will find it and execute it.
+	// However what if next_to_run process has not yet run ? CPU might not have
+	// seen it as of now.
+	// To handle such case, we check if next_to_run process is a high priority
+	// process as compared to the next_process. If it's so then we will not
+	// interrupt it rather we will sleep and continue all the way up.
+	// however if it's at lower priority then we will replace it by
+	// next_process attributes and insert the next_to_run process into
+	// its queue *without* lowering the priority.
+	/*
+	 * The slot is handed over with atomic pointer swaps: whoever swaps the
+	 * process out of it owns it. Take back what the cpu has not picked up
+	 * yet, so it can be compared without racing with the cpu, and keep it
+	 * if next_process does not go before it.
+	 */
+	waiting = handoff_take(cpu);
+	if (waiting && hds_policy_precedes(next_process, waiting) == false) {
+		// we will follow fcfs for processes with equal priority
+		//next_to_run process cant be replaced
+		handoff_put(cpu, waiting);
+		return false;
 	}
-	sdebug("scheduler: Shutting down..");
-	pthread_exit(NULL );
-}
-static void degrade_priority_and_save_to_q(struct process_queue_t *p) {
-	struct process_queue_t * newp = NULL;
-	newp = (struct process_queue_t*) malloc(sizeof(struct process_queue_t));
-	if (!newp) {
-		serror("Failed to allocate memory for new process");
-		return;
+	if (waiting) {
+		// next_to_run process has not been executed even once and its
+		// priority is even less than next_process so we will replace it by
+		// next_process and save it to appropriate queues
+		degrade_priority_and_save_to_q(cpu, waiting);
 	}
-	//copy all attributes from next_to_run process
-	newp->arrival_time = p->arrival_time;
-	newp->cpu_req = p->cpu_req;
-	newp->memory_req = p->memory_req;
-	newp->pid = p->pid;
-	newp->printer_req = p->printer_req;
-	if (p->priority != 3) {
-		newp->priority = p->priority + 1;
+	// next_process leaves its queue and is handed to the cpu as it is
+	remove_process_from_queue(cpu, next_process);
+	handoff_put(cpu, next_process);
+	return true;
+}
+/**
+ * @brief Hand a process to a cpu through its next_to_run slot. Only the
+ * 		scheduler puts, and only into a slot it has emptied with
+ * 		handoff_take(), so a plain release store is enough.
+ * @param p A process no queue holds any more.
+ */
+static void handoff_put(struct hds_cpu_t *cpu, struct process_queue_t *p) {
+	// copy for the cpu to look at, written before p can be taken
+	__atomic_add_fetch(&cpu->next_to_run_seq, 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	cpu->next_to_run_view = *p;
+	__atomic_add_fetch(&cpu->next_to_run_seq, 1, __ATOMIC_RELEASE);
+
+	__atomic_store_n(&cpu->next_to_run, p->handle, __ATOMIC_RELEASE);
+	hds_wakeup_signal(&cpu->cpu_wakeup);
+}
+/**
+ * @brief Empty the next_to_run slot of a cpu. Called by the cpu to run the
+ * 		process, and by the scheduler to take back one not yet run.
+ * @return The process, now owned by the caller, or NULL if slot was empty.
+ */
+static struct process_queue_t *handoff_take(struct hds_cpu_t *cpu) {
+	return hds_pcb_get(
+			__atomic_exchange_n(&cpu->next_to_run, HDS_PCB_NONE,
+					__ATOMIC_ACQ_REL));
+}
+/**
+ * @brief Tells if a process waits in the next_to_run slot of a cpu, and
+ * 		copies it without taking it. The copy is read under a sequence
+ * 		count which only the scheduler writes, so it is never torn; it may
+ * 		be of a process which was taken right after.
+ * @param view Where to copy it, may be NULL.
+ */
+bool hds_core_next_to_run(struct hds_cpu_t *cpu,
+		struct process_queue_t *view) {
+	unsigned long int seq;
+	if (view) {
+		do {
+			seq = __atomic_load_n(&cpu->next_to_run_seq, __ATOMIC_ACQUIRE);
+			*view = cpu->next_to_run_view;
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		} while ((seq & 1)
+				|| seq != __atomic_load_n(&cpu->next_to_run_seq,
+								__ATOMIC_RELAXED));
 	}
-
-	newp->scanner_req = p->scanner_req;
-	//now depending upon the priority of newp insert into a queue
-	switch (newp->priority) {
-	case 0:
-		//it will never be here since a realtime process cant be interrupted anyway
-		break;
-	case 1:
-		// it cant be here as well, since a realtime process in next_to_run process
-		// cant be replaced
-		break;
-	case 2:
-		pthread_mutex_lock(&hds_core_state.p2q_mutex);
-		hds_core_state.p2q_last->next = newp;
-		hds_core_state.p2q_last = newp;
-		hds_core_state.p2q_last->next = NULL;
-		pthread_mutex_unlock(&hds_core_state.p2q_mutex);
-		break;
-	case 3:
-		pthread_mutex_lock(&hds_core_state.p3q_mutex);
-		hds_core_state.p3q_last->next = newp;
-		hds_core_state.p3q_last = newp;
-		hds_core_state.p3q_last->next = NULL;
-		pthread_mutex_unlock(&hds_core_state.p3q_mutex);
-		break;
-	default:
-		break;
+	return __atomic_load_n(&cpu->next_to_run, __ATOMIC_ACQUIRE) != HDS_PCB_NONE;
+}
+/**
+ * @brief Make a process the active process of a cpu.
+ * @param p The process, it is in no queue.
+ */
+void set_active_process(struct hds_cpu_t *cpu, struct process_queue_t *p) {
+	pthread_mutex_lock(&cpu->active_process_lock);
+	cpu->active_process = p;
+	cpu->slice_expired = false;
+
+	//validate active process
+	cpu->active_process_valid = true;
+	pthread_mutex_unlock(&cpu->active_process_lock);
+}
+/**
+ * @brief The active process of a cpu has left the system, the cpu is idle
+ * 		and the block of the process is given back.
+ */
+void hds_core_retire(struct hds_cpu_t *cpu) {
+	struct process_queue_t *p = NULL;
+	pthread_mutex_lock(&cpu->active_process_lock);
+	p = cpu->active_process;
+	cpu->active_process = NULL;
+	cpu->active_process_valid = false;
+	pthread_mutex_unlock(&cpu->active_process_lock);
+	hds_pcb_free(p);
+}
+/**
+ * @brief Put a process back into the queues of its cpu after it was
+ * 		interrupted or replaced. The policy decides where it goes, e.g.
+ * 		feedback puts it one priority level lower than its current one. pid
+ * 		and allocated resources travel along with it.
+ * @param cpu The cpu the process was on, it is queued there again.
+ * @param p The process which is being interrupted/replaced.
+ */
+void degrade_priority_and_save_to_q(struct hds_cpu_t *cpu,
+		struct process_queue_t *p) {
+	p->preemptions++;
+	p->next = NULL;
+	hds_policy_on_preempt(cpu, p);
+	if (enqueue_process(cpu, p) != HDS_OK) {
+		serror("Failed to save an interrupted process to its queue");
 	}
+	hds_wakeup_signal(&hds_core_state.scheduler_wakeup);
 }
-static void remove_process_from_queue(struct process_queue_t *p) {
-	/*
-	 * depending upon type of p, we will remove it from its corresponding queue.
-	 */
-
-	switch (p->priority) {
-	case 0:
-		pthread_mutex_lock(&hds_core_state.rtq_mutex);
-		del_node(&hds_core_state.rtq, p);
-		pthread_mutex_unlock(&hds_core_state.rtq_mutex);
-		break;
-	case 1:
-		while ((pthread_mutex_trylock(&hds_core_state.p1q_mutex) == EBUSY)) {
-			sdebug("someone already has lock of p1q");
-			sleep(1);
-		}
-//		pthread_mutex_lock(&hds_core_state.p1q_mutex);
-		del_node(&hds_core_state.p1q, p);
-		pthread_mutex_unlock(&hds_core_state.p1q_mutex);
-		break;
-	case 2:
-		pthread_mutex_lock(&hds_core_state.p2q_mutex);
-		del_node(&hds_core_state.p2q, p);
-		pthread_mutex_unlock(&hds_core_state.p2q_mutex);
-		break;
-	case 3:
-		pthread_mutex_lock(&hds_core_state.p3q_mutex);
-		del_node(&hds_core_state.p3q, p);
-		pthread_mutex_unlock(&hds_core_state.p3q_mutex);
-		break;
-	default:
-		break;
+/**
+ * @brief Park a process whose request could not be granted until resources
+ * 		are freed. It keeps everything it was given so far.
+ * @param p The process, it is in no queue.
+ */
+void block_on_resources(struct process_queue_t *p) {
+	p->next = NULL;
+	pthread_mutex_lock(&hds_core_state.resource_waitq_lock);
+	if (!hds_core_state.resource_waitq) {
+		hds_core_state.resource_waitq = hds_core_state.resource_waitq_last = p;
+	} else {
+		hds_core_state.resource_waitq_last->next = p;
+		hds_core_state.resource_waitq_last = p;
 	}
+	hds_core_state.resource_waiting++;
+	hds_pcb_track(p, HDS_PCB_RESOURCE_WAIT);
+	pthread_mutex_unlock(&hds_core_state.resource_waitq_lock);
 }
-static void del_node(struct process_queue_t **qhead,
-		struct process_queue_t *to_be_deleted) {
-	struct process_queue_t *tmp = *qhead;
-	if (!qhead) {
-		//thats bad
+/**
+ * @brief Put every parked process back into the queues, they are admitted
+ * 		again once what they wait for fits.
+ */
+static void wake_resource_waiters() {
+	struct process_queue_t *p = NULL, *next = NULL;
+	pthread_mutex_lock(&hds_core_state.resource_waitq_lock);
+	p = hds_core_state.resource_waitq;
+	hds_core_state.resource_waitq = hds_core_state.resource_waitq_last = NULL;
+	hds_core_state.resource_waiting = 0;
+	pthread_mutex_unlock(&hds_core_state.resource_waitq_lock);
+	if (!p) {
 		return;
 	}
-	if (!*qhead) {
-		serror("Trying to delete a NULL node from process queue");
-		return;
+	for (; p; p = next) {
+		next = p->next;
+		p->next = NULL;
+		if (enqueue_process(least_loaded_cpu(), p) != HDS_OK) {
+			serror("Failed to requeue a process which waited for resources");
+		}
 	}
-	//if head is to deleted
-	if (*qhead == to_be_deleted) {
-		tmp = *qhead;
-		*qhead = (*qhead)->next;
-		free(tmp);
-		return;
+	hds_wakeup_signal(&hds_core_state.scheduler_wakeup);
+}
+/**
+ * @brief The active process of a cpu did not get the resources it was
+ * 		admitted for and holds none. It leaves the cpu and is parked until
+ * 		resources are freed, then starts afresh; the cpu is idle.
+ */
+static void wait_for_resources(struct hds_cpu_t *cpu) {
+	struct process_queue_t *p = NULL;
+	hds_resvec_t need, avail;
+	pthread_mutex_lock(&cpu->active_process_lock);
+	p = cpu->active_process;
+	cpu->active_process = NULL;
+	cpu->active_process_valid = false;
+	pthread_mutex_unlock(&cpu->active_process_lock);
+	p->pid = 0;
+	p->start_time = 0;
+	// p may be requeued and taken by another cpu as soon as it is parked
+	need = p->allocate_resource.pending;
+	block_on_resources(p);
+	// resources freed before it was parked did not wake it
+	avail_snapshot(&avail);
+	if (hds_resvec_fits(&need, &avail)) {
+		wake_resource_waiters();
 	}
-	//find the element before to_be_deleted
-	for (; tmp->next != NULL && tmp->next != to_be_deleted; tmp = tmp->next)
-		;
-
-	//now tmp points to the one node before to_be_deleted
-	tmp->next = to_be_deleted->next;
-	tmp = to_be_deleted;
-	free(to_be_deleted);
 }
-static struct process_queue_t *find_next_process_tobe_executed() {
-	struct process_queue_t *node = NULL;
-	//search begins from rtq down to p3q
-
-	pthread_mutex_lock(&hds_core_state.rtq_mutex);
-	//for realtime jobs, the process at head of queue will be executed
-	// that is use fcfs for realtime processes
-	if (hds_core_state.rtq != NULL ) {
-		node = hds_core_state.rtq;
-	}
-	pthread_mutex_unlock(&hds_core_state.rtq_mutex);
-	if (node)
-		return node;
+/**
+ * @brief Queue a process on a cpu, where the policy wants it.
+ * @return HDS_OK else an error code, then p is left to the caller.
+ */
+static int enqueue_process(struct hds_cpu_t *cpu, struct process_queue_t *p) {
+	int rc;
+	pthread_mutex_lock(&cpu->rq_lock);
+	rc = hds_core_state.policy->enqueue(cpu, p);
+	pthread_mutex_unlock(&cpu->rq_lock);
+	return rc;
+}
+/**
+ * @brief No. of processes queued on a cpu.
+ */
+unsigned long int hds_core_queued(struct hds_cpu_t *cpu) {
+	unsigned long int count;
+	pthread_mutex_lock(&cpu->rq_lock);
+	count = hds_core_state.policy->count(cpu);
+	pthread_mutex_unlock(&cpu->rq_lock);
+	return count;
+}
+/**
+ * @brief Remove a process from the queue it currently belongs to. Its block
+ * 		is kept, it goes on to the cpu.
+ * @param cpu The cpu whose run queue holds the process.
+ * @param p A node which was returned by find_next_process_tobe_executed().
+ */
+void remove_process_from_queue(struct hds_cpu_t *cpu,
+		struct process_queue_t *p) {
+	pthread_mutex_lock(&cpu->rq_lock);
+	hds_core_state.policy->dequeue(cpu, p);
+	pthread_mutex_unlock(&cpu->rq_lock);
+}
+/**
+ * @brief Find the process which should run next on the cpu.
+ *
+ * Realtime processes come first, user processes are picked by the policy,
+ * e.g. feedback searches from p1q down to p3q. The first process which passes
+ * the admission test is returned. The node remains in its queue.
+ * @return The selected process or NULL if none could be admitted.
+ */
+struct process_queue_t *find_next_process_tobe_executed(struct hds_cpu_t *cpu) {
+	struct process_queue_t *p = NULL;
+	/*
+	 * A snapshot of the available resources is enough for the admission
+	 * test, they are checked again when they are allocated, so
+	 * avail_resource_mutex is not taken and the run queue lock is the only
+	 * one held for a decision.
+	 */
+	hds_resvec_t avail;
 
-	node = NULL;
-	pthread_mutex_lock(&hds_core_state.p1q_mutex);
-	for (node = hds_core_state.p1q; node != NULL ; node = node->next) {
-		if (can_process_be_admitted(node) == true) {
-			break;
+	avail_snapshot(&avail);
+	pthread_mutex_lock(&cpu->rq_lock);
+	p = hds_core_state.policy->pick_next(cpu, &avail);
+	pthread_mutex_unlock(&cpu->rq_lock);
+	return p;
+}
+/**
+ * @brief Move a process which passes the admission test from the run queue
+ * 		of another cpu to this one.
+ *
+ * Other cpus are tried from the one with most queued processes down. The
+ * process is picked and taken out of its queue under that queue's lock, so
+ * two cpus can never steal the same process.
+ * @return The stolen process, now queued on cpu, or NULL.
+ */
+struct process_queue_t *steal_process(struct hds_cpu_t *cpu) {
+	struct process_queue_t *p = NULL;
+	struct hds_cpu_t *victim = NULL;
+	unsigned long int count, most;
+	unsigned long long int tried = 1ULL << cpu->id;
+	hds_resvec_t avail;
+	int i;
+
+	while (!p) {
+		victim = NULL;
+		most = 0;
+		for (i = 0; i < hds_core_state.ncpus; i++) {
+			if (tried & (1ULL << i)) {
+				continue;
+			}
+			count = hds_core_queued(&hds_core_state.cpu[i]);
+			if (count > most) {
+				victim = &hds_core_state.cpu[i];
+				most = count;
+			}
 		}
-	}
-	pthread_mutex_unlock(&hds_core_state.p1q_mutex);
-	if (node)
-		return node;
-
-	node = NULL;
-	pthread_mutex_lock(&hds_core_state.p2q_mutex);
-	for (node = hds_core_state.p2q; node != NULL ; node = node->next) {
-		if (can_process_be_admitted(node) == true) {
-			break;
+		if (!victim) {
+			return NULL;
 		}
-	}
-	pthread_mutex_unlock(&hds_core_state.p2q_mutex);
-	if (node)
-		return node;
-
-	node = NULL;
-	pthread_mutex_lock(&hds_core_state.p3q_mutex);
-	for (node = hds_core_state.p3q; node != NULL ; node = node->next) {
-		if (can_process_be_admitted(node) == true) {
-			break;
+		tried |= 1ULL << victim->id;
+		avail_snapshot(&avail);
+		pthread_mutex_lock(&victim->rq_lock);
+		p = hds_core_state.policy->pick_next(victim, &avail);
+		if (p) {
+			hds_core_state.policy->dequeue(victim, p);
 		}
+		pthread_mutex_unlock(&victim->rq_lock);
 	}
-	pthread_mutex_unlock(&hds_core_state.p3q_mutex);
-	return node;
-}
-/**
- * @brief Check if this process can be admitted to cpu for executing in the next
- * 			cycle.
- * @param next_to_run The process which is to be tested.
- * @return true/false indicating whether this processes passed the admission test
- * 			or not.
- */
-static bool can_process_be_admitted(struct process_queue_t *next_to_run) {
-	bool can_be_admitted = false;
-	pthread_mutex_lock(&max_available_resource.avail_resource_mutex);
-	if ((next_to_run->memory_req < max_available_resource.avail_memory)) {
-		can_be_admitted = true;
+	if (enqueue_process(cpu, p) != HDS_OK) {
+		// give it back, it stays where it was queued
+		if (enqueue_process(victim, p) != HDS_OK) {
+			serror("Failed to return a stolen process to its queue");
+			hds_pcb_free(p);
+		}
+		return NULL;
 	}
-	pthread_mutex_unlock(&max_available_resource.avail_resource_mutex);
-	return can_be_admitted;
+	cpu->steals++;
+	return p;
 }
 /**
  * @Main routine for cpu thread
- * @param args
+ * @param args The struct hds_cpu_t this thread runs.
  */
 void *hds_cpu(void *args) {
 	/*
@@ -602,11 +1051,14 @@ void *hds_cpu(void *args) {
 	 * 7. Update stats as necessary.
 	 * 8.
 	 */
-	int status;
+	struct hds_cpu_t *cpu = (struct hds_cpu_t *) args;
+	struct process_queue_t *next = NULL, *prev = NULL, view;
+	unsigned long int seen, ran, used;
 	while (1) {
 		if (hds_state.shutdown_in_progress == true) {
 			break;
 		}
+		seen = hds_wakeup_seq(&cpu->cpu_wakeup);
 //		var_debug("cpu: parent: %d, I belong to %d process",
 //				hds_state.parent_pid, getpid());
 		/*
@@ -615,101 +1067,62 @@ void *hds_cpu(void *args) {
 		 * what if next_to_run process is invalid simply because scheduler did
 		 * not give us any process but current process can be executed. ?
 		 */
-		if ((hds_core_state.next_to_run_process_valid == false)
-				&& (hds_core_state.active_process_valid == false)) {
-			swarn("cpu: No valid process in next_to_run process.");
-			sleep(1);
+		if (cpu->active_process_valid == false
+				&& hds_core_next_to_run(cpu, NULL ) == false) {
+			// sleep until scheduler publishes a next_to_run process
+			hds_wakeup_wait(&cpu->cpu_wakeup, seen);
 			continue;
 		}
 		/*
 		 * although scheduler has made sure that next_to_run process will be at higher
 		 * priority than the current process but before setting it active we will
-		 * do a check.
+		 * do a check. It is made on a copy of next_to_run process, the process
+		 * itself is only touched once it has been taken out of the slot.
 		 */
-		if (hds_core_state.active_process_valid == false) {
+		if (cpu->active_process_valid == false) {
 			/*
 			 * this is the initial condition. we will set the next_to_run process
-			 * as the active process.
+			 * as the active process, unless scheduler took it back meanwhile.
 			 */
-			pthread_mutex_lock(&hds_core_state.active_process_lock);
-			hds_core_state.active_process.arrival_time =
-					hds_core_state.next_to_run_process.arrival_time;
-			hds_core_state.active_process.cpu_req =
-					hds_core_state.next_to_run_process.cpu_req;
-			hds_core_state.active_process.memory_req =
-					hds_core_state.next_to_run_process.memory_req;
-			hds_core_state.active_process.pid =
-					hds_core_state.next_to_run_process.pid; // this should be zero for a beginning process
-			hds_core_state.active_process.printer_req =
-					hds_core_state.next_to_run_process.printer_req;
-			hds_core_state.active_process.priority =
-					hds_core_state.next_to_run_process.priority;
-			hds_core_state.active_process.scanner_req =
-					hds_core_state.next_to_run_process.scanner_req;
-
-			//validate active process
-			hds_core_state.active_process_valid = true;
-			pthread_mutex_unlock(&hds_core_state.active_process_lock);
-			//now invalidate the next_to_run process.
-			pthread_mutex_lock(&hds_core_state.next_to_run_process_lock);
-			hds_core_state.next_to_run_process_valid = false;
-			pthread_mutex_unlock(&hds_core_state.next_to_run_process_lock);
-		} else {
+			if (!(next = handoff_take(cpu))) {
+				continue;
+			}
+			set_active_process(cpu, next);
+			//next_to_run slot is free again
+			hds_wakeup_signal(&hds_core_state.scheduler_wakeup);
+		} else if (hds_core_next_to_run(cpu, &view) == true
+				&& hds_policy_should_switch(&view, cpu->active_process,
+						cpu->slice_expired)) {
 			/*
-			 * active process has been serviced by cpu. so we will check if next
-			 * run process's priority is higher as compared to active process.
-			 * if not then we will continue executing active process. If yes
-			 * then we will degrade priority of active  process and move it back
-			 * to qeueues and set next_to_run process as the active process.
+			 * active process has been serviced by cpu. next run process's
+			 * priority is higher as compared to active process, so we will
+			 * degrade priority of active process and move it back to
+			 * queues and set next_to_run process as the active process.
 			 */
-			if ((hds_core_state.next_to_run_process.priority
-					< hds_core_state.active_process.priority)
-					&& (hds_core_state.next_to_run_process_valid == true)) {
+			if ((next = handoff_take(cpu))) {
 				var_debug(
 						"cpu: Interrupting active process with process(PID:%d PRI:%d CPU:%d MEM:%d PRN:%d SCN:%d)",
-						hds_core_state.next_to_run_process.pid,
-						hds_core_state.next_to_run_process.priority,
-						hds_core_state.next_to_run_process.cpu_req,
-						hds_core_state.next_to_run_process.memory_req,
-						hds_core_state.next_to_run_process.printer_req,
-						hds_core_state.next_to_run_process.scanner_req);
-				//current process will be interrupted.
-				degrade_priority_and_save_to_q(&hds_core_state.active_process);
-				pthread_mutex_lock(&hds_core_state.active_process_lock);
-				//now set next_process as the active process
-				hds_core_state.active_process.arrival_time =
-						hds_core_state.next_to_run_process.arrival_time;
-				hds_core_state.active_process.cpu_req =
-						hds_core_state.next_to_run_process.cpu_req;
-				hds_core_state.active_process.memory_req =
-						hds_core_state.next_to_run_process.memory_req;
-				hds_core_state.active_process.pid =
-						hds_core_state.next_to_run_process.pid; // this should be zero for a beginning process
-				hds_core_state.active_process.printer_req =
-						hds_core_state.next_to_run_process.printer_req;
-				hds_core_state.active_process.priority =
-						hds_core_state.next_to_run_process.priority;
-				hds_core_state.active_process.scanner_req =
-						hds_core_state.next_to_run_process.scanner_req;
-
-				//validate active process
-				hds_core_state.active_process_valid = true;
-				pthread_mutex_unlock(&hds_core_state.active_process_lock);
-				//now invalidate the next_to_run process.
-				pthread_mutex_lock(&hds_core_state.next_to_run_process_lock);
-				hds_core_state.next_to_run_process_valid = false;
-				pthread_mutex_unlock(&hds_core_state.next_to_run_process_lock);
+						next->pid, next->priority, next->cpu_req,
+						next->req[HDS_RES_MEMORY], next->req[HDS_RES_PRINTER],
+						next->req[HDS_RES_SCANNER]);
+				//current process will be interrupted. It is queued only
+				// once it is no longer active, else scheduler could hand
+				// it back to this cpu in between.
+				prev = cpu->active_process;
+				set_active_process(cpu, next);
+				degrade_priority_and_save_to_q(cpu, prev);
+				hds_wakeup_signal(&hds_core_state.scheduler_wakeup);
 			}
-			//else we will continue executing active process.
 		}
+		//else we will continue executing active process.
 
 		/*
 		 * if still we have an invalid active process then we go up. This will
 		 * ensure that we do not deal with bogus processes.
 		 */
-		if (hds_core_state.active_process_valid == false) {
+		if (cpu->active_process_valid == false) {
 			serror("Active process is invalid..");
-			sleep(1);
+			hds_wakeup_wait(&cpu->cpu_wakeup, seen);
 			continue;
 		}
 		// from here onwards we will have a valid active process
@@ -722,25 +1135,24 @@ void *hds_cpu(void *args) {
 		 * 2. deallocate resources
 		 * 3. invalidate active process
 		 */
-		if (hds_core_state.active_process.cpu_req <= 0) {
-			if (hds_core_state.active_process.pid > 1) {
+		if (cpu->active_process->cpu_req <= 0) {
+			if (cpu->active_process->pid > 1) {
 				//kill it
 				var_debug("cpu: killing child process: %d",
-						hds_core_state.active_process.pid);
-				//remember that child process is already stopped so before
-				// killing it we will activate it
-				kill(hds_core_state.active_process.pid, SIGCONT);
-				//now kill it
-				kill(hds_core_state.active_process.pid, SIGTERM);
+						cpu->active_process->pid);
+				hds_exec_reap(cpu->active_process);
 
 				// *****deallocate resources *****
-				free_resources(&hds_core_state.active_process);
-				//collect this process
-				waitpid(hds_core_state.active_process.pid, &status, WNOHANG);
+				free_resources(cpu->active_process);
+				hds_policy_on_complete(cpu, cpu->active_process);
+				hds_report_job(cpu->active_process,
+						HDS_JOB_COMPLETED);
 
 				//invalidate it, such that it will be set as next_to_run process
 				// in next cycle
-				hds_core_state.active_process_valid = false;
+				hds_core_retire(cpu);
+				//cpu is idle and resources have been freed
+				hds_wakeup_signal(&hds_core_state.scheduler_wakeup);
 
 				print_memory_maps();
 				//now go up
@@ -762,108 +1174,242 @@ void *hds_cpu(void *args) {
 		 * in the active process. execute it for 1 quantum and then update stats.
 		 *
 		 */
-		if (hds_core_state.active_process.pid == 0) {
-			// this is the first time for this process. we will fork a new child
-			// process
-			hds_core_state.active_process.pid = fork();
-			switch (hds_core_state.active_process.pid) {
-			case -1:
-				serror("cpu: fork() failed")
-				;
-				//this is bad
-				break;
-			case 0:
-				child_function();
-				break;
-			default:
-				//parent code
-				/*
-				 * since child is in an infinite loop. it will not come back
-				 * to execute next lines code. So we can continue our work even
-				 * though entire code will be duplicated in child.
-				 *
-				 * Since child will become active the moment it will be instantiated
-				 * we stop it here so that we will run it later on.
-				 */
-				kill(hds_core_state.active_process.pid, SIGSTOP);
-				var_debug("cpu: spawned new child process: %d",
-						hds_core_state.active_process.pid)
-				;
+		if (cpu->active_process->pid == 0) {
+			// this is the first time for this process. the execution backend
+			// creates it, e.g. a child process on a parked worker or forked
+			cpu->active_process->start_time = hds_core_now();
+			if (hds_exec_spawn(cpu->active_process) != HDS_OK) {
+				serror("cpu: Failed to create process, will try again");
+				hds_wakeup_wait(&cpu->cpu_wakeup, seen);
+				continue;
+			}
+			var_debug("cpu: spawned new child process: %d",
+					cpu->active_process->pid);
+			/*
+			 * Our resource allocation routine requires the pid therefore,
+			 * we will perform resource allocation once we have obtained the
+			 * pid.
+			 */
+			// ****do the resource allocation here ******
+			if (allocate_resources(cpu->active_process) != HDS_OK) {
 				/*
-				 * Our resource allocation routine requires the pid therefore,
-				 * we will perform resource allocation once we have obtained the
-				 * pid.
+				 * it was admitted, so it fits in what there is: another cpu,
+				 * admitted against the same snapshot, got there first.
 				 */
-				// ****do the resource allocation here ******
-				if (allocate_resources(&hds_core_state.active_process) != HDS_OK) {
-					serror("Resource allocation failed.");
-					var_debug("cpu: killing premature child process: %d",
-							hds_core_state.active_process.pid);
-					kill(hds_core_state.active_process.pid, SIGCONT);
-					kill(hds_core_state.active_process.pid, SIGTERM);
-
-					waitpid(hds_core_state.active_process.pid, &status,
-							WNOHANG);
-
-					//invalidate it, such that it will be set as next_to_run process
-					// in next cycle
-					hds_core_state.active_process_valid = false;
-					//now go up
-					continue;
-				}
-				print_memory_maps();
-				break;
+				var_debug("cpu %d: resources of process %d were taken meanwhile, it waits for them",
+						cpu->id, cpu->active_process->pid);
+				hds_exec_reap(cpu->active_process);
+				wait_for_resources(cpu);
+				hds_wakeup_signal(&hds_core_state.scheduler_wakeup);
+				//now go up
+				continue;
 			}
+			print_memory_maps();
 		}
-		// The code following next, will never be executed in child.
-		// if not then, behaviour is undefined
 		var_debug(
 				"cpu: Going to run process(PID:%d PRI:%d CPU:%d MEM:%d PRN:%d SCN:%d)",
-				hds_core_state.active_process.pid,
-				hds_core_state.active_process.priority,
-				hds_core_state.active_process.cpu_req,
-				hds_core_state.active_process.memory_req,
-				hds_core_state.active_process.printer_req,
-				hds_core_state.active_process.scanner_req);
-
+				cpu->active_process->pid,
+				cpu->active_process->priority,
+				cpu->active_process->cpu_req,
+				cpu->active_process->req[HDS_RES_MEMORY],
+				cpu->active_process->req[HDS_RES_PRINTER],
+				cpu->active_process->req[HDS_RES_SCANNER]);
+
+		if (cpu->active_process->ready_ns != 0) {
+			// a realtime process gets a cpu for the first time
+			hds_report_rt_latency(
+					hds_core_clock_ns() - cpu->active_process->ready_ns);
+			cpu->active_process->ready_ns = 0;
+		}
 		//now run the child process
-		kill(hds_core_state.active_process.pid, SIGCONT);
-		sleep(1);
-		kill(hds_core_state.active_process.pid, SIGSTOP);
+		ran = run_quantum(cpu, &used);
 
 		//now update stats for this process
-		pthread_mutex_lock(&hds_core_state.active_process_lock);
-		hds_core_state.active_process.cpu_req =
-				hds_core_state.active_process.cpu_req - 1;
-		pthread_mutex_unlock(&hds_core_state.active_process_lock);
+		pthread_mutex_lock(&cpu->active_process_lock);
+		cpu->active_process->wall_ns += ran;
+		cpu->active_process->cpu_ns += used;
+		/*
+		 * charged for what it ran, or for the CPU time it got out of that.
+		 * Quanta cut short or short of CPU time are charged once the parts
+		 * add up to a whole quantum.
+		 */
+		cpu->active_process->run_ns +=
+				hds_config.cpu_accounting == HDS_ACCOUNT_CPU ? used : ran;
+		if (cpu->active_process->run_ns >= HDS_QUANTUM_NS) {
+			cpu->active_process->run_ns -= HDS_QUANTUM_NS;
+			cpu->active_process->cpu_req =
+					cpu->active_process->cpu_req - 1;
+			cpu->slice_expired = hds_policy_on_tick(cpu,
+					cpu->active_process);
+		}
+		pthread_mutex_unlock(&cpu->active_process_lock);
 	}
-	sdebug("cpu: Shutting down..");
+	var_debug("cpu %d: Shutting down..", cpu->id);
 	/*
 	 * TODO: we need a cleanup routine which will find all child processes who have been
 	 * spwaned and kill them. we can find such processes by examining all 4 queues
 	 * and looking for a process with pid > 1.
 	 */
+	pthread_exit(NULL );
+}
+/**
+ * @brief Let the active process of a cpu run for a quantum. The quantum is
+ * 		cut short as soon as a realtime process is handed to the cpu while
+ * 		the active one is not realtime, so the realtime process waits for no
+ * 		more than the handoff and not for the rest of the quantum. Nothing
+ * 		polls for it: the handoff signals cpu_wakeup, which ends the slice.
+ * 		It is cut short by shutdown too.
+ * @param used Set to the CPU time it consumed meanwhile, as far as the
+ * 		execution backend can tell; else to the time it ran.
+ * @return Nanoseconds it ran, HDS_QUANTUM_NS for a whole quantum.
+ */
+static unsigned long int run_quantum(struct hds_cpu_t *cpu,
+		unsigned long int *used) {
+	struct process_queue_t view;
+	unsigned long int start, now, seen, cpu_start, cpu_end;
+	struct timespec end;
+	bool preempted = false, expired = false, measured;
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	end.tv_sec += SMALLEST_TIME_QUANTUM;
+	start = hds_core_clock_ns();
+	measured = hds_exec_cpu_time(cpu->active_process, &cpu_start) == HDS_OK;
+	hds_exec_resume(cpu->active_process);
+	while (1) {
+		// anything handed over from here on cuts the wait below short
+		seen = hds_wakeup_seq(&cpu->cpu_wakeup);
+		now = hds_core_clock_ns();
+		if (now - start >= HDS_QUANTUM_NS) {
+			expired = true;
+			break;
+		}
+		if (hds_state.shutdown_in_progress == true) {
+			break;
+		}
+		if (cpu->active_process->priority != 0
+				&& hds_core_next_to_run(cpu, &view) == true
+				&& view.priority == 0) {
+			preempted = true;
+			break;
+		}
+		hds_exec_slice(cpu->active_process, &cpu->cpu_wakeup, seen, &end);
+	}
+	hds_exec_pause(cpu->active_process);
+	if (expired) {
+		now = start + HDS_QUANTUM_NS;
+	}
+	*used = now - start;
+	if (measured
+			&& hds_exec_cpu_time(cpu->active_process, &cpu_end) == HDS_OK) {
+		*used = cpu_end > cpu_start ? cpu_end - cpu_start : 0;
+	} else if (hds_config.cpu_accounting == HDS_ACCOUNT_CPU) {
+		var_warn("cpu %d: CPU time of process %d unknown, charging the time it ran",
+				cpu->id, cpu->active_process->pid);
+	}
+	if (expired) {
+		return HDS_QUANTUM_NS;
+	}
+	if (preempted) {
+		cpu->rt_preemptions++;
+		var_debug("cpu %d: quantum of process %d cut short after %lu us for a realtime process",
+				cpu->id, cpu->active_process->pid, (now - start) / 1000);
+	}
+	return now - start;
+}
+/**
+ * @brief Start one cpu thread for every simulated cpu.
+ * @return HDS_OK on success else HDS_ERR_THREAD_INIT.
+ */
+int hds_cpus_start() {
+	int i;
+	// e.g. workers are parked before any cpu can ask for one
+	if (hds_exec_start() != HDS_OK) {
+		var_error("Failed to start execution backend: %s", hds_exec_name());
+		return HDS_ERR_THREAD_INIT;
+	}
+	for (i = 0; i < hds_core_state.ncpus; i++) {
+		if (pthread_create(&hds_core_state.cpu[i].thread, NULL, hds_cpu,
+				&hds_core_state.cpu[i]) != 0) {
+			var_error("Failed to create thread: hds_cpu %d", i);
+			// only the cpus which were started are joined
+			hds_core_state.ncpus = i;
+			return HDS_ERR_THREAD_INIT;
+		}
+	}
+	return HDS_OK;
+}
+/**
+ * @brief Collect every cpu thread. Memory blocks are only released once the
+ * 		last cpu has stopped, as any of them may still free its process.
+ */
+void hds_cpus_join() {
+	int i;
+	for (i = 0; i < hds_core_state.ncpus; i++) {
+		if (pthread_join(hds_core_state.cpu[i].thread, NULL ) != 0) {
+			var_error("Error in collecting thread: hds_cpu %d", i);
+		}
+	}
+	hds_exec_stop();
 	sdebug("cpu: Cleaning up mem_block_list");
 	cleanup_mem_block_list(hds_core_state.mem_block_list);
-	pthread_exit(NULL );
 }
 /**
  * @brief This routine must do all the resource allocation for a given process.
  * 	   Therefore it will recieve a process structure which will define the
  * 	   resource requirements for that process.
  */
-static int allocate_resources(struct process_queue_t *process) {
+int allocate_resources(struct process_queue_t *process) {
+	struct hds_allocated_resource_t *res = &process->allocate_resource;
 	unsigned int mem_handle = -1;
+	hds_resvec_t devices = res->pending;
+	int rc = HDS_ERR_NO_RESOURCE;
 	if (process->pid == -1) {
 		return HDS_ERR_INVALID_PROCESS;
 	}
-	//begin memory allocation for this routine.
-	if ((mem_handle = allocate_mem(process->pid, process->memory_req)) == 0) {
-		return HDS_ERR_NO_RESOURCE;
+	// every kind but memory asked for is taken in one step, all of it or none
+	devices[HDS_RES_MEMORY] = 0;
+	pthread_mutex_lock(&max_available_resource.avail_resource_mutex);
+	if (hds_resvec_fits(&devices, &max_available_resource.avail)) {
+		rc = HDS_OK;
+		if (hds_config.deadlock_avoidance == HDS_AVOID_BANKER) {
+			rc = hds_resvec_fits(&res->pending,
+					&max_available_resource.avail) ?
+					hds_banker_grant(&max_available_resource.banker,
+							&res->banker_slot, &process->req, &res->pending,
+							&max_available_resource.avail) :
+					HDS_ERR_NO_RESOURCE;
+		}
+		if (rc == HDS_OK) {
+			max_available_resource.avail -= devices;
+		}
 	}
-
-	//mem_handle is a valid one
-	process->allocate_resource.mem_block_handle = mem_handle;
+	pthread_mutex_unlock(&max_available_resource.avail_resource_mutex);
+	if (rc != HDS_OK) {
+		return rc;
+	}
+	// memory comes with the first request
+	if (res->stage == 0) {
+		//begin memory allocation for this routine.
+		pthread_mutex_lock(&hds_core_state.mem_lock);
+		mem_handle = allocate_mem(process->pid, res->pending[HDS_RES_MEMORY]);
+		pthread_mutex_unlock(&hds_core_state.mem_lock);
+		if (mem_handle == 0) {
+			pthread_mutex_lock(&max_available_resource.avail_resource_mutex);
+			max_available_resource.avail += devices;
+			if (res->banker_slot >= 0) {
+				hds_banker_release(&max_available_resource.banker,
+						res->banker_slot);
+				res->banker_slot = -1;
+			}
+			pthread_mutex_unlock(&max_available_resource.avail_resource_mutex);
+			return HDS_ERR_NO_RESOURCE;
+		}
+		//mem_handle is a valid one
+		res->mem_block_handle = mem_handle;
+	}
+	res->devices += devices;
+	hds_resvec_fill(&res->pending, 0);
+	res->stage++;
 	return HDS_OK;
 }
 /**
@@ -871,96 +1417,132 @@ static int allocate_resources(struct process_queue_t *process) {
  * @param process The process which is to be dealocated.
  * @return
  */
-static int free_resources(struct process_queue_t *process) {
-	// as of now we only free memory allocated to this process
+int free_resources(struct process_queue_t *process) {
+	pthread_mutex_lock(&hds_core_state.mem_lock);
 	free_mem(process->pid, process->allocate_resource.mem_block_handle);
+	pthread_mutex_unlock(&hds_core_state.mem_lock);
+	pthread_mutex_lock(&max_available_resource.avail_resource_mutex);
+	max_available_resource.avail += process->allocate_resource.devices;
+	if (process->allocate_resource.banker_slot >= 0) {
+		hds_banker_release(&max_available_resource.banker,
+				process->allocate_resource.banker_slot);
+		process->allocate_resource.banker_slot = -1;
+	}
+	pthread_mutex_unlock(&max_available_resource.avail_resource_mutex);
+	wake_resource_waiters();
 	return HDS_OK;
 }
-static void child_function() {
-	/*
-	 * what our processes would do ? Since I am not sure about whether debug()
-	 * routines would work in this situation. for now child process simply sleep
-	 * for a while. again back in infinite loop.
-	 */
-	while (1) {
-//		var_debug("Child process with PID: %d working.", getpid());
-//		if (hds_state.shutdown_in_progress){
-//			exit(EXIT_SUCCESS);
-//		}
-		usleep(1000);
+/**
+ * @brief With staged acquisition, set the next request of a process which
+ * 		has run when it is due: a process with d device kinds asks for the
+ * 		s'th one once it has had s/d of its cpu time.
+ * @return true if p now has a request pending.
+ */
+bool hds_core_next_request(struct process_queue_t *p) {
+	struct hds_allocated_resource_t *res = &p->allocate_resource;
+	int d, lane;
+	if (hds_config.acquisition != HDS_ACQUIRE_STAGED || res->stage == 0) {
+		return false;
 	}
+	d = device_kinds(p);
+	if (res->stage >= d
+			|| (long int) (p->cpu_total - p->cpu_req) * d
+					< (long int) res->stage * p->cpu_total) {
+		return false;
+	}
+	lane = staged_kind(p, res->stage);
+	hds_resvec_fill(&res->pending, 0);
+	res->pending[lane] = p->req[lane];
+	return true;
+}
+/**
+ * @brief Tells if a process whose request cannot be granted waits for
+ * 		resources (block_on_resources()) instead of failing.
+ */
+bool hds_core_waits_for_resources() {
+	return hds_config.acquisition == HDS_ACQUIRE_STAGED
+			|| hds_config.deadlock_avoidance == HDS_AVOID_BANKER;
+}
+/**
+ * @brief Set the request a process makes before it first runs: everything
+ * 		it needs, or with staged acquisition its memory and the first of its
+ * 		device kinds.
+ */
+static void first_request(struct process_queue_t *p) {
+	hds_resvec_t *pending = &p->allocate_resource.pending;
+	int lane;
+	if (hds_config.acquisition != HDS_ACQUIRE_STAGED) {
+		*pending = p->req;
+		return;
+	}
+	hds_resvec_fill(pending, 0);
+	(*pending)[HDS_RES_MEMORY] = p->req[HDS_RES_MEMORY];
+	if (device_kinds(p) > 0) {
+		lane = staged_kind(p, 0);
+		(*pending)[lane] = p->req[lane];
+	}
+}
+/**
+ * @brief No. of device kinds a process needs any units of.
+ */
+static int device_kinds(const struct process_queue_t *p) {
+	int i, d = 0;
+	for (i = HDS_RES_MEMORY + 1; i < hds_config.max_resources.kinds; i++) {
+		if (p->req[i] > 0) {
+			d++;
+		}
+	}
+	return d;
+}
+/**
+ * @brief Lane of the device kind a process asks for in its step'th request.
+ * 		Every process goes through its kinds in lane order but starts from a
+ * 		different one, so processes may hold what the other waits for.
+ */
+static int staged_kind(const struct process_queue_t *p, int step) {
+	int i, k = (p->job_id + step) % device_kinds(p);
+	for (i = HDS_RES_MEMORY + 1; i < hds_config.max_resources.kinds; i++) {
+		if (p->req[i] > 0 && k-- == 0) {
+			break;
+		}
+	}
+	return i;
 }
 // //////////// Simple API for dealing with queues of type process_t //////
-static int insert_process_to_q_from_user_job_q(struct process_queue_t **qhead,
-		struct process_queue_t **q_last,
+static int insert_process_to_runq_from_user_job_q(struct hds_cpu_t *cpu,
 		struct process_queue_t *process_frm_user_jobq) {
-	struct process_queue_t *node = NULL;
-	node = (struct process_queue_t *) malloc(sizeof(struct process_queue_t));
-	if (!node) {
-		serror("malloc: failed ");
-		return HDS_ERR_NO_MEM;
-	}
 	//TODO: since granularity is in seconds,get time in seconds
-	node->arrival_time = gettime_in_nsecs();
-
-	node->cpu_req = process_frm_user_jobq->cpu_req;
-	node->memory_req = process_frm_user_jobq->memory_req;
-	node->printer_req = process_frm_user_jobq->printer_req;
-	node->priority = process_frm_user_jobq->priority;
-	node->scanner_req = process_frm_user_jobq->scanner_req;
-	node->pid = process_frm_user_jobq->pid;
-	node->next = NULL;
-
-	if (!*qhead || !*q_last) {
-		//initial state or case where there is only one element in the user job
-		// q and that has been deleted.
-		*q_last = *qhead = node;
-	} else {
-		(*q_last)->next = node;
-		*q_last = node;
-		(*q_last)->next = NULL;
+	process_frm_user_jobq->arrival_time = hds_core_now();
+	process_frm_user_jobq->next = NULL;
+	if (enqueue_process(cpu, process_frm_user_jobq) != HDS_OK) {
+		return HDS_ERR_INVALID_PROCESS;
 	}
 	return HDS_OK;
 }
-static int remove_first_ele_from_user_job_q(struct process_queue_t **user_job_q) {
-	//remove the first element
-	struct process_queue_t *to_be_deleted = *user_job_q;
-	if (hds_core_state.user_job_q == NULL ) {
+/**
+ * @brief Unlink the first process of the user job queue, it is kept.
+ * @return The process or NULL if queue is empty.
+ */
+static struct process_queue_t *remove_first_ele_from_user_job_q(
+		struct process_queue_t **user_job_q) {
+	struct process_queue_t *first = *user_job_q;
+	if (!first) {
 		swarn("User Job queue is empty !! Nothing to remove");
-		return HDS_OK;
-	}
-	//	var_debug("Removing [%u] next [%u]",to_be_deleted->page.page_id,((*node)->next)->page.page_id);
-	//	var_debug("Trying to remove page %u", (*node)->page.page_id);
-	// first case itself should handle head being null. this one is not needed.
-	if (!*user_job_q) {
-		serror("Trying to delete a NULL page from user job q");
-		return HDS_ERR_MEM_FAULT;
+		return NULL;
 	}
-	// &hds_
-	hds_core_state.user_job_q = (*user_job_q)->next;
-	free(to_be_deleted);
-	return HDS_OK;
+	*user_job_q = first->next;
+	first->next = NULL;
+	hds_pcb_track(first, HDS_PCB_HELD);
+	return first;
 }
 
 static int insert_process_to_q_from_dispatch_list(
 		struct process_queue_t **qhead, struct process_queue_t **q_last,
 		struct hds_process_t *process_frm_dispatch_list) {
 	struct process_queue_t *node = NULL;
-	node = (struct process_queue_t *) malloc(sizeof(struct process_queue_t));
-	if (!node) {
-		serror("malloc: failed ");
+	if (!(node = new_node_from_dispatch_list(process_frm_dispatch_list))) {
 		return HDS_ERR_NO_MEM;
 	}
-	//TODO: since granularity is in seconds,get time in seconds
-	node->arrival_time = gettime_in_nsecs();
-
-	node->cpu_req = process_frm_dispatch_list->cpu_req;
-	node->memory_req = process_frm_dispatch_list->memory_req;
-	node->printer_req = process_frm_dispatch_list->printer_req;
-	node->priority = process_frm_dispatch_list->priority;
-	node->scanner_req = process_frm_dispatch_list->scanner_req;
-	node->pid = process_frm_dispatch_list->pid;
-	node->next = NULL;
 
 	if (!*qhead || !*q_last) {
 		//initial state
@@ -970,97 +1552,40 @@ static int insert_process_to_q_from_dispatch_list(
 		*q_last = node;
 		(*q_last)->next = NULL;
 	}
+	hds_pcb_track(node, HDS_PCB_USER_JOBQ);
 	return HDS_OK;
 }
-//static struct process_queue_t * get_first_element(struct process_queue_t *qhead) {
-//
-//}
-static int remove_first_ele_from_dispatcher_q(
-		struct hds_process_t **dispatcher_list_head) {
-	//remove the first element
-	struct hds_process_t *to_be_deleted = *dispatcher_list_head;
-	if (hds_config.job_dispatch_list == NULL ) {
-		swarn("Job dispatch queue is empty !! Nothing to remove");
-		return HDS_OK;
-	}
-	//	var_debug("Removing [%u] next [%u]",to_be_deleted->page.page_id,((*node)->next)->page.page_id);
-	//	var_debug("Trying to remove page %u", (*node)->page.page_id);
-	// first case itself should handle head being null. this one is not needed.
-	if (!*dispatcher_list_head) {
-		serror("Trying to delete a NULL page from dispatch queue");
-		return HDS_ERR_MEM_FAULT;
+/**
+ * @brief Make a process queue node for a process which has just arrived.
+ * @return The node or NULL if memory could not be allocated.
+ */
+static struct process_queue_t *new_node_from_dispatch_list(
+		struct hds_process_t *process_frm_dispatch_list) {
+	struct process_queue_t *node = NULL;
+	if (!(node = hds_pcb_alloc())) {
+		return NULL;
 	}
+	//TODO: since granularity is in seconds,get time in seconds
+	node->arrival_time = hds_core_now();
 
-	hds_config.job_dispatch_list = (*dispatcher_list_head)->next;
-	free(to_be_deleted);
-	return HDS_OK;
-}
-
-void print_current_cpu_stats() {
-	/*
-	 * We will print info about active process,next_to_run_process and available
-	 * resources when demanded.
-	 */
-	sprint_result("<C>System Statistics");
-	sprint_result("<C>Resource Status");
-	sprint_result("\t\t\tMemory\tPrinter\tScanner");
-	vprint_result("Max. Resources: \t%d\t%d\t%d",
-			hds_config.max_resources.memory, hds_config.max_resources.printer,
-			hds_config.max_resources.scanner);
-	pthread_mutex_lock(&max_available_resource.avail_resource_mutex);
-	vprint_result("Avail. Resources: \t%d\t%d\t%d",
-			max_available_resource.avail_memory,
-			max_available_resource.avail_printer,
-			max_available_resource.avail_scanner);
-	pthread_mutex_unlock(&max_available_resource.avail_resource_mutex);
-	sprint_result("<C>Process Status");
-	sprint_result("\t\t PID\tPRI\tCPU_REQ\tMEM_REQ\tPRN_REQ\tSCN_REQ");
-	pthread_mutex_lock(&hds_core_state.active_process_lock);
-	vprint_result("Active:\t\t%d\t%d\t%d\t%d\t%d\t%d",
-			hds_core_state.active_process.pid,
-			hds_core_state.active_process.priority,
-			hds_core_state.active_process.cpu_req,
-			hds_core_state.active_process.memory_req,
-			hds_core_state.active_process.printer_req,
-			hds_core_state.active_process.scanner_req);
-	pthread_mutex_unlock(&hds_core_state.active_process_lock);
-	pthread_mutex_lock(&hds_core_state.next_to_run_process_lock);
-	vprint_result("NextSchdld:\t%d\t%d\t%d\t%d\t%d\t%d",
-			hds_core_state.next_to_run_process.pid,
-			hds_core_state.next_to_run_process.priority,
-			hds_core_state.next_to_run_process.cpu_req,
-			hds_core_state.next_to_run_process.memory_req,
-			hds_core_state.next_to_run_process.printer_req,
-			hds_core_state.next_to_run_process.scanner_req);
-	pthread_mutex_unlock(&hds_core_state.next_to_run_process_lock);
-	// we can print the original loaded process dispactch queue
-	// we will need to maintain one extra field in process structure that is name.
-	// it can be populated at runtime by dispatcher and will help in giving a
-	// proper identification. names will be like: P1,P2,P3 etc. Note that name will
-	// be just an integer but when accessing it, prefix it by 'P'
-	// also we will maintaina execution queue which will be an array maintained
-	// by cpu thread which will just point out that for every quantum which process
-	// was executed. like : 1,3,3,3,2,1,4,1 but will be printed as :
-	// P1,P3,P3,P3,P2,P1,P4,P1
-	// also print lets say 20 such entries per line only.
-}
-void *hds_stats_manager(void *args) {
-	while (1) {
-		if (hds_state.shutdown_in_progress == true) {
-			break;
-		}
-		if (hds_state.stats_manager_active == true) {
-			clear_result_window();
-			print_current_cpu_stats();
-			sleep(1);
-		} else {
-			sleep(1);
-		}
-	}
-	sdebug("stats manager shutting down");
-	pthread_exit(NULL );
+	node->cpu_req = process_frm_dispatch_list->cpu_req;
+	node->req = process_frm_dispatch_list->req;
+	node->kernel = process_frm_dispatch_list->kernel;
+	node->priority = process_frm_dispatch_list->priority;
+	node->pid = process_frm_dispatch_list->pid;
+	node->job_id = process_frm_dispatch_list->job_id;
+	node->cpu_total = process_frm_dispatch_list->cpu_req;
+	node->start_time = 0;
+	node->preemptions = 0;
+	node->allocate_resource.banker_slot = -1;
+	first_request(node);
+	hds_policy_init_process(node);
+	node->next = NULL;
+	return node;
 }
-
+//static struct process_queue_t * get_first_element(struct process_queue_t *qhead) {
+//
+//}
 // //////////// Memory mgmt API ////////////////////////
 /**
  * @brief Allocate memory for the given PID.
@@ -1149,8 +1674,9 @@ static int allocate_from_free_pool(unsigned int pid, int mem_req) {
 			hds_core_state.global_memory_info.free_pool_start = mb.end_pos + 1;
 			hds_core_state.global_memory_info.mem_available =
 					hds_core_state.global_memory_info.mem_available - mb.size;
-			max_available_resource.avail_memory =
-					max_available_resource.avail_memory - mb.size;
+			pthread_mutex_lock(&max_available_resource.avail_resource_mutex);
+			max_available_resource.avail[HDS_RES_MEMORY] -= mb.size;
+			pthread_mutex_unlock(&max_available_resource.avail_resource_mutex);
 			var_debug("Created new handle %d from free pool for pid: %d",
 					mb.mem_block_id, pid);
 			return mb.mem_block_id;
@@ -1228,6 +1754,14 @@ static int find_smallest_free_mblock(unsigned int pid, int mem_req) {
 	} else {
 		//make this block valid and associate it with this pid
 		smallest_free_mblock->pid = pid;
+		// the whole block is handed out, so account for all of it
+		hds_core_state.global_memory_info.mem_available =
+				hds_core_state.global_memory_info.mem_available
+						- smallest_free_mblock->size;
+		pthread_mutex_lock(&max_available_resource.avail_resource_mutex);
+		max_available_resource.avail[HDS_RES_MEMORY] -=
+				smallest_free_mblock->size;
+		pthread_mutex_unlock(&max_available_resource.avail_resource_mutex);
 		return smallest_free_mblock->mem_block_id;
 	}
 }
@@ -1251,6 +1785,14 @@ void free_mem(unsigned int pid, MEM_HANDLE mem_handle) {
 				//free up this block
 				var_debug("Freeing mem_block: %d", mem_handle);
 				mb->pid = -1;
+				//give the memory back so that admission test can see it
+				hds_core_state.global_memory_info.mem_available =
+						hds_core_state.global_memory_info.mem_available
+								+ mb->size;
+				pthread_mutex_lock(&max_available_resource.avail_resource_mutex);
+				max_available_resource.avail[HDS_RES_MEMORY] += mb->size;
+				pthread_mutex_unlock(
+						&max_available_resource.avail_resource_mutex);
 				return;
 			} else {
 				// this is an access violation
@@ -1319,7 +1861,7 @@ static void _consolidate_memory() {
 	 *
 	 * 	#end of compaction.
 	 */
-	struct mem_block_t *mb = NULL;
+	struct mem_block_t *mb = NULL, *prev = NULL, *freed = NULL;
 	unsigned int size;
 	sdebug("Performing memory compaction.");
 	//1. sort the mem_block_list
@@ -1329,25 +1871,40 @@ static void _consolidate_memory() {
 	hds_core_state.global_memory_info.free_pool_start = 65;
 
 	while (mb) {
+		if (mb->pid == -1) {
+			// a freed block goes back to the free pool, so drop it from the list
+			freed = mb;
+			mb = mb->next;
+			if (prev) {
+				prev->next = mb;
+			} else {
+				hds_core_state.mem_block_list = mb;
+			}
+			free(freed);
+			continue;
+		}
 		size = mb->size;
 		mb->start_pos = hds_core_state.global_memory_info.free_pool_start;
 		mb->end_pos = mb->start_pos + size - 1;
 		hds_core_state.global_memory_info.free_pool_start =
 				hds_core_state.global_memory_info.free_pool_start + size;
+		prev = mb;
 		mb = mb->next;
 	}
+	hds_core_state.mem_block_list_last = prev;
 }
 void print_memory_maps(){
 	struct mem_block_t *node = NULL;
-	if (!hds_core_state.mem_block_list){
-		return;
-	}
+	pthread_mutex_lock(&hds_core_state.mem_lock);
 	node = hds_core_state.mem_block_list;
-	sdebug("mem_handle\tpid\tsize\tstart_pos\tend_pos");
+	if (node) {
+		sdebug("mem_handle\tpid\tsize\tstart_pos\tend_pos");
+	}
 	while(node){
 		var_debug("%d\t%d\t%d\t%d\t%d",node->mem_block_id,node->pid,node->size,node->start_pos,node->end_pos);
 		node= node->next;
 	}
+	pthread_mutex_unlock(&hds_core_state.mem_lock);
 }
 /**
  * @brief The merge sort routine.
@@ -3,19 +3,41 @@
 #define HDS_CORE_H_
 
 #include "hds_common.h"
-#define SMALLEST_TIME_QUANTUM 1
+#include "hds_heap.h"
+#include "hds_submit.h"
+#include "hds_source.h"
+#include "hds_runq.h"
+#include "hds_rbtree.h"
+#include "hds_policy.h"
+#include "hds_banker.h"
+#include "hds_pcb.h"
+#include "hds_admit.h"
 typedef unsigned int MEM_HANDLE;
 #define MEM_BLOCK_INACTIVE -1
+/**
+ * @def HDS_WAKEUP_TIMEOUT_MS
+ * @brief Longest time a thread sleeps on its wakeup without being signalled.
+ * 		Threads are woken explicitly whenever there is work for them; this
+ * 		timeout only bounds how long it takes them to notice a shutdown which
+ * 		was requested from a signal handler.
+ */
+#define HDS_WAKEUP_TIMEOUT_MS 1000
+/**
+ * @def HDS_QUANTUM_NS
+ * @brief Length of a time quantum of the realtime engine in nanoseconds.
+ */
+#define HDS_QUANTUM_NS (SMALLEST_TIME_QUANTUM * 1000000000UL)
 
 /**
  * @struct hds_resource_state
  * @brief Denotes the current state of resources available for further allocation.
+ * 		Every lane of avail is written under avail_resource_mutex.
  */
 struct hds_global_resource_state_t{
-	int avail_memory;
-	int avail_scanner;
-	int avail_printer;
+	hds_resvec_t avail; /**< Units of every kind free right now */
+	hds_resvec_t total; /**< avail when nothing is allocated */
 	pthread_mutex_t avail_resource_mutex;
+	struct hds_banker_t banker; /**< Holders, with deadlock_avoidance = "banker" */
 }max_available_resource;
 
 
@@ -52,50 +74,122 @@ struct hds_allocated_resource_t{
 	 	 	 	 	 	 	 	 	 	memory allocation request and thus, single
 	 	 	 	 	 	 	 	 	 	memory_block_handle.
 	 	 	 	 	 	 	 	 	 	*/
-//	int printer_res;
-//	int scanner_res;
+	hds_resvec_t devices; /**< Units of every kind but memory held */
+	hds_resvec_t pending; /**< Units it has to be given before it runs again */
+	int stage; /**< No. of requests granted so far */
+	int banker_slot; /**< Its holder in max_available_resource.banker, -1 if none */
 };
+/**
+ * @struct process_queue_t
+ * @brief Process control block. A process has one from the time it arrives
+ * 		until it leaves the system (hds_pcb.c); queues, the next_to_run slot
+ * 		and cpus link to it instead of copying it.
+ */
 struct process_queue_t{
+	unsigned int handle; /**< Of this block, never changes */
+	unsigned int job_id; /**< Position of this process in the workload, starts from 1 */
 	unsigned long int arrival_time;
+	unsigned long int start_time; /**< When it got the cpu for the first time */
+	int cpu_total; /**< cpu_req as it was loaded, cpu_req counts down from here */
+	int preemptions; /**< No. of times it was interrupted or replaced */
 	int priority;
 	int cpu_req;
-	int memory_req;
-	int printer_req;
-	int scanner_req;
+	unsigned long int run_ns; /**< Realtime engine: charged for, less than a
+	 	 	 	 	 	 	 	 whole quantum, not yet taken off cpu_req */
+	unsigned long int cpu_ns; /**< Realtime engine: CPU time it consumed */
+	unsigned long int wall_ns; /**< Realtime engine: time it was let run */
+	unsigned long int ready_ns; /**< Realtime engine: when a realtime process
+	 	 	 	 	 	 	 	 was queued, 0 once it has run */
+	hds_resvec_t req; /**< Units of every resource kind it needs */
+	hds_kernel_t kernel; /**< Realtime engine: what it does while it runs */
 	int pid; /**< A non zero pid would mean it has not yet run for once. Once a process runs
 	 	 	 	 	 	 it will have a valid pid. It could be in either suspended/running state.*/
 	struct hds_allocated_resource_t allocate_resource;
+	struct hds_sched_info_t sched; /**< Kept by the scheduling policy */
 	struct process_queue_t *next;
+	unsigned int runq_slot; /**< Position in its run queue level's index */
+	struct hds_rb_link_t rb; /**< Only kept while in a policy's tree */
+	struct hds_fiber_t *fiber; /**< Realtime engine, fiber backend only */
+	int pidfd; /**< Realtime engine, process backend: refers to pid, -1 if none */
+};
+
+/**
+ * @struct hds_wakeup_t
+ * @brief Wakes a thread when there is new work for it. seq is bumped on every
+ * 		signal so that a signal sent between a thread finding nothing to do
+ * 		and going to sleep is not lost.
+ */
+struct hds_wakeup_t{
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	unsigned long int seq;
+};
+
+/**
+ * @struct hds_cpu_t
+ * @brief A simulated cpu. Processes are placed on the run queue of one cpu
+ * 		when they arrive; a cpu with nothing it can run takes work from the
+ * 		run queue of the busiest other cpu.
+ */
+struct hds_cpu_t{
+	int id;
+	pthread_t thread; /**< cpu thread, realtime engine only */
+	pthread_mutex_t rq_lock; /**< Guards runq and policy */
+	struct hds_runq_t runq; /**< rtq and p1q to p3q of this cpu */
+	struct hds_policy_rq_t policy; /**< Queues and state of tree policies */
+
+	struct process_queue_t *active_process; /**< Only set while active_process_valid */
+	pthread_mutex_t active_process_lock;
+	/*
+	 * The scheduler hands the next process to run over by storing its
+	 * handle in next_to_run, the cpu (or the scheduler, to replace it)
+	 * takes it with an atomic exchange. next_to_run_view is a copy of it,
+	 * written only by the scheduler under next_to_run_seq, to look at
+	 * without taking it.
+	 */
+	unsigned int next_to_run; /**< HDS_PCB_NONE if empty */
+	struct process_queue_t next_to_run_view;
+	unsigned long int next_to_run_seq; /**< Odd while next_to_run_view is written */
+
+	bool active_process_valid;
+	bool slice_expired; /**< Policy ended the slice of active process */
+
+	struct hds_wakeup_t cpu_wakeup; /**< next_to_run process was published */
+	unsigned long int steals; /**< Processes taken from other cpus */
+	unsigned long int rt_preemptions; /**< Quanta cut short for a realtime process */
 };
 
 struct hds_core_state_t{
-	struct process_queue_t *rtq,*rtq_last;
+	struct hds_heap_t arrival_q; /**< Processes not yet arrived, keyed on
+	 	 	 	 	 	 	 	 	 arrival offset */
 	struct process_queue_t *user_job_q,*user_job_q_last;
-	struct process_queue_t *p1q,*p1q_last;
-	struct process_queue_t *p2q,*p2q_last;
-	struct process_queue_t *p3q,*p3q_last;
+	struct hds_cpu_t cpu[HDS_MAX_CPUS];
+	int ncpus;
+	struct hds_policy_ops_t *policy; /**< Selected with 'policy' in hds.conf */
 
 	struct global_memory_pool_info_t global_memory_info;
 	struct mem_block_t *mem_block_list,*mem_block_list_last;
+	pthread_mutex_t mem_lock; /**< cpus allocate and free memory concurrently */
 
-	//mutexes for ensuring exclusive access to the process queues
-	pthread_mutex_t rtq_mutex;
-	pthread_mutex_t p1q_mutex;
-	pthread_mutex_t p2q_mutex;
-	pthread_mutex_t p3q_mutex;
 	/*
-	 * As of now we are not adding new processes to dispatch list at run time
-	 * so we donot need secure access to dispatch list since dispatcher will only
-	 * be accessing it. If however, processes are to be added via commandline
-	 * then, dispatch list will need to be secured.
+	 * Dispatch list and arrival queue are only accessed by the dispatcher (or
+	 * the event engine). Processes added at run time go through the lock-free
+	 * submission ring (hds_submit.h) which the dispatcher drains.
 	 */
-	struct process_queue_t active_process;
-	pthread_mutex_t active_process_lock;
-	struct process_queue_t next_to_run_process;
-	pthread_mutex_t next_to_run_process_lock;
+	struct hds_wakeup_t dispatcher_wakeup; /**< Only used to cut short the wait
+	 	 	 	 	 	 	 	 	 	 	 	 for next arrival on shutdown */
+	struct hds_wakeup_t scheduler_wakeup; /**< A process was queued, resources
+	 	 	 	 	 	 	 	 	 	 	 were freed or a cpu took next_to_run */
 
-	bool active_process_valid;
-	bool next_to_run_process_valid;
+	struct process_queue_t *resource_waitq,*resource_waitq_last; /**< Processes
+	 	 	 	 	 	 	 	 	 	 	 whose request could not be granted,
+	 	 	 	 	 	 	 	 	 	 	 requeued when resources are freed */
+	unsigned long int resource_waiting; /**< No. of processes in resource_waitq */
+	pthread_mutex_t resource_waitq_lock;
+
+	bool virtual_clock; /**< Set while the event engine drives the core. */
+	unsigned long int virtual_time; /**< Current time of event engine in quanta. */
+	struct timespec clock_start; /**< Wall clock time at which core was started. */
 }hds_core_state;
 
 void init_hds_core_state();
@@ -103,5 +197,47 @@ void init_hds_resource_state();
 void *hds_dispatcher(void *args);
 void *hds_scheduler(void *args);
 void *hds_cpu(void *args);
-void *hds_stats_manager(void *args);
+int hds_cpus_start();
+void hds_cpus_join();
+// queue and resource routines shared by the threads and the event engine
+int dispatch_process(struct hds_process_t *process);
+int load_arrival_queue();
+unsigned long int drain_submitted_jobs(unsigned long int now);
+unsigned long int refill_arrival_queue(unsigned long int now);
+unsigned long int release_due_arrivals(unsigned long int now);
+bool next_arrival_time(unsigned long int *t);
+void cleanup_arrival_queue();
+unsigned long int hds_core_now();
+unsigned long int hds_core_clock_ns();
+unsigned long int count_queued_processes();
+bool hds_core_workload_done();
+bool hds_core_cpus_idle();
+bool hds_core_next_to_run(struct hds_cpu_t *cpu,
+		struct process_queue_t *view);
+unsigned long int hds_core_steals();
+unsigned long int hds_core_rt_preemptions();
+unsigned long int hds_core_queued(struct hds_cpu_t *cpu);
+struct process_queue_t *find_next_process_tobe_executed(struct hds_cpu_t *cpu);
+struct process_queue_t *steal_process(struct hds_cpu_t *cpu);
+void remove_process_from_queue(struct hds_cpu_t *cpu,
+		struct process_queue_t *p);
+void degrade_priority_and_save_to_q(struct hds_cpu_t *cpu,
+		struct process_queue_t *p);
+void set_active_process(struct hds_cpu_t *cpu, struct process_queue_t *p);
+void hds_core_retire(struct hds_cpu_t *cpu);
+int allocate_resources(struct process_queue_t *process);
+int free_resources(struct process_queue_t *process);
+bool hds_core_next_request(struct process_queue_t *p);
+bool hds_core_waits_for_resources();
+void block_on_resources(struct process_queue_t *p);
+void free_mem(unsigned int pid, MEM_HANDLE mem_handle);
+void print_memory_maps();
+// wakeups between scheduler and cpu threads
+void hds_wakeup_init(struct hds_wakeup_t *w, const char *name);
+unsigned long int hds_wakeup_seq(struct hds_wakeup_t *w);
+void hds_wakeup_signal(struct hds_wakeup_t *w);
+void hds_wakeup_wait(struct hds_wakeup_t *w, unsigned long int seen);
+void hds_wakeup_wait_until(struct hds_wakeup_t *w, unsigned long int seen,
+		const struct timespec *deadline);
+void hds_core_wake_all();
 #endif /* HDS_CORE_H_ */
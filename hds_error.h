@@ -33,6 +33,8 @@ typedef enum {
     HDS_ERR_NO_SUCH_ELEMENT,
     HDS_ERR_INVALID_PROCESS,
     HDS_ERR_NO_RESOURCE,
+    HDS_ERR_QUEUE_FULL, /**< Submission ring has no free slot, try again later */
+    HDS_ERR_UNSAFE, /**< Granting resources could lead to a deadlock, try again later */
     HDS_ERR_GENERIC /** Generic error: not sure what it is, but it's fishy anyway*/
 } error_codes_t;
 /**
@@ -0,0 +1,550 @@
+/**
+ * @file hds_exec.c
+ * @brief How the realtime engine runs processes, picked with 'exec_backend'
+ * 		  in hds.conf.
+ *
+ * 		  process: every process is a child process, started on a parked
+ * 		  worker (hds_workers.c) or forked, and stopped and continued with
+ * 		  SIGSTOP and SIGCONT. Each one costs a pid and a process' worth of
+ * 		  memory, which caps a run at a few thousand live processes.
+ * 		  A child is signalled through a pidfd, which can not end up
+ * 		  referring to another process. Once it is sent SIGTERM its pidfd
+ * 		  goes to a reaper thread, which waits for it to become readable in
+ * 		  an epoll set, collects the child and checks how it exited; no
+ * 		  zombie is left behind and nothing polls.
+ *
+ * 		  fiber: every process is a fiber, a stack and saved registers inside
+ * 		  hds. The cpu which has it switches to it, it works for
+ * 		  HDS_FIBER_WORK_US and switches back, so it is stopped simply by not
+ * 		  being switched to again. A suspended fiber costs a few kilobytes,
+ * 		  hundreds of thousands of them fit in one process. Fibers are
+ * 		  carved out of slabs like process control blocks are.
+ */
+#include "hds_exec.h"
+#include "hds_core.h"
+#include "hds_sim.h"
+#include "hds_workers.h"
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+//=========== routines declaration============
+static void child_function(unsigned long int arg);
+static int process_start();
+static void process_stop();
+static int process_spawn(struct process_queue_t *p);
+static void process_resume(struct process_queue_t *p);
+static void process_pause(struct process_queue_t *p);
+static void process_slice(struct process_queue_t *p, struct hds_wakeup_t *w,
+		unsigned long int seen, const struct timespec *deadline);
+static void process_reap(struct process_queue_t *p);
+static int open_pidfd(pid_t pid);
+static void signal_child(struct process_queue_t *p, int sig);
+static void *reap_children(void *arg);
+static void check_exit(pid_t pid, int status);
+static int process_cpu_time(struct process_queue_t *p, unsigned long int *ns);
+static int fiber_start();
+static void fiber_stop();
+static int fiber_spawn(struct process_queue_t *p);
+static void fiber_slice(struct process_queue_t *p, struct hds_wakeup_t *w,
+		unsigned long int seen, const struct timespec *deadline);
+static void fiber_reap(struct process_queue_t *p);
+static int fiber_cpu_time(struct process_queue_t *p, unsigned long int *ns);
+static void fiber_main(unsigned int lo, unsigned int hi);
+static int add_fiber_slab();
+//===========================================
+static struct hds_exec_ops_t backends[HDS_EXEC_BACKENDS] = {
+	[HDS_EXEC_PROCESS] = { "process", process_start, process_stop,
+			process_spawn, process_resume, process_pause, process_slice,
+			process_reap, process_cpu_time },
+	[HDS_EXEC_FIBER] = { "fiber", fiber_start, fiber_stop, fiber_spawn, NULL,
+			NULL, fiber_slice, fiber_reap, fiber_cpu_time },
+};
+static struct hds_exec_ops_t *exec = &backends[HDS_EXEC_PROCESS];
+/**
+ * @def REAPER_WAKE
+ * @brief epoll data of the eventfd which stops the reaper. Data of a child
+ * 		is its pid in the high and its pidfd in the low half.
+ */
+#define REAPER_WAKE UINT64_MAX
+/**
+ * @def CHILD_ARG
+ * @brief What the child process of p is to do, in a word which can be
+ * 		queued with a signal: its kernel in the low 8 bits, memory_req above.
+ */
+#define CHILD_ARG(p) (((unsigned long int) (p)->req[HDS_RES_MEMORY] << 8) \
+		| (p)->kernel)
+/**
+ * @struct hds_reaper_t
+ * @brief Children which have been sent SIGTERM and are waited for.
+ */
+static struct hds_reaper_t {
+	int epfd; /**< pidfds of those children and wake */
+	int wake; /**< eventfd, written to stop the reaper */
+	pthread_t thread;
+	bool running;
+	unsigned long int pending; /**< Handed over and not reaped yet, atomic */
+	unsigned long int reaped; /**< Atomic */
+	unsigned long int bad_exits; /**< Did not exit as told, atomic */
+} reaper;
+/**
+ * @struct hds_fiber_slab_t
+ * @brief HDS_FIBER_SLAB fibers, followed by their stacks in the same
+ * 		mapping.
+ */
+struct hds_fiber_slab_t {
+	struct hds_fiber_slab_t *next;
+	size_t size; /**< Of the whole mapping */
+	struct hds_fiber_t fiber[HDS_FIBER_SLAB];
+};
+/**
+ * @struct hds_fiber_pool_t
+ * @brief Every fiber slab and the free fibers, linked through their next.
+ */
+static struct hds_fiber_pool_t {
+	struct hds_fiber_slab_t *slabs;
+	struct hds_fiber_t *free_list;
+	pthread_mutex_t lock; /**< Guards slabs and free_list */
+	int next_id; /**< Fibers are numbered like processes of the event engine */
+} fibers;
+/** What the cpu thread was doing when it switched to a fiber */
+static __thread ucontext_t fiber_back;
+
+/**
+ * @brief Use the backend named in hds.conf and get it ready. Called before
+ * 		the cpus start.
+ * @return HDS_OK on success else an error code.
+ */
+int hds_exec_start() {
+	exec = &backends[hds_config.exec_backend];
+	var_debug("Execution backend: %s", exec->name);
+	return exec->start ? exec->start() : HDS_OK;
+}
+/**
+ * @brief Called once every cpu has stopped.
+ */
+void hds_exec_stop() {
+	if (exec->stop) {
+		exec->stop();
+	}
+}
+/**
+ * @brief Name of the backend in use.
+ */
+const char *hds_exec_name() {
+	return exec->name;
+}
+/**
+ * @brief Backend of a name as given for 'exec_backend' in hds.conf.
+ * @return The backend or -1 if there is none.
+ */
+int hds_exec_lookup(const char *name) {
+	int i;
+	for (i = 0; i < HDS_EXEC_BACKENDS; i++) {
+		if (strcmp(backends[i].name, name) == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
+/**
+ * @brief Create the process of p when it is about to run for the first
+ * 		time. It does not run until resumed.
+ * @return HDS_OK on success, p then has a pid, else an error code.
+ */
+int hds_exec_spawn(struct process_queue_t *p) {
+	return exec->spawn(p);
+}
+/**
+ * @brief Let p run, its quantum begins.
+ */
+void hds_exec_resume(struct process_queue_t *p) {
+	if (exec->resume) {
+		exec->resume(p);
+	}
+}
+/**
+ * @brief Stop p, its quantum is over.
+ */
+void hds_exec_pause(struct process_queue_t *p) {
+	if (exec->pause) {
+		exec->pause(p);
+	}
+}
+/**
+ * @brief Let a resumed p work for a while: until deadline, an absolute time
+ * 		on CLOCK_MONOTONIC, or until w is signalled after seen was read. A
+ * 		backend may return earlier, the caller checks and calls it again.
+ */
+void hds_exec_slice(struct process_queue_t *p, struct hds_wakeup_t *w,
+		unsigned long int seen, const struct timespec *deadline) {
+	exec->slice(p, w, seen, deadline);
+}
+/**
+ * @brief Do away with the process of p once it has completed or failed.
+ */
+void hds_exec_reap(struct process_queue_t *p) {
+	exec->reap(p);
+}
+/**
+ * @brief CPU time the process of p has consumed so far, read from the
+ * 		kernel. Only the difference between two readings means anything.
+ * @return HDS_OK on success else HDS_ERR_GENERIC, e.g. if the backend can
+ * 		not tell.
+ */
+int hds_exec_cpu_time(struct process_queue_t *p, unsigned long int *ns) {
+	return exec->cpu_time ? exec->cpu_time(p, ns) : HDS_ERR_GENERIC;
+}
+/**
+ * @brief No. of child processes collected so far, and of those which did
+ * 		not exit the way they were told to.
+ */
+void hds_exec_children(unsigned long int *reaped,
+		unsigned long int *bad_exits) {
+	*reaped = __atomic_load_n(&reaper.reaped, __ATOMIC_RELAXED);
+	*bad_exits = __atomic_load_n(&reaper.bad_exits, __ATOMIC_RELAXED);
+}
+// //////////// process ///////////////////////////////
+/**
+ * @brief Body of a child process: runs the kernel of its job until it is
+ * 		killed.
+ * @param arg CHILD_ARG() of its process.
+ */
+static void child_function(unsigned long int arg) {
+	struct hds_kernel_state_t k;
+	/*
+	 * Since I am not sure about whether debug() routines would work in this
+	 * situation, the kernel does not log either.
+	 */
+	hds_kernel_prepare(&k, arg & 0xff, arg >> 8);
+	while (1) {
+		hds_kernel_round(&k, HDS_KERNEL_ROUND_US);
+	}
+}
+static int process_start() {
+	struct epoll_event ev;
+	int rc;
+	memset(&reaper, 0, sizeof(reaper));
+	reaper.epfd = reaper.wake = -1;
+	// the spawner of the worker pool is forked before hds has any more fds
+	if ((rc = hds_workers_start(hds_config.worker_pool, child_function))
+			!= HDS_OK) {
+		return rc;
+	}
+	reaper.epfd = epoll_create1(EPOLL_CLOEXEC);
+	reaper.wake = eventfd(0, EFD_CLOEXEC);
+	ev.events = EPOLLIN;
+	ev.data.u64 = REAPER_WAKE;
+	if (reaper.epfd == -1 || reaper.wake == -1
+			|| epoll_ctl(reaper.epfd, EPOLL_CTL_ADD, reaper.wake, &ev) != 0
+			|| pthread_create(&reaper.thread, NULL, reap_children, NULL )
+					!= 0) {
+		// children are then waited for by the cpu which ends them
+		serror("Failed to start reaper, children are collected inline");
+		return HDS_OK;
+	}
+	reaper.running = true;
+	return HDS_OK;
+}
+static void process_stop() {
+	uint64_t one = 1;
+	if (reaper.running == true) {
+		if (write(reaper.wake, &one, sizeof(one)) != sizeof(one)) {
+			serror("Failed to wake reaper");
+		}
+		if (pthread_join(reaper.thread, NULL ) != 0) {
+			serror("Error in collecting thread: reaper");
+		}
+		reaper.running = false;
+	}
+	if (reaper.epfd != -1) {
+		close(reaper.epfd);
+	}
+	if (reaper.wake != -1) {
+		close(reaper.wake);
+	}
+	hds_workers_stop();
+}
+static int process_spawn(struct process_queue_t *p) {
+	// a parked worker takes it on, unless there is none; then we will fork
+	// a new child process
+	p->pid = hds_workers_take(p->job_id, CHILD_ARG(p));
+	if (p->pid == 0) {
+		p->pid = fork();
+		switch (p->pid) {
+		case -1:
+			serror("cpu: fork() failed");
+			p->pid = 0;
+			return HDS_ERR_GENERIC;
+		case 0:
+			child_function(CHILD_ARG(p));
+			break;
+		default:
+			break;
+		}
+	}
+	// -1 on kernels without pidfds, signals then go to the pid
+	p->pidfd = open_pidfd(p->pid);
+	/*
+	 * Since child will become active the moment it will be instantiated
+	 * we stop it here so that we will run it later on.
+	 */
+	signal_child(p, SIGSTOP);
+	return HDS_OK;
+}
+static void process_resume(struct process_queue_t *p) {
+	signal_child(p, SIGCONT);
+}
+static void process_pause(struct process_queue_t *p) {
+	signal_child(p, SIGSTOP);
+}
+static void process_slice(struct process_queue_t *p, struct hds_wakeup_t *w,
+		unsigned long int seen, const struct timespec *deadline) {
+	// the child runs on its own meanwhile
+	hds_wakeup_wait_until(w, seen, deadline);
+}
+static int process_cpu_time(struct process_queue_t *p, unsigned long int *ns) {
+	struct timespec ts;
+	clockid_t clock;
+	// includes any time a worker spent parked, which differences cancel out
+	if (clock_getcpuclockid(p->pid, &clock) != 0
+			|| clock_gettime(clock, &ts) != 0) {
+		return HDS_ERR_GENERIC;
+	}
+	*ns = ts.tv_sec * 1000000000UL + ts.tv_nsec;
+	return HDS_OK;
+}
+static void process_reap(struct process_queue_t *p) {
+	struct epoll_event ev;
+	int status;
+	//remember that child process may be stopped so before killing it we will
+	// activate it
+	signal_child(p, SIGCONT);
+	signal_child(p, SIGTERM);
+	if (p->pidfd != -1 && reaper.running == true) {
+		ev.events = EPOLLIN;
+		ev.data.u64 = ((uint64_t) p->pid << 32) | (uint32_t) p->pidfd;
+		__atomic_add_fetch(&reaper.pending, 1, __ATOMIC_RELAXED);
+		if (epoll_ctl(reaper.epfd, EPOLL_CTL_ADD, p->pidfd, &ev) == 0) {
+			// the reaper closes it
+			p->pidfd = -1;
+			return;
+		}
+		__atomic_sub_fetch(&reaper.pending, 1, __ATOMIC_RELAXED);
+	}
+	// it exits as soon as it takes SIGTERM, so this wait is short
+	if (waitpid(p->pid, &status, 0) == p->pid) {
+		check_exit(p->pid, status);
+	}
+	if (p->pidfd != -1) {
+		close(p->pidfd);
+		p->pidfd = -1;
+	}
+}
+static int open_pidfd(pid_t pid) {
+#ifdef SYS_pidfd_open
+	return syscall(SYS_pidfd_open, pid, 0);
+#else
+	return -1;
+#endif
+}
+static void signal_child(struct process_queue_t *p, int sig) {
+#ifdef SYS_pidfd_send_signal
+	if (p->pidfd != -1) {
+		syscall(SYS_pidfd_send_signal, p->pidfd, sig, NULL, 0);
+		return;
+	}
+#endif
+	kill(p->pid, sig);
+}
+/**
+ * @brief Body of the reaper: collect every child whose pidfd has become
+ * 		readable, i.e. which has exited. Once woken to stop, it goes on for
+ * 		as long as children it was handed keep exiting.
+ */
+static void *reap_children(void *arg) {
+	struct epoll_event ev[64];
+	bool stopping = false;
+	int n, i, status, fd;
+	pid_t pid;
+	uint64_t count;
+	while (stopping == false
+			|| __atomic_load_n(&reaper.pending, __ATOMIC_RELAXED) > 0) {
+		n = epoll_wait(reaper.epfd, ev, 64, stopping ? 1000 : -1);
+		if (n == -1 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			var_warn("reaper: %lu children did not exit",
+					__atomic_load_n(&reaper.pending, __ATOMIC_RELAXED));
+			break;
+		}
+		for (i = 0; i < n; i++) {
+			if (ev[i].data.u64 == REAPER_WAKE) {
+				if (read(reaper.wake, &count, sizeof(count)) == sizeof(count)) {
+					stopping = true;
+				}
+				continue;
+			}
+			pid = ev[i].data.u64 >> 32;
+			fd = (int) (uint32_t) ev[i].data.u64;
+			if (waitpid(pid, &status, 0) == pid) {
+				check_exit(pid, status);
+			}
+			epoll_ctl(reaper.epfd, EPOLL_CTL_DEL, fd, NULL );
+			close(fd);
+			__atomic_sub_fetch(&reaper.pending, 1, __ATOMIC_RELAXED);
+		}
+	}
+	sdebug("reaper: Shutting down..");
+	pthread_exit(NULL );
+}
+/**
+ * @brief Count a collected child and warn if it did not exit on SIGTERM:
+ * 		either through the signal handler of hds, which exits with
+ * 		EXIT_SUCCESS, or killed by the signal itself.
+ */
+static void check_exit(pid_t pid, int status) {
+	__atomic_add_fetch(&reaper.reaped, 1, __ATOMIC_RELAXED);
+	if ((WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS)
+			|| (WIFSIGNALED(status) && WTERMSIG(status) == SIGTERM)) {
+		return;
+	}
+	__atomic_add_fetch(&reaper.bad_exits, 1, __ATOMIC_RELAXED);
+	if (WIFEXITED(status)) {
+		var_warn("Child process %d exited with status %d", pid,
+				WEXITSTATUS(status));
+	} else if (WIFSIGNALED(status)) {
+		var_warn("Child process %d was killed by signal %d", pid,
+				WTERMSIG(status));
+	}
+}
+// //////////// fiber /////////////////////////////////
+static int fiber_start() {
+	memset(&fibers, 0, sizeof(fibers));
+	fibers.next_id = SIM_FIRST_PID;
+	if (pthread_mutex_init(&fibers.lock, NULL ) != 0) {
+		serror("Failed to initialize mutex: fiber pool lock");
+		return HDS_ERR_GENERIC;
+	}
+	return HDS_OK;
+}
+static void fiber_stop() {
+	struct hds_fiber_slab_t *slab = NULL;
+	int i;
+	while ((slab = fibers.slabs) != NULL) {
+		fibers.slabs = slab->next;
+		// fibers of processes which never completed still hold what their
+		// kernel took; free fibers hold nothing, cleaning them up is harmless
+		for (i = 0; i < HDS_FIBER_SLAB; i++) {
+			hds_kernel_cleanup(&slab->fiber[i].work);
+		}
+		munmap(slab, slab->size);
+	}
+	fibers.free_list = NULL;
+	pthread_mutex_destroy(&fibers.lock);
+}
+static int fiber_spawn(struct process_queue_t *p) {
+	struct hds_fiber_t *f = NULL;
+	uintptr_t addr;
+	pthread_mutex_lock(&fibers.lock);
+	if (!fibers.free_list && add_fiber_slab() != HDS_OK) {
+		pthread_mutex_unlock(&fibers.lock);
+		return HDS_ERR_NO_MEM;
+	}
+	f = fibers.free_list;
+	fibers.free_list = f->next;
+	pthread_mutex_unlock(&fibers.lock);
+
+	getcontext(&f->ctx);
+	f->ctx.uc_stack.ss_sp = f->stack;
+	f->ctx.uc_stack.ss_size = HDS_FIBER_STACK;
+	f->ctx.uc_link = NULL;
+	// makecontext() only passes ints
+	addr = (uintptr_t) f;
+	makecontext(&f->ctx, (void (*)()) fiber_main, 2,
+			(unsigned int) (addr & 0xffffffffU),
+			(unsigned int) ((uint64_t) addr >> 32));
+	f->cpu_ns = 0;
+	// set up by the fiber on its first round, on its own CPU time
+	hds_kernel_prepare(&f->work, p->kernel, p->req[HDS_RES_MEMORY]);
+	p->fiber = f;
+	p->pid = __atomic_fetch_add(&fibers.next_id, 1, __ATOMIC_RELAXED);
+	return HDS_OK;
+}
+static void fiber_slice(struct process_queue_t *p, struct hds_wakeup_t *w,
+		unsigned long int seen, const struct timespec *deadline) {
+	struct timespec before, after, now;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &before);
+	p->fiber->back = &fiber_back;
+	// a round of HDS_FIBER_WORK_US at a time, looking in between for what
+	// process_slice() waits for
+	do {
+		swapcontext(&fiber_back, &p->fiber->ctx);
+		clock_gettime(CLOCK_MONOTONIC, &now);
+	} while (hds_wakeup_seq(w) == seen
+			&& (now.tv_sec < deadline->tv_sec
+					|| (now.tv_sec == deadline->tv_sec
+							&& now.tv_nsec < deadline->tv_nsec)));
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &after);
+	p->fiber->cpu_ns += (after.tv_sec - before.tv_sec) * 1000000000L
+			+ after.tv_nsec - before.tv_nsec;
+}
+static void fiber_reap(struct process_queue_t *p) {
+	if (!p->fiber) {
+		return;
+	}
+	hds_kernel_cleanup(&p->fiber->work);
+	pthread_mutex_lock(&fibers.lock);
+	p->fiber->next = fibers.free_list;
+	fibers.free_list = p->fiber;
+	pthread_mutex_unlock(&fibers.lock);
+	p->fiber = NULL;
+}
+static int fiber_cpu_time(struct process_queue_t *p, unsigned long int *ns) {
+	*ns = p->fiber->cpu_ns;
+	return HDS_OK;
+}
+/**
+ * @brief Body of a fiber, the same work a child process does but handing
+ * 		its cpu back after every round.
+ */
+static void fiber_main(unsigned int lo, unsigned int hi) {
+	struct hds_fiber_t *f = (struct hds_fiber_t *) (uintptr_t) (((uint64_t) hi
+			<< 32) | lo);
+	while (1) {
+		hds_kernel_round(&f->work, HDS_FIBER_WORK_US);
+		swapcontext(&f->ctx, f->back);
+	}
+}
+/**
+ * @brief Map one more slab of fibers and put them on the free list. Stacks
+ * 		are only backed once they are touched. Called with the pool locked.
+ * 		A free fiber's work holds nothing, so that it can be cleaned up.
+ */
+static int add_fiber_slab() {
+	struct hds_fiber_slab_t *slab = NULL;
+	size_t head, size;
+	long page = sysconf(_SC_PAGESIZE);
+	int i;
+	head = (sizeof(struct hds_fiber_slab_t) + page - 1) / page * page;
+	size = head + (size_t) HDS_FIBER_SLAB * HDS_FIBER_STACK;
+	slab = (struct hds_fiber_slab_t *) mmap(NULL, size,
+			PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+			-1, 0);
+	if (slab == MAP_FAILED) {
+		serror("Failed to map a slab of fibers");
+		return HDS_ERR_NO_MEM;
+	}
+	slab->size = size;
+	for (i = HDS_FIBER_SLAB; i-- > 0;) {
+		slab->fiber[i].stack = (char *) slab + head + (size_t) i * HDS_FIBER_STACK;
+		slab->fiber[i].work.fd = -1;
+		slab->fiber[i].next = fibers.free_list;
+		fibers.free_list = &slab->fiber[i];
+	}
+	slab->next = fibers.slabs;
+	fibers.slabs = slab;
+	return HDS_OK;
+}
@@ -0,0 +1,88 @@
+/**
+ * @file hds_exec.h
+ * @brief header file for hds_exec.c
+ */
+#ifndef HDS_EXEC_H_
+#define HDS_EXEC_H_
+
+#include "hds_common.h"
+#include "hds_kernel.h"
+#include <ucontext.h>
+
+/**
+ * @def HDS_FIBER_STACK
+ * @brief Bytes of stack of a fiber. Only the pages it touches are backed.
+ */
+#define HDS_FIBER_STACK (32 * 1024)
+/**
+ * @def HDS_FIBER_SLAB
+ * @brief No. of fibers, and their stacks, carved out of one allocation.
+ */
+#define HDS_FIBER_SLAB 256
+/**
+ * @def HDS_FIBER_WORK_US
+ * @brief A fiber works this long before it yields back to its cpu, one
+ * 		round of its kernel like a child process runs.
+ */
+#define HDS_FIBER_WORK_US HDS_KERNEL_ROUND_US
+
+struct process_queue_t;
+struct hds_wakeup_t;
+
+/**
+ * @struct hds_fiber_t
+ * @brief A process run as a fiber on the thread of whichever cpu has it.
+ */
+struct hds_fiber_t {
+	ucontext_t ctx;
+	ucontext_t *back; /**< Where it yields to, set on every switch */
+	char *stack; /**< HDS_FIBER_STACK bytes in the slab it came from */
+	unsigned long int cpu_ns; /**< CPU time its cpus spent switched to it */
+	struct hds_kernel_state_t work; /**< What it does, see hds_kernel.c */
+	struct hds_fiber_t *next; /**< On the free list */
+};
+
+/**
+ * @struct hds_exec_ops_t
+ * @brief How the realtime engine runs processes ('exec_backend' in
+ * 		hds.conf). A process is created when it first runs, runs while the
+ * 		cpu which has it calls slice, and is done away with once it
+ * 		completes or fails. start, stop, resume, pause and cpu_time may
+ * 		be NULL.
+ */
+struct hds_exec_ops_t {
+	const char *name; /**< As given for 'exec_backend' in hds.conf */
+	/** Called before the cpus start */
+	int (*start)();
+	/** Called once every cpu has stopped */
+	void (*stop)();
+	/** Create the process of p, not running, and give it a pid */
+	int (*spawn)(struct process_queue_t *p);
+	/** Let p run, called when its quantum begins */
+	void (*resume)(struct process_queue_t *p);
+	/** Stop p, called when its quantum ends */
+	void (*pause)(struct process_queue_t *p);
+	/** Let p work until deadline or until w is signalled after seen */
+	void (*slice)(struct process_queue_t *p, struct hds_wakeup_t *w,
+			unsigned long int seen, const struct timespec *deadline);
+	/** Do away with p, stopped or not, once it has completed or failed */
+	void (*reap)(struct process_queue_t *p);
+	/** CPU time p has consumed so far, ns; only differences are used */
+	int (*cpu_time)(struct process_queue_t *p, unsigned long int *ns);
+};
+
+// --------routines-----------
+int hds_exec_start();
+void hds_exec_stop();
+const char *hds_exec_name();
+int hds_exec_lookup(const char *name);
+int hds_exec_spawn(struct process_queue_t *p);
+void hds_exec_resume(struct process_queue_t *p);
+void hds_exec_pause(struct process_queue_t *p);
+void hds_exec_slice(struct process_queue_t *p, struct hds_wakeup_t *w,
+		unsigned long int seen, const struct timespec *deadline);
+void hds_exec_reap(struct process_queue_t *p);
+int hds_exec_cpu_time(struct process_queue_t *p, unsigned long int *ns);
+void hds_exec_children(unsigned long int *reaped,
+		unsigned long int *bad_exits);
+#endif /* HDS_EXEC_H_ */
@@ -0,0 +1,141 @@
+/**
+ * @file hds_gen.c
+ * @brief Synthetic workload generator. Draws jobs from the distributions in
+ * 		  the 'generator' group of hds.conf, in order of arrival, so that
+ * 		  they can be streamed like a trace without being stored anywhere.
+ */
+#include "hds_gen.h"
+//=========== routines declaration============
+static uint64_t next_random();
+static double uniform();
+static double exponential(double rate);
+static unsigned long int geometric(double mean);
+static unsigned int weighted_pick(const double *weights, unsigned int n);
+static int draw_cpu_req();
+//===========================================
+/**
+ * @brief Start generating from the configured seed.
+ */
+void hds_gen_init() {
+	// splitmix64 spreads the seed, so that seeds 1, 2, 3.. are unrelated
+	uint64_t z = hds_config.generator.seed + 0x9E3779B97F4A7C15ULL;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	z = z ^ (z >> 31);
+
+	memset(&hds_gen, 0, sizeof(hds_gen));
+	hds_gen.rng = z ? z : 1;
+}
+/**
+ * @brief Generate the next job. Arrivals never decrease.
+ * @param job Filled with the job, job_id is left 0.
+ * @return HDS_OK or HDS_ERR_NO_SUCH_ELEMENT once 'jobs' jobs have been made.
+ */
+int hds_gen_next(struct hds_process_t *job) {
+	struct hds_generator_config_t *g = &hds_config.generator;
+	int k;
+
+	if (hds_gen.produced >= g->jobs) {
+		return HDS_ERR_NO_SUCH_ELEMENT;
+	}
+	if (g->arrival == HDS_GEN_BURSTY) {
+		// bursts arrive as a poisson process, jobs of a burst arrive together
+		if (hds_gen.burst_left == 0) {
+			hds_gen.t += exponential(g->rate / g->burst_size);
+			hds_gen.burst_left = geometric(g->burst_size);
+		}
+		hds_gen.burst_left--;
+	} else {
+		hds_gen.t += exponential(g->rate);
+	}
+
+	memset(job, 0, sizeof(*job));
+	job->arrival = (unsigned long int) hds_gen.t;
+	job->priority = weighted_pick(g->priority_ratio, 4);
+	job->cpu_req = draw_cpu_req();
+	if (g->kernel_mix) {
+		// only drawn when asked for, a seed keeps giving the jobs it gave
+		job->kernel = weighted_pick(g->kernel_ratio, HDS_KERNELS);
+	}
+	job->req[HDS_RES_MEMORY] = g->memory_sizes[weighted_pick(g->memory_weights,
+			g->memory_mix_len)];
+	if (job->priority == 0) {
+		// realtime processes use no devices
+		if (job->req[HDS_RES_MEMORY] > HDS_GEN_RT_MEMORY) {
+			job->req[HDS_RES_MEMORY] = HDS_GEN_RT_MEMORY;
+		}
+	} else {
+		// every device kind, those added in hds.conf too, 0 to all of it
+		for (k = HDS_RES_PRINTER; k < hds_config.max_resources.kinds; k++) {
+			job->req[k] = next_random()
+					% (hds_config.max_resources.units[k] + 1);
+		}
+	}
+	hds_gen.produced++;
+	return HDS_OK;
+}
+/**
+ * @brief xorshift64*: fast, and good enough for drawing workloads.
+ */
+static uint64_t next_random() {
+	hds_gen.rng ^= hds_gen.rng >> 12;
+	hds_gen.rng ^= hds_gen.rng << 25;
+	hds_gen.rng ^= hds_gen.rng >> 27;
+	return hds_gen.rng * 0x2545F4914F6CDD1DULL;
+}
+/**
+ * @brief A double in [0, 1) from the top 53 bits.
+ */
+static double uniform() {
+	return (next_random() >> 11) * (1.0 / 9007199254740992.0);
+}
+static double exponential(double rate) {
+	return -log(1.0 - uniform()) / rate;
+}
+/**
+ * @brief No. of trials up to and including the first success, at least 1.
+ */
+static unsigned long int geometric(double mean) {
+	double p = 1.0 / mean;
+	if (p >= 1.0) {
+		return 1;
+	}
+	return 1 + (unsigned long int) floor(log(1.0 - uniform()) / log(1.0 - p));
+}
+static unsigned int weighted_pick(const double *weights, unsigned int n) {
+	double total = 0, x;
+	unsigned int i;
+	for (i = 0; i < n; i++) {
+		total += weights[i];
+	}
+	x = uniform() * total;
+	for (i = 0; i < n - 1; i++) {
+		if (x < weights[i]) {
+			return i;
+		}
+		x -= weights[i];
+	}
+	return n - 1;
+}
+/**
+ * @brief cpu_req in whole quanta, between 1 and cpu_max.
+ */
+static int draw_cpu_req() {
+	struct hds_generator_config_t *g = &hds_config.generator;
+	double x, xm;
+	if (g->cpu == HDS_GEN_PARETO) {
+		// scale chosen so that the mean is cpu_mean
+		xm = g->cpu_mean * (g->pareto_alpha - 1) / g->pareto_alpha;
+		x = xm / pow(1.0 - uniform(), 1.0 / g->pareto_alpha);
+	} else {
+		x = -g->cpu_mean * log(1.0 - uniform());
+	}
+	x = ceil(x);
+	if (x < 1) {
+		return 1;
+	}
+	if (x > g->cpu_max) {
+		return g->cpu_max;
+	}
+	return (int) x;
+}
@@ -0,0 +1,33 @@
+/**
+ * @file hds_gen.h
+ * @brief header file for hds_gen.c
+ */
+#ifndef HDS_GEN_H_
+#define HDS_GEN_H_
+
+#include "hds_common.h"
+#include <stdint.h>
+#include <math.h>
+
+/**
+ * @def HDS_GEN_RT_MEMORY
+ * @brief Memory kept aside for realtime processes. A generated realtime job
+ * 		never asks for more.
+ */
+#define HDS_GEN_RT_MEMORY 64
+/**
+ * @struct hds_gen_t
+ * @brief State of the workload generator. Everything drawn depends only on
+ * 		the seed, so a run can be repeated exactly.
+ */
+struct hds_gen_t {
+	uint64_t rng; /**< xorshift64* state, never 0 */
+	unsigned long int produced; /**< Jobs generated so far */
+	double t; /**< Arrival of the last job, before rounding to a quantum */
+	unsigned long int burst_left; /**< Jobs left in the current burst */
+} hds_gen;
+
+// --------routines-----------
+void hds_gen_init();
+int hds_gen_next(struct hds_process_t *job);
+#endif /* HDS_GEN_H_ */
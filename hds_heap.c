@@ -0,0 +1,145 @@
+/**
+ * @file hds_heap.c
+ * @brief A small binary min-heap used for ordering timed entries such as the
+ * 		  events of the event engine.
+ */
+#include "hds_heap.h"
+//=========== routines declaration============
+static bool node_less(struct hds_heap_node_t *a, struct hds_heap_node_t *b);
+static void sift_up(struct hds_heap_t *heap, unsigned int pos);
+static void sift_down(struct hds_heap_t *heap, unsigned int pos);
+//===========================================
+/**
+ * @brief Initialise an empty heap.
+ * @param heap The heap to be initialised.
+ * @param capacity Initial no. of nodes. If 0 then HDS_HEAP_INITIAL_CAPACITY is
+ * 			used.
+ * @return HDS_OK on success else HDS_ERR_NO_MEM.
+ */
+int hds_heap_init(struct hds_heap_t *heap, unsigned int capacity) {
+	if (capacity == 0) {
+		capacity = HDS_HEAP_INITIAL_CAPACITY;
+	}
+	heap->nodes = (struct hds_heap_node_t *) malloc(
+			sizeof(struct hds_heap_node_t) * capacity);
+	if (!heap->nodes) {
+		return HDS_ERR_NO_MEM;
+	}
+	heap->size = 0;
+	heap->capacity = capacity;
+	heap->seq_counter = 0;
+	return HDS_OK;
+}
+/**
+ * @brief Release memory held by the heap. Data pointers are not freed.
+ */
+void hds_heap_destroy(struct hds_heap_t *heap) {
+	free(heap->nodes);
+	heap->nodes = NULL;
+	heap->size = heap->capacity = 0;
+}
+/**
+ * @brief Insert a new entry.
+ * @param heap The heap.
+ * @param key The ordering key, smallest key is popped first.
+ * @param data Caller's payload.
+ * @return HDS_OK on success else HDS_ERR_NO_MEM.
+ */
+int hds_heap_push(struct hds_heap_t *heap, unsigned long int key, void *data) {
+	struct hds_heap_node_t *nodes = NULL;
+	if (heap->size == heap->capacity) {
+		//double the capacity
+		nodes = (struct hds_heap_node_t *) realloc(heap->nodes,
+				sizeof(struct hds_heap_node_t) * heap->capacity * 2);
+		if (!nodes) {
+			return HDS_ERR_NO_MEM;
+		}
+		heap->nodes = nodes;
+		heap->capacity = heap->capacity * 2;
+	}
+	heap->nodes[heap->size].key = key;
+	heap->nodes[heap->size].seq = heap->seq_counter++;
+	heap->nodes[heap->size].data = data;
+	heap->size++;
+	sift_up(heap, heap->size - 1);
+	return HDS_OK;
+}
+/**
+ * @brief Remove the smallest entry.
+ * @param heap The heap.
+ * @param key If not NULL, the key of removed entry is stored here.
+ * @param data If not NULL, the payload of removed entry is stored here.
+ * @return HDS_OK on success or HDS_ERR_NO_SUCH_ELEMENT if heap is empty.
+ */
+int hds_heap_pop(struct hds_heap_t *heap, unsigned long int *key, void **data) {
+	if (heap->size == 0) {
+		return HDS_ERR_NO_SUCH_ELEMENT;
+	}
+	if (key) {
+		*key = heap->nodes[0].key;
+	}
+	if (data) {
+		*data = heap->nodes[0].data;
+	}
+	heap->size--;
+	if (heap->size > 0) {
+		heap->nodes[0] = heap->nodes[heap->size];
+		sift_down(heap, 0);
+	}
+	return HDS_OK;
+}
+/**
+ * @brief Look at the smallest entry without removing it.
+ * @return HDS_OK on success or HDS_ERR_NO_SUCH_ELEMENT if heap is empty.
+ */
+int hds_heap_peek(struct hds_heap_t *heap, unsigned long int *key, void **data) {
+	if (heap->size == 0) {
+		return HDS_ERR_NO_SUCH_ELEMENT;
+	}
+	if (key) {
+		*key = heap->nodes[0].key;
+	}
+	if (data) {
+		*data = heap->nodes[0].data;
+	}
+	return HDS_OK;
+}
+bool hds_heap_empty(struct hds_heap_t *heap) {
+	return (heap->size == 0);
+}
+static bool node_less(struct hds_heap_node_t *a, struct hds_heap_node_t *b) {
+	if (a->key != b->key) {
+		return (a->key < b->key);
+	}
+	return (a->seq < b->seq);
+}
+static void sift_up(struct hds_heap_t *heap, unsigned int pos) {
+	struct hds_heap_node_t tmp = heap->nodes[pos];
+	unsigned int parent;
+	while (pos > 0) {
+		parent = (pos - 1) / 2;
+		if (!node_less(&tmp, &heap->nodes[parent])) {
+			break;
+		}
+		heap->nodes[pos] = heap->nodes[parent];
+		pos = parent;
+	}
+	heap->nodes[pos] = tmp;
+}
+static void sift_down(struct hds_heap_t *heap, unsigned int pos) {
+	struct hds_heap_node_t tmp = heap->nodes[pos];
+	unsigned int child;
+	while ((child = 2 * pos + 1) < heap->size) {
+		//pick the smaller of the two children
+		if (child + 1 < heap->size
+				&& node_less(&heap->nodes[child + 1], &heap->nodes[child])) {
+			child++;
+		}
+		if (!node_less(&heap->nodes[child], &tmp)) {
+			break;
+		}
+		heap->nodes[pos] = heap->nodes[child];
+		pos = child;
+	}
+	heap->nodes[pos] = tmp;
+}
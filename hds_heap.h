@@ -0,0 +1,50 @@
+/**
+ * @file hds_heap.h
+ * @brief header file for hds_heap.c
+ */
+#ifndef HDS_HEAP_H_
+#define HDS_HEAP_H_
+
+#ifndef HDS_DTYPES_H_
+	#include "hds_dtypes.h"
+#endif
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include "hds_error.h"
+
+/**
+ * @def HDS_HEAP_INITIAL_CAPACITY
+ * @brief No. of nodes a heap can hold before it has to grow for the first time.
+ */
+#define HDS_HEAP_INITIAL_CAPACITY 64
+/**
+ * @struct hds_heap_node_t
+ * @brief A single entry of the heap. Entries are ordered on key first and
+ * 		then on seq, so that entries having equal keys come out in the order
+ * 		they were pushed (FCFS).
+ */
+struct hds_heap_node_t {
+	unsigned long int key;
+	unsigned long int seq;
+	void *data;
+};
+/**
+ * @struct hds_heap_t
+ * @brief An array backed binary min-heap.
+ */
+struct hds_heap_t {
+	struct hds_heap_node_t *nodes;
+	unsigned int size;
+	unsigned int capacity;
+	unsigned long int seq_counter; /**< Handed out to every pushed node. */
+};
+
+// --------routines-----------
+int hds_heap_init(struct hds_heap_t *heap, unsigned int capacity);
+void hds_heap_destroy(struct hds_heap_t *heap);
+int hds_heap_push(struct hds_heap_t *heap, unsigned long int key, void *data);
+int hds_heap_pop(struct hds_heap_t *heap, unsigned long int *key, void **data);
+int hds_heap_peek(struct hds_heap_t *heap, unsigned long int *key, void **data);
+bool hds_heap_empty(struct hds_heap_t *heap);
+#endif /* HDS_HEAP_H_ */
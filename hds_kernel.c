@@ -0,0 +1,267 @@
+/**
+ * @file hds_kernel.c
+ * @brief What a process of the realtime engine does while it runs, picked
+ * 		  per job with 'kernel' in process_list. A process runs its kernel
+ * 		  in rounds of about a millisecond, so that stopping it never waits
+ * 		  for more than a round; what it works on is set up in its first
+ * 		  round and kept from one round to the next.
+ *
+ * 		  sleep: does nothing. Puts no load on the host, unless quanta are
+ * 		  charged by CPU time consumed, then it keeps its cpu busy.
+ * 		  simd: multiplies and adds vectors of floats held in the L1 cache,
+ * 		  bound by the cpu alone.
+ * 		  stream: reads and writes every word of memory_req in order, so a
+ * 		  few of them running at once contend for memory bandwidth.
+ * 		  chase: follows a chain of pointers through memory_req, a cache
+ * 		  line a hop in random order; once memory_req is larger than the
+ * 		  caches every hop waits for memory.
+ * 		  io: writes a temporary file as large as memory_req, over and over,
+ * 		  and flushes it to disk whenever it starts over.
+ *
+ * 		  A kernel which can not be set up (out of memory, no temporary
+ * 		  file) sleeps instead. Nothing is logged, a forked child can not
+ * 		  safely take the log's lock.
+ */
+#include "hds_kernel.h"
+#include "hds_core.h"
+#include <stdint.h>
+/**
+ * @def STREAM_CHUNK
+ * @brief Words the stream kernel goes through between looks at the clock.
+ */
+#define STREAM_CHUNK 65536
+/**
+ * @def CHASE_HOPS
+ * @brief Hops the chase kernel makes between looks at the clock.
+ */
+#define CHASE_HOPS 1024
+/**
+ * @def CACHE_LINE
+ * @brief Bytes of a cache line, the chase kernel puts a pointer in each.
+ */
+#define CACHE_LINE 64
+/** Eight floats, one AVX register or two SSE/NEON ones */
+typedef float hds_v8sf_t __attribute__((vector_size(32)));
+//=========== routines declaration============
+static void sleep_round(struct hds_kernel_state_t *k, unsigned long int end_ns);
+static int simd_setup(struct hds_kernel_state_t *k);
+static void simd_round(struct hds_kernel_state_t *k, unsigned long int end_ns);
+static int stream_setup(struct hds_kernel_state_t *k);
+static void stream_round(struct hds_kernel_state_t *k,
+		unsigned long int end_ns);
+static int chase_setup(struct hds_kernel_state_t *k);
+static void chase_round(struct hds_kernel_state_t *k, unsigned long int end_ns);
+static int io_setup(struct hds_kernel_state_t *k);
+static void io_round(struct hds_kernel_state_t *k, unsigned long int end_ns);
+static int alloc_buf(struct hds_kernel_state_t *k, size_t size);
+static uint64_t next_random(uint64_t *state);
+//===========================================
+static struct hds_kernel_ops_t kernels[HDS_KERNELS] = {
+	[HDS_KERNEL_SLEEP] = { "sleep", NULL, sleep_round },
+	[HDS_KERNEL_SIMD] = { "simd", simd_setup, simd_round },
+	[HDS_KERNEL_STREAM] = { "stream", stream_setup, stream_round },
+	[HDS_KERNEL_CHASE] = { "chase", chase_setup, chase_round },
+	[HDS_KERNEL_IO] = { "io", io_setup, io_round },
+};
+/**
+ * @brief Name of a kernel as given for 'kernel' in process_list.
+ */
+const char *hds_kernel_name(hds_kernel_t kernel) {
+	return kernels[kernel].name;
+}
+/**
+ * @brief Kernel of a name as given for 'kernel' in process_list.
+ * @return The kernel or -1 if there is none.
+ */
+int hds_kernel_lookup(const char *name) {
+	int i;
+	for (i = 0; i < HDS_KERNELS; i++) {
+		if (strcmp(kernels[i].name, name) == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
+/**
+ * @brief Get k ready for the first round of a process. Takes nothing yet.
+ * @param memory_req Of the process; the memory kernels work on and the file
+ * 		the io kernel writes are this many HDS_KERNEL_MEM_UNIT, at least one.
+ */
+void hds_kernel_prepare(struct hds_kernel_state_t *k, hds_kernel_t kernel,
+		int memory_req) {
+	memset(k, 0, sizeof(struct hds_kernel_state_t));
+	k->kernel = kernel < HDS_KERNELS ? kernel : HDS_KERNEL_SLEEP;
+	k->size = (size_t) (memory_req > 0 ? memory_req : 1) * HDS_KERNEL_MEM_UNIT;
+	k->fd = -1;
+}
+/**
+ * @brief Work for us microseconds, a little longer in the first round if
+ * 		setting up takes longer. May be stopped and continued at any time.
+ */
+void hds_kernel_round(struct hds_kernel_state_t *k, unsigned int us) {
+	unsigned long int end_ns = hds_core_clock_ns() + us * 1000UL;
+	if (k->ready == false) {
+		k->ready = true;
+		if (kernels[k->kernel].setup && kernels[k->kernel].setup(k) != HDS_OK) {
+			hds_kernel_cleanup(k);
+			k->kernel = HDS_KERNEL_SLEEP;
+		}
+	}
+	kernels[k->kernel].round(k, end_ns);
+}
+/**
+ * @brief Free whatever the kernel of k took. k may be prepared only.
+ */
+void hds_kernel_cleanup(struct hds_kernel_state_t *k) {
+	free(k->buf);
+	k->buf = NULL;
+	if (k->fd != -1) {
+		close(k->fd);
+		k->fd = -1;
+	}
+}
+// //////////// sleep /////////////////////////////////
+static void sleep_round(struct hds_kernel_state_t *k, unsigned long int end_ns) {
+	unsigned long int now = hds_core_clock_ns();
+	if (hds_config.cpu_accounting != HDS_ACCOUNT_CPU) {
+		if (now < end_ns) {
+			usleep((end_ns - now) / 1000);
+		}
+		return;
+	}
+	// a sleeping process consumes next to no CPU time to be charged for
+	while (hds_core_clock_ns() < end_ns)
+		;
+}
+// //////////// simd //////////////////////////////////
+static int simd_setup(struct hds_kernel_state_t *k) {
+	float *f = NULL;
+	int i;
+	if (alloc_buf(k, 2 * HDS_KERNEL_SIMD_FLOATS * sizeof(float)) != HDS_OK) {
+		return HDS_ERR_NO_MEM;
+	}
+	f = (float *) k->buf;
+	for (i = 0; i < 2 * HDS_KERNEL_SIMD_FLOATS; i++) {
+		f[i] = i < HDS_KERNEL_SIMD_FLOATS ? 1.0f : 0.0f;
+	}
+	return HDS_OK;
+}
+static void simd_round(struct hds_kernel_state_t *k, unsigned long int end_ns) {
+	hds_v8sf_t *x = (hds_v8sf_t *) k->buf;
+	hds_v8sf_t *y = x + HDS_KERNEL_SIMD_FLOATS / 8;
+	int i;
+	do {
+		// y tends to x and stays there, nothing overflows or goes denormal
+		for (i = 0; i < HDS_KERNEL_SIMD_FLOATS / 8; i++) {
+			y[i] = x[i] * 0.25f + y[i] * 0.75f;
+		}
+	} while (hds_core_clock_ns() < end_ns);
+}
+// //////////// stream ////////////////////////////////
+static int stream_setup(struct hds_kernel_state_t *k) {
+	return alloc_buf(k, k->size);
+}
+static void stream_round(struct hds_kernel_state_t *k,
+		unsigned long int end_ns) {
+	uint64_t *w = (uint64_t *) k->buf;
+	size_t n = k->size / sizeof(uint64_t), i, stop;
+	do {
+		stop = n - k->pos < STREAM_CHUNK ? n : k->pos + STREAM_CHUNK;
+		for (i = k->pos; i < stop; i++) {
+			w[i] = w[i] * 3 + 1;
+		}
+		k->pos = stop == n ? 0 : stop;
+	} while (hds_core_clock_ns() < end_ns);
+}
+// //////////// chase /////////////////////////////////
+static int chase_setup(struct hds_kernel_state_t *k) {
+	size_t n = k->size / CACHE_LINE, i, j, tmp, *order = NULL;
+	uint64_t seed = hds_core_clock_ns() ^ getpid();
+	if (n < 2 || alloc_buf(k, k->size) != HDS_OK) {
+		return HDS_ERR_NO_MEM;
+	}
+	if (!(order = (size_t *) malloc(n * sizeof(size_t)))) {
+		return HDS_ERR_NO_MEM;
+	}
+	// lines in random order, each pointing to the next and the last back
+	// to the first: a single cycle through all of them
+	for (i = 0; i < n; i++) {
+		order[i] = i;
+	}
+	for (i = n - 1; i > 0; i--) {
+		j = next_random(&seed) % (i + 1);
+		tmp = order[i];
+		order[i] = order[j];
+		order[j] = tmp;
+	}
+	for (i = 0; i < n; i++) {
+		*(char **) (k->buf + order[i] * CACHE_LINE) = k->buf
+				+ order[(i + 1) % n] * CACHE_LINE;
+	}
+	free(order);
+	return HDS_OK;
+}
+static void chase_round(struct hds_kernel_state_t *k, unsigned long int end_ns) {
+	char **p = (char **) (k->buf + k->pos);
+	int i;
+	do {
+		for (i = 0; i < CHASE_HOPS; i++) {
+			p = (char **) *p;
+		}
+	} while (hds_core_clock_ns() < end_ns);
+	k->pos = (char *) p - k->buf;
+}
+// //////////// io ////////////////////////////////////
+static int io_setup(struct hds_kernel_state_t *k) {
+	char path[256];
+	const char *dir = getenv("TMPDIR");
+	if (alloc_buf(k, HDS_KERNEL_IO_BLOCK) != HDS_OK) {
+		return HDS_ERR_NO_MEM;
+	}
+	snprintf(path, sizeof(path), "%s/hds-io-XXXXXX", dir ? dir : "/tmp");
+	if ((k->fd = mkstemp(path)) == -1) {
+		return HDS_ERR_FILE_IO;
+	}
+	// gone as soon as the process is, however it ends
+	unlink(path);
+	return HDS_OK;
+}
+static void io_round(struct hds_kernel_state_t *k, unsigned long int end_ns) {
+	do {
+		if (write(k->fd, k->buf, HDS_KERNEL_IO_BLOCK) == HDS_KERNEL_IO_BLOCK) {
+			k->pos += HDS_KERNEL_IO_BLOCK;
+		} else {
+			// e.g. out of space, start over on what is written
+			k->pos = k->size;
+		}
+		if (k->pos >= k->size) {
+			fdatasync(k->fd);
+			lseek(k->fd, 0, SEEK_SET);
+			k->pos = 0;
+		}
+	} while (hds_core_clock_ns() < end_ns);
+}
+/**
+ * @brief Give k a buffer of size bytes, cache line aligned and with every
+ * 		page of it backed, so that setting up pays for the page faults and
+ * 		not the rounds.
+ */
+static int alloc_buf(struct hds_kernel_state_t *k, size_t size) {
+	void *buf = NULL;
+	if (posix_memalign(&buf, CACHE_LINE, size) != 0) {
+		return HDS_ERR_NO_MEM;
+	}
+	memset(buf, 1, size);
+	k->buf = (char *) buf;
+	return HDS_OK;
+}
+/**
+ * @brief xorshift64, enough to shuffle the chase kernel's lines.
+ */
+static uint64_t next_random(uint64_t *state) {
+	uint64_t x = *state ? *state : 1;
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	return *state = x;
+}
@@ -0,0 +1,66 @@
+/**
+ * @file hds_kernel.h
+ * @brief header file for hds_kernel.c
+ */
+#ifndef HDS_KERNEL_H_
+#define HDS_KERNEL_H_
+
+#include "hds_common.h"
+
+/**
+ * @def HDS_KERNEL_ROUND_US
+ * @brief A process runs its kernel in rounds of this long.
+ */
+#define HDS_KERNEL_ROUND_US 1000
+/**
+ * @def HDS_KERNEL_MEM_UNIT
+ * @brief Bytes a unit of memory_req stands for, in the memory a kernel
+ * 		works on and the file the io kernel writes.
+ */
+#define HDS_KERNEL_MEM_UNIT (1024 * 1024)
+/**
+ * @def HDS_KERNEL_IO_BLOCK
+ * @brief Bytes the io kernel writes at a time.
+ */
+#define HDS_KERNEL_IO_BLOCK (64 * 1024)
+/**
+ * @def HDS_KERNEL_SIMD_FLOATS
+ * @brief Length of each of the two vectors of the simd kernel, small enough
+ * 		for both to stay in the L1 cache.
+ */
+#define HDS_KERNEL_SIMD_FLOATS 2048
+
+/**
+ * @struct hds_kernel_state_t
+ * @brief What a process works on. Set up on its first round, so that a
+ * 		process pays for its own setup.
+ */
+struct hds_kernel_state_t {
+	hds_kernel_t kernel;
+	size_t size; /**< Bytes of buf, or of the file written */
+	bool ready;
+	char *buf;
+	size_t pos; /**< Where the next round goes on, in words or bytes */
+	int fd; /**< io kernel, -1 if none */
+};
+/**
+ * @struct hds_kernel_ops_t
+ * @brief A kernel, as named in process_list. setup may be NULL; whatever it
+ * 		takes is kept in buf and fd and freed by hds_kernel_cleanup().
+ */
+struct hds_kernel_ops_t {
+	const char *name;
+	/** Allocate and fill what it works on */
+	int (*setup)(struct hds_kernel_state_t *k);
+	/** Work until the clock reaches end_ns, at least once through */
+	void (*round)(struct hds_kernel_state_t *k, unsigned long int end_ns);
+};
+
+// --------routines-----------
+const char *hds_kernel_name(hds_kernel_t kernel);
+int hds_kernel_lookup(const char *name);
+void hds_kernel_prepare(struct hds_kernel_state_t *k, hds_kernel_t kernel,
+		int memory_req);
+void hds_kernel_round(struct hds_kernel_state_t *k, unsigned int us);
+void hds_kernel_cleanup(struct hds_kernel_state_t *k);
+#endif /* HDS_KERNEL_H_ */
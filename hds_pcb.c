@@ -0,0 +1,201 @@
+/**
+ * @file hds_pcb.c
+ * @brief Process control blocks. A process gets one block when it arrives
+ * 		  and keeps it until it completes or fails; moving between queues
+ * 		  and cpus only relinks the block. Blocks are carved out of slabs
+ * 		  which are never freed or moved while the core runs, so a block
+ * 		  can also be referred to by its handle, a small integer.
+ *
+ * 		  The few fields a scan over every process looks at, where the
+ * 		  block is and the priority and cpu_req it was queued with, are
+ * 		  also kept in an array each, indexed by handle. Such a scan reads
+ * 		  them from contiguous memory, a few bytes a process, instead of
+ * 		  touching every block.
+ */
+#include "hds_pcb.h"
+#include "hds_core.h"
+//=========== routines declaration============
+static int add_slab();
+//===========================================
+#define PCB_HANDLES (HDS_PCB_MAX_SLABS * HDS_PCB_SLAB_SIZE)
+/**
+ * @struct hds_pcb_pool_t
+ * @brief Every slab and the free blocks, linked through their next.
+ */
+static struct hds_pcb_pool_t {
+	struct process_queue_t *slab[HDS_PCB_MAX_SLABS];
+	unsigned int nslabs;
+	struct process_queue_t *free_list;
+	unsigned long int in_use; /**< Blocks handed out and not freed */
+	pthread_mutex_t lock; /**< Guards everything but slab[] reads */
+} pool;
+/**
+ * @struct hds_pcb_table_t
+ * @brief Fields of every block kept for scans. Not allocated: pages of it
+ * 		are only backed once there are slabs for their handles. Written by
+ * 		hds_pcb_track() and read at any time, so only accessed atomically.
+ */
+static struct hds_pcb_table_t {
+	unsigned char state[PCB_HANDLES]; /**< hds_pcb_state_t */
+	int priority[PCB_HANDLES];
+	int cpu_req[PCB_HANDLES];
+} table;
+
+/**
+ * @brief Set up an empty pool, slabs are added when blocks run out.
+ * @return HDS_OK on success else an error code.
+ */
+int hds_pcb_init() {
+	memset(&pool, 0, sizeof(pool));
+	if (pthread_mutex_init(&pool.lock, NULL ) != 0) {
+		serror("Failed to initialize mutex: pcb pool lock");
+		return HDS_ERR_GENERIC;
+	}
+	return HDS_OK;
+}
+/**
+ * @brief Free every slab. No block may be used afterwards.
+ */
+void hds_pcb_destroy() {
+	unsigned int i;
+	for (i = 0; i < pool.nslabs; i++) {
+		free(pool.slab[i]);
+		pool.slab[i] = NULL;
+	}
+	pool.nslabs = 0;
+	pool.free_list = NULL;
+	pool.in_use = 0;
+}
+/**
+ * @brief Take a block for a process which has just arrived. Every field but
+ * 		its handle is zero.
+ * @return The block or NULL if no more could be allocated.
+ */
+struct process_queue_t *hds_pcb_alloc() {
+	struct process_queue_t *p = NULL;
+	unsigned int handle;
+	pthread_mutex_lock(&pool.lock);
+	if (!pool.free_list && add_slab() != HDS_OK) {
+		pthread_mutex_unlock(&pool.lock);
+		return NULL;
+	}
+	p = pool.free_list;
+	pool.free_list = p->next;
+	pool.in_use++;
+	pthread_mutex_unlock(&pool.lock);
+
+	handle = p->handle;
+	memset(p, 0, sizeof(struct process_queue_t));
+	p->handle = handle;
+	hds_pcb_track(p, HDS_PCB_HELD);
+	return p;
+}
+/**
+ * @brief Give back the block of a process which has left the system. It must
+ * 		not be in any queue.
+ */
+void hds_pcb_free(struct process_queue_t *p) {
+	if (!p) {
+		return;
+	}
+	hds_pcb_track(p, HDS_PCB_FREE);
+	pthread_mutex_lock(&pool.lock);
+	p->next = pool.free_list;
+	pool.free_list = p;
+	pool.in_use--;
+	pthread_mutex_unlock(&pool.lock);
+}
+/**
+ * @brief Block of a handle.
+ * @return The block or NULL for HDS_PCB_NONE.
+ */
+struct process_queue_t *hds_pcb_get(unsigned int handle) {
+	if (handle == HDS_PCB_NONE) {
+		return NULL;
+	}
+	return &pool.slab[handle / HDS_PCB_SLAB_SIZE][handle % HDS_PCB_SLAB_SIZE];
+}
+/**
+ * @brief No. of blocks held by processes.
+ */
+unsigned long int hds_pcb_in_use() {
+	unsigned long int n;
+	pthread_mutex_lock(&pool.lock);
+	n = pool.in_use;
+	pthread_mutex_unlock(&pool.lock);
+	return n;
+}
+/**
+ * @brief Record where a block is now and, if it is being queued, the
+ * 		priority and cpu_req of its process. Called by the queues when they
+ * 		link or unlink it.
+ */
+void hds_pcb_track(const struct process_queue_t *p, hds_pcb_state_t state) {
+	unsigned int i = p->handle;
+	// only read for queued blocks
+	if (state >= HDS_PCB_USER_JOBQ) {
+		__atomic_store_n(&table.priority[i], p->priority, __ATOMIC_RELAXED);
+		__atomic_store_n(&table.cpu_req[i], p->cpu_req, __ATOMIC_RELAXED);
+	}
+	__atomic_store_n(&table.state[i], (unsigned char) state, __ATOMIC_RELAXED);
+}
+/**
+ * @brief Count blocks by state, and queued processes by priority and the
+ * 		cpu time they still need. Runs over the tracked fields only and
+ * 		takes no queue lock, so it is cheap enough for the stats screen at
+ * 		any no. of processes; a block moving meanwhile may be counted where
+ * 		it was or where it went.
+ */
+void hds_pcb_census(struct hds_pcb_census_t *c) {
+	unsigned int handles, i;
+	unsigned char state;
+	int priority, cpu_req;
+
+	memset(c, 0, sizeof(struct hds_pcb_census_t));
+	pthread_mutex_lock(&pool.lock);
+	handles = pool.nslabs * HDS_PCB_SLAB_SIZE;
+	pthread_mutex_unlock(&pool.lock);
+	// handle 0 is never handed out and stays HDS_PCB_FREE
+	for (i = 0; i < handles; i++) {
+		state = __atomic_load_n(&table.state[i], __ATOMIC_RELAXED);
+		c->state[state]++;
+		if (state < HDS_PCB_USER_JOBQ) {
+			continue;
+		}
+		priority = __atomic_load_n(&table.priority[i], __ATOMIC_RELAXED);
+		cpu_req = __atomic_load_n(&table.cpu_req[i], __ATOMIC_RELAXED);
+		if (priority >= 0 && priority < HDS_RUNQ_LEVELS) {
+			c->queued[priority]++;
+		}
+		c->backlog += cpu_req > 0 ? cpu_req : 0;
+	}
+}
+/**
+ * @brief Allocate one more slab and put its blocks on the free list. Called
+ * 		with the pool locked.
+ */
+static int add_slab() {
+	struct process_queue_t *slab = NULL;
+	unsigned int i;
+	if (pool.nslabs == HDS_PCB_MAX_SLABS) {
+		serror("Too many processes, out of process control blocks");
+		return HDS_ERR_NO_MEM;
+	}
+	slab = (struct process_queue_t *) calloc(HDS_PCB_SLAB_SIZE,
+			sizeof(struct process_queue_t));
+	if (!slab) {
+		serror("Failed to allocate a slab of process control blocks");
+		return HDS_ERR_NO_MEM;
+	}
+	// handle 0 is HDS_PCB_NONE, the first block of the first slab is not used
+	for (i = HDS_PCB_SLAB_SIZE; i-- > (pool.nslabs == 0);) {
+		slab[i].handle = pool.nslabs * HDS_PCB_SLAB_SIZE + i;
+		slab[i].next = pool.free_list;
+		pool.free_list = &slab[i];
+		// left from before a hds_pcb_destroy()
+		__atomic_store_n(&table.state[slab[i].handle], HDS_PCB_FREE,
+				__ATOMIC_RELAXED);
+	}
+	pool.slab[pool.nslabs++] = slab;
+	return HDS_OK;
+}
@@ -0,0 +1,63 @@
+/**
+ * @file hds_pcb.h
+ * @brief header file for hds_pcb.c
+ */
+#ifndef HDS_PCB_H_
+#define HDS_PCB_H_
+
+#include "hds_common.h"
+#include "hds_runq.h"
+
+/**
+ * @def HDS_PCB_SLAB_SIZE
+ * @brief No. of process control blocks carved out of one allocation.
+ */
+#define HDS_PCB_SLAB_SIZE 256
+/**
+ * @def HDS_PCB_MAX_SLABS
+ * @brief Most slabs there can be, i.e. HDS_PCB_MAX_SLABS * HDS_PCB_SLAB_SIZE
+ * 		processes in the system at once. The slab table is never moved, so
+ * 		a handle is turned into its block without a lock.
+ */
+#define HDS_PCB_MAX_SLABS 4096
+/**
+ * @def HDS_PCB_NONE
+ * @brief Handle which refers to no block.
+ */
+#define HDS_PCB_NONE 0
+
+/**
+ * @enum hds_pcb_state_t
+ * @brief Where a block is, kept by the queues which link it. Every state
+ * 		from HDS_PCB_USER_JOBQ on is a queue.
+ */
+typedef enum {
+	HDS_PCB_FREE, /**< On the free list */
+	HDS_PCB_HELD, /**< In no queue: next_to_run, active or being moved */
+	HDS_PCB_USER_JOBQ, /**< Arrived, not yet placed on a cpu */
+	HDS_PCB_RUNQ, /**< In the run queue or policy tree of a cpu */
+	HDS_PCB_RESOURCE_WAIT, /**< In resource_waitq */
+	HDS_PCB_STATES
+} hds_pcb_state_t;
+/**
+ * @struct hds_pcb_census_t
+ * @brief Counts over every block, see hds_pcb_census().
+ */
+struct hds_pcb_census_t {
+	unsigned long int state[HDS_PCB_STATES]; /**< No. of blocks in each state */
+	unsigned long int queued[HDS_RUNQ_LEVELS]; /**< Queued processes by priority */
+	unsigned long int backlog; /**< cpu_req left of queued processes */
+};
+
+struct process_queue_t;
+
+// --------routines-----------
+int hds_pcb_init();
+void hds_pcb_destroy();
+struct process_queue_t *hds_pcb_alloc();
+void hds_pcb_free(struct process_queue_t *p);
+struct process_queue_t *hds_pcb_get(unsigned int handle);
+unsigned long int hds_pcb_in_use();
+void hds_pcb_track(const struct process_queue_t *p, hds_pcb_state_t state);
+void hds_pcb_census(struct hds_pcb_census_t *c);
+#endif /* HDS_PCB_H_ */
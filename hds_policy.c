@@ -0,0 +1,457 @@
+/**
+ * @file hds_policy.c
+ * @brief Scheduling policies. The scheduler, cpu threads and the event
+ * 		  engine only decide when to look for work; which process is picked,
+ * 		  whether it may interrupt the active one and what happens to an
+ * 		  interrupted process is left to the policy selected with 'policy'
+ * 		  in hds.conf.
+ *
+ * 		  feedback and mlfq keep user processes on the priority levels of
+ * 		  the cpu's hds_runq_t. srtf, lottery and cfs keep them in a
+ * 		  hds_rbtree_t ordered on remaining cpu_req, memory needed and
+ * 		  vruntime respectively.
+ *
+ * 		  With aging_interval set, a process which has waited that long on
+ * 		  p2q or p3q moves one level up, so p3 processes can not starve
+ * 		  under a steady stream of p1 work. Only the priority levels are
+ * 		  aged; the tree policies do not order on priority.
+ */
+#include "hds_core.h"
+//=========== routines declaration============
+static int levels_enqueue(struct hds_cpu_t *cpu, struct process_queue_t *p);
+static struct process_queue_t *levels_pick_next(struct hds_cpu_t *cpu,
+		const hds_resvec_t *avail);
+static void levels_dequeue(struct hds_cpu_t *cpu, struct process_queue_t *p);
+static unsigned long int levels_count(struct hds_cpu_t *cpu);
+static bool priority_precedes(const struct process_queue_t *a,
+		const struct process_queue_t *b);
+static void feedback_on_preempt(struct hds_cpu_t *cpu,
+		struct process_queue_t *p);
+static bool mlfq_on_tick(struct hds_cpu_t *cpu, struct process_queue_t *active);
+static void levels_age(struct hds_cpu_t *cpu);
+
+static int tree_enqueue(struct hds_cpu_t *cpu, struct process_queue_t *p,
+		unsigned long int key);
+static struct process_queue_t *tree_pick_next(struct hds_cpu_t *cpu,
+		const hds_resvec_t *avail);
+static void tree_dequeue(struct hds_cpu_t *cpu, struct process_queue_t *p);
+static unsigned long int tree_count(struct hds_cpu_t *cpu);
+static unsigned long int weight_of(const struct process_queue_t *p);
+
+static int srtf_enqueue(struct hds_cpu_t *cpu, struct process_queue_t *p);
+static bool srtf_precedes(const struct process_queue_t *a,
+		const struct process_queue_t *b);
+
+static int lottery_enqueue(struct hds_cpu_t *cpu, struct process_queue_t *p);
+static struct process_queue_t *lottery_pick_next(struct hds_cpu_t *cpu,
+		const hds_resvec_t *avail);
+static unsigned long int lottery_key(const struct process_queue_t *p);
+static bool never_precedes(const struct process_queue_t *a,
+		const struct process_queue_t *b);
+static bool every_tick(struct hds_cpu_t *cpu, struct process_queue_t *active);
+static uint64_t lottery_rand(struct hds_cpu_t *cpu);
+
+static int cfs_enqueue(struct hds_cpu_t *cpu, struct process_queue_t *p);
+static bool cfs_precedes(const struct process_queue_t *a,
+		const struct process_queue_t *b);
+static bool cfs_on_tick(struct hds_cpu_t *cpu, struct process_queue_t *active);
+static void cfs_on_complete(struct hds_cpu_t *cpu, struct process_queue_t *p);
+static void cfs_update_min_vruntime(struct hds_cpu_t *cpu,
+		struct process_queue_t *active);
+//===========================================
+static struct hds_policy_ops_t policies[HDS_POLICIES] = {
+	[HDS_POLICY_FEEDBACK] = {
+		.name = "feedback",
+		.enqueue = levels_enqueue,
+		.pick_next = levels_pick_next,
+		.dequeue = levels_dequeue,
+		.count = levels_count,
+		.precedes = priority_precedes,
+		.on_preempt = feedback_on_preempt
+	},
+	[HDS_POLICY_MLFQ] = {
+		.name = "mlfq",
+		.enqueue = levels_enqueue,
+		.pick_next = levels_pick_next,
+		.dequeue = levels_dequeue,
+		.count = levels_count,
+		.precedes = priority_precedes,
+		.on_tick = mlfq_on_tick
+	},
+	[HDS_POLICY_SRTF] = {
+		.name = "srtf",
+		.enqueue = srtf_enqueue,
+		.pick_next = tree_pick_next,
+		.dequeue = tree_dequeue,
+		.count = tree_count,
+		.precedes = srtf_precedes
+	},
+	[HDS_POLICY_LOTTERY] = {
+		.name = "lottery",
+		.enqueue = lottery_enqueue,
+		.pick_next = lottery_pick_next,
+		.dequeue = tree_dequeue,
+		.count = tree_count,
+		.precedes = never_precedes,
+		.on_tick = every_tick
+	},
+	[HDS_POLICY_CFS] = {
+		.name = "cfs",
+		.enqueue = cfs_enqueue,
+		.pick_next = tree_pick_next,
+		.dequeue = tree_dequeue,
+		.count = tree_count,
+		.precedes = cfs_precedes,
+		.on_tick = cfs_on_tick,
+		.on_complete = cfs_on_complete
+	}
+};
+/**
+ * @brief Hooks of a policy.
+ */
+struct hds_policy_ops_t *hds_policy_get(hds_policy_t policy) {
+	return &policies[policy];
+}
+/**
+ * @brief Find a policy by its name.
+ * @return The policy or -1 if there is none of that name.
+ */
+int hds_policy_lookup(const char *name) {
+	int i;
+	for (i = 0; i < HDS_POLICIES; i++) {
+		if (strcmp(policies[i].name, name) == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
+/**
+ * @brief Set up policy state of a cpu.
+ */
+void hds_policy_init_cpu(struct hds_cpu_t *cpu) {
+	uint64_t z = HDS_LOTTERY_SEED + (uint64_t) cpu->id * 0x9e3779b97f4a7c15ULL;
+	hds_rbtree_init(&cpu->policy.tree);
+	cpu->policy.min_vruntime = 0;
+	cpu->policy.promotions = 0;
+	// splitmix64 step, xorshift needs a non zero state
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	cpu->policy.rng = (z ^ (z >> 31)) | 1;
+	cpu->slice_expired = false;
+}
+/**
+ * @brief Set up policy state of a process which has just arrived.
+ */
+void hds_policy_init_process(struct process_queue_t *p) {
+	p->sched.vruntime = 0;
+	p->sched.slice_used = 0;
+	p->sched.base_priority = p->priority;
+	p->sched.queued_at = 0;
+}
+/**
+ * @brief Tells if a should have the cpu before b. A realtime process comes
+ * 		before every user process and never after one; two realtime
+ * 		processes keep their FCFS order. User processes are left to the
+ * 		policy.
+ */
+bool hds_policy_precedes(const struct process_queue_t *a,
+		const struct process_queue_t *b) {
+	if (a->priority == 0 || b->priority == 0) {
+		return a->priority < b->priority;
+	}
+	return hds_core_state.policy->precedes(a, b);
+}
+/**
+ * @brief Tells if next should take the cpu from active: it comes first, or
+ * 		the slice of active is over and next does not come after it.
+ * @param slice_over Value returned by hds_policy_on_tick() for active.
+ */
+bool hds_policy_should_switch(const struct process_queue_t *next,
+		const struct process_queue_t *active, bool slice_over) {
+	if (hds_policy_precedes(next, active)) {
+		return true;
+	}
+	return slice_over && !hds_policy_precedes(active, next);
+}
+/**
+ * @brief active has been charged one more quantum.
+ * @return true if its slice is over. Never for a realtime process.
+ */
+bool hds_policy_on_tick(struct hds_cpu_t *cpu, struct process_queue_t *active) {
+	if (active->priority == 0 || !hds_core_state.policy->on_tick) {
+		return false;
+	}
+	return hds_core_state.policy->on_tick(cpu, active);
+}
+void hds_policy_on_preempt(struct hds_cpu_t *cpu, struct process_queue_t *p) {
+	if (hds_core_state.policy->on_preempt) {
+		hds_core_state.policy->on_preempt(cpu, p);
+	}
+}
+void hds_policy_on_complete(struct hds_cpu_t *cpu, struct process_queue_t *p) {
+	if (hds_core_state.policy->on_complete) {
+		hds_core_state.policy->on_complete(cpu, p);
+	}
+}
+/**
+ * @brief No. of processes moved up a level by aging, on every cpu.
+ */
+unsigned long int hds_policy_promotions() {
+	unsigned long int promotions = 0;
+	int i;
+	for (i = 0; i < hds_core_state.ncpus; i++) {
+		promotions += hds_core_state.cpu[i].policy.promotions;
+	}
+	return promotions;
+}
+// //////////// feedback and mlfq: priority levels //////
+static int levels_enqueue(struct hds_cpu_t *cpu, struct process_queue_t *p) {
+	p->sched.queued_at = hds_core_now();
+	return hds_runq_append(&cpu->runq, p);
+}
+static struct process_queue_t *levels_pick_next(struct hds_cpu_t *cpu,
+		const hds_resvec_t *avail) {
+	levels_age(cpu);
+	return hds_runq_find(&cpu->runq, avail);
+}
+static void levels_dequeue(struct hds_cpu_t *cpu, struct process_queue_t *p) {
+	hds_runq_unlink(&cpu->runq, p);
+}
+static unsigned long int levels_count(struct hds_cpu_t *cpu) {
+	return hds_runq_count(&cpu->runq);
+}
+static bool priority_precedes(const struct process_queue_t *a,
+		const struct process_queue_t *b) {
+	return a->priority < b->priority;
+}
+/**
+ * @brief feedback: an interrupted process goes one level down, p3 is the
+ * 		lowest.
+ */
+static void feedback_on_preempt(struct hds_cpu_t *cpu,
+		struct process_queue_t *p) {
+	if (p->priority > 0 && p->priority < HDS_RUNQ_LEVELS - 1) {
+		p->priority++;
+	}
+}
+/**
+ * @brief mlfq: a process goes one level down once it has used the quanta of
+ * 		its level, however many times it was interrupted in between. Its
+ * 		slice is over then, so it yields to processes on its new level.
+ */
+static bool mlfq_on_tick(struct hds_cpu_t *cpu, struct process_queue_t *active) {
+	active->sched.slice_used++;
+	if (active->sched.slice_used < hds_config.mlfq_quanta[active->priority - 1]) {
+		return false;
+	}
+	active->sched.slice_used = 0;
+	if (active->priority < HDS_RUNQ_LEVELS - 1) {
+		active->priority++;
+	}
+	return true;
+}
+/**
+ * @brief Move every process which has waited aging_interval on p2q or p3q
+ * 		one level up. Done lazily whenever a process is picked: a level is
+ * 		FCFS on the time its processes were queued, so only its head needs
+ * 		a look and each promotion is O(log n).
+ */
+static void levels_age(struct hds_cpu_t *cpu) {
+	struct process_queue_t *p = NULL;
+	unsigned long int now;
+	int i;
+
+	if (hds_config.aging_interval == 0) {
+		return;
+	}
+	now = hds_core_now();
+	// p1q is the top for user processes
+	for (i = 2; i < HDS_RUNQ_LEVELS; i++) {
+		while ((p = hds_runq_head(&cpu->runq, i)) != NULL
+				&& now - p->sched.queued_at >= hds_config.aging_interval) {
+			hds_runq_unlink(&cpu->runq, p);
+			p->priority--;
+			p->sched.slice_used = 0;
+			p->sched.queued_at = now;
+			if (hds_runq_append(&cpu->runq, p) != HDS_OK) {
+				// keep it where it was rather than lose it
+				serror("Failed to move an aged process up");
+				p->priority++;
+				hds_runq_append(&cpu->runq, p);
+				break;
+			}
+			cpu->policy.promotions++;
+		}
+	}
+}
+// //////////// srtf, lottery and cfs: a tree per cpu //////
+/**
+ * @brief Realtime processes go to the realtime level of the run queue, user
+ * 		processes into the tree at key.
+ */
+static int tree_enqueue(struct hds_cpu_t *cpu, struct process_queue_t *p,
+		unsigned long int key) {
+	if (p->priority == 0) {
+		return hds_runq_append(&cpu->runq, p);
+	}
+	if (p->priority < 0 || p->priority >= HDS_RUNQ_LEVELS) {
+		return HDS_ERR_INVALID_PROCESS;
+	}
+	hds_rbtree_insert(&cpu->policy.tree, p, key, weight_of(p));
+	hds_pcb_track(p, HDS_PCB_RUNQ);
+	return HDS_OK;
+}
+/**
+ * @brief Admissible realtime head, else the admissible user process with the
+ * 		smallest key.
+ */
+static struct process_queue_t *tree_pick_next(struct hds_cpu_t *cpu,
+		const hds_resvec_t *avail) {
+	struct process_queue_t *p = hds_runq_find(&cpu->runq, avail);
+	if (p) {
+		return p;
+	}
+	return hds_rbtree_first_fit(&cpu->policy.tree, avail);
+}
+static void tree_dequeue(struct hds_cpu_t *cpu, struct process_queue_t *p) {
+	if (p->priority == 0) {
+		hds_runq_unlink(&cpu->runq, p);
+	} else {
+		hds_rbtree_erase(&cpu->policy.tree, p);
+		hds_pcb_track(p, HDS_PCB_HELD);
+	}
+}
+static unsigned long int tree_count(struct hds_cpu_t *cpu) {
+	return hds_runq_count(&cpu->runq) + cpu->policy.tree.count;
+}
+/**
+ * @brief Share of the cpu given to a user process by lottery and cfs.
+ */
+static unsigned long int weight_of(const struct process_queue_t *p) {
+	return hds_config.policy_weights[p->priority - 1];
+}
+static int srtf_enqueue(struct hds_cpu_t *cpu, struct process_queue_t *p) {
+	return tree_enqueue(cpu, p, p->cpu_req > 0 ? p->cpu_req : 0);
+}
+static bool srtf_precedes(const struct process_queue_t *a,
+		const struct process_queue_t *b) {
+	return a->cpu_req < b->cpu_req;
+}
+/**
+ * @brief lottery: the tree is kept in order of memory needed, so the
+ * 		processes which get enough memory are always the first ones. Every
+ * 		quantum the cpu goes to the winner of a fresh draw.
+ */
+static int lottery_enqueue(struct hds_cpu_t *cpu, struct process_queue_t *p) {
+	return tree_enqueue(cpu, p, lottery_key(p));
+}
+/**
+ * @brief Draw a ticket over the queued user processes which get enough
+ * 		memory. They hold the first tickets of the tree, so both counting
+ * 		their tickets and finding the winner are O(log n). A winner whose
+ * 		devices are not free is drawn again, which keeps the draw fair among
+ * 		the ones that can be admitted; after HDS_LOTTERY_REDRAWS misses the
+ * 		first one that can be admitted wins.
+ */
+static struct process_queue_t *lottery_pick_next(struct hds_cpu_t *cpu,
+		const hds_resvec_t *avail) {
+	struct hds_rbtree_t *t = &cpu->policy.tree;
+	struct process_queue_t *p = hds_runq_find(&cpu->runq, avail);
+	unsigned long int total;
+	int i;
+
+	if (p) {
+		return p;
+	}
+	if ((*avail)[HDS_RES_MEMORY] < 0) {
+		return NULL;
+	}
+	total = hds_rbtree_tickets_below(t,
+			(unsigned long int) (*avail)[HDS_RES_MEMORY] + 1);
+	if (total == 0) {
+		return NULL;
+	}
+	for (i = 0; i < HDS_LOTTERY_REDRAWS; i++) {
+		p = hds_rbtree_draw(t, lottery_rand(cpu) % total);
+		if (hds_resvec_fits(hds_runq_need(p), avail)) {
+			return p;
+		}
+	}
+	return hds_rbtree_first_fit(t, avail);
+}
+/**
+ * @brief Tree key of lottery: memory a process still has to be given.
+ */
+static unsigned long int lottery_key(const struct process_queue_t *p) {
+	int need = (*hds_runq_need(p))[HDS_RES_MEMORY];
+	return need > 0 ? (unsigned long int) need : 0;
+}
+static bool never_precedes(const struct process_queue_t *a,
+		const struct process_queue_t *b) {
+	return false;
+}
+static bool every_tick(struct hds_cpu_t *cpu, struct process_queue_t *active) {
+	return true;
+}
+static uint64_t lottery_rand(struct hds_cpu_t *cpu) {
+	uint64_t x = cpu->policy.rng;
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	cpu->policy.rng = x;
+	return x * 0x2545f4914f6cdd1dULL;
+}
+/**
+ * @brief cfs: a process which arrives, or comes back after waiting, starts
+ * 		no lower than min_vruntime so that it can not claim the time it
+ * 		was away.
+ */
+static int cfs_enqueue(struct hds_cpu_t *cpu, struct process_queue_t *p) {
+	if (p->sched.vruntime < cpu->policy.min_vruntime) {
+		p->sched.vruntime = cpu->policy.min_vruntime;
+	}
+	return tree_enqueue(cpu, p, p->sched.vruntime);
+}
+static bool cfs_precedes(const struct process_queue_t *a,
+		const struct process_queue_t *b) {
+	return a->sched.vruntime < b->sched.vruntime;
+}
+/**
+ * @brief cfs: charge the quantum weighted by priority. The slice is always
+ * 		over, a process with no more vruntime than active then takes over.
+ */
+static bool cfs_on_tick(struct hds_cpu_t *cpu, struct process_queue_t *active) {
+	active->sched.vruntime += HDS_CFS_VRUNTIME_UNIT / weight_of(active);
+	cfs_update_min_vruntime(cpu, active);
+	return true;
+}
+static void cfs_on_complete(struct hds_cpu_t *cpu, struct process_queue_t *p) {
+	cfs_update_min_vruntime(cpu, NULL );
+}
+/**
+ * @brief min_vruntime follows the smallest vruntime of active and the queued
+ * 		processes, but never goes back.
+ */
+static void cfs_update_min_vruntime(struct hds_cpu_t *cpu,
+		struct process_queue_t *active) {
+	struct process_queue_t *first = NULL;
+	unsigned long int min;
+
+	pthread_mutex_lock(&cpu->rq_lock);
+	first = hds_rbtree_first(&cpu->policy.tree);
+	if (active && active->priority > 0) {
+		min = active->sched.vruntime;
+		if (first && first->sched.vruntime < min) {
+			min = first->sched.vruntime;
+		}
+	} else if (first) {
+		min = first->sched.vruntime;
+	} else {
+		pthread_mutex_unlock(&cpu->rq_lock);
+		return;
+	}
+	if (min > cpu->policy.min_vruntime) {
+		cpu->policy.min_vruntime = min;
+	}
+	pthread_mutex_unlock(&cpu->rq_lock);
+}
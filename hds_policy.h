@@ -0,0 +1,102 @@
+/**
+ * @file hds_policy.h
+ * @brief header file for hds_policy.c
+ */
+#ifndef HDS_POLICY_H_
+#define HDS_POLICY_H_
+
+#include "hds_common.h"
+#include "hds_rbtree.h"
+#include "hds_resource.h"
+#include <stdint.h>
+
+/**
+ * @def HDS_CFS_VRUNTIME_UNIT
+ * @brief vruntime charged for one quantum to a process of weight 1. A
+ * 		process of weight w is charged HDS_CFS_VRUNTIME_UNIT / w.
+ */
+#define HDS_CFS_VRUNTIME_UNIT (1UL << 20)
+/**
+ * @def HDS_LOTTERY_SEED
+ * @brief Seed of the lottery draws, mixed with the cpu id so that every cpu
+ * 		draws its own sequence and runs are repeatable.
+ */
+#define HDS_LOTTERY_SEED 0x5eed1077UL
+/**
+ * @def HDS_LOTTERY_REDRAWS
+ * @brief Draws made before lottery gives up on finding, by chance, a winner
+ * 		whose devices are free and takes the first one whose are.
+ */
+#define HDS_LOTTERY_REDRAWS 4
+
+struct process_queue_t;
+struct hds_cpu_t;
+/**
+ * @struct hds_sched_info_t
+ * @brief Per process state kept by the scheduling policy. It travels with the
+ * 		process as it moves between queues and cpu slots.
+ */
+struct hds_sched_info_t {
+	unsigned long int vruntime; /**< cfs: weighted cpu time received */
+	int slice_used; /**< mlfq: quanta used on the current level */
+	int base_priority; /**< Priority the process arrived with */
+	unsigned long int queued_at; /**< When it was last queued, for aging */
+};
+/**
+ * @struct hds_policy_rq_t
+ * @brief Per cpu state of the policies which order user processes on a key.
+ * 		Realtime processes are always kept FCFS on the realtime level of the
+ * 		cpu's hds_runq_t.
+ */
+struct hds_policy_rq_t {
+	struct hds_rbtree_t tree; /**< User processes of srtf, lottery and cfs */
+	unsigned long int min_vruntime; /**< cfs: smallest vruntime, never goes back */
+	uint64_t rng; /**< lottery: xorshift64* state */
+	unsigned long int promotions; /**< Processes moved up a level by aging */
+};
+/**
+ * @struct hds_policy_ops_t
+ * @brief Hooks of a scheduling policy. Queue hooks (enqueue, pick_next,
+ * 		dequeue, count) are called with the run queue lock of the cpu held.
+ * 		on_tick, on_preempt and on_complete may be NULL.
+ *
+ * Realtime processes are handled the same way by every policy: they run
+ * before any user process, in FCFS order, and are never interrupted. See
+ * hds_policy_precedes().
+ */
+struct hds_policy_ops_t {
+	const char *name; /**< As given for 'policy' in hds.conf */
+	/** Queue p on cpu. HDS_OK or an error code, then p is left to the caller */
+	int (*enqueue)(struct hds_cpu_t *cpu, struct process_queue_t *p);
+	/** Process which should run next and passes the admission test; it stays queued */
+	struct process_queue_t *(*pick_next)(struct hds_cpu_t *cpu,
+			const hds_resvec_t *avail);
+	/** Take a process returned by pick_next out of the queues of cpu */
+	void (*dequeue)(struct hds_cpu_t *cpu, struct process_queue_t *p);
+	/** No. of processes queued on cpu */
+	unsigned long int (*count)(struct hds_cpu_t *cpu);
+	/** Whether user process a should have the cpu before user process b */
+	bool (*precedes)(const struct process_queue_t *a,
+			const struct process_queue_t *b);
+	/** active has run one more quantum. true if its slice is over */
+	bool (*on_tick)(struct hds_cpu_t *cpu, struct process_queue_t *active);
+	/** p was interrupted or replaced and is about to be queued again */
+	void (*on_preempt)(struct hds_cpu_t *cpu, struct process_queue_t *p);
+	/** p has used up its cpu_req and leaves cpu */
+	void (*on_complete)(struct hds_cpu_t *cpu, struct process_queue_t *p);
+};
+
+// --------routines-----------
+struct hds_policy_ops_t *hds_policy_get(hds_policy_t policy);
+int hds_policy_lookup(const char *name);
+void hds_policy_init_cpu(struct hds_cpu_t *cpu);
+void hds_policy_init_process(struct process_queue_t *p);
+bool hds_policy_precedes(const struct process_queue_t *a,
+		const struct process_queue_t *b);
+bool hds_policy_should_switch(const struct process_queue_t *next,
+		const struct process_queue_t *active, bool slice_over);
+bool hds_policy_on_tick(struct hds_cpu_t *cpu, struct process_queue_t *active);
+void hds_policy_on_preempt(struct hds_cpu_t *cpu, struct process_queue_t *p);
+void hds_policy_on_complete(struct hds_cpu_t *cpu, struct process_queue_t *p);
+unsigned long int hds_policy_promotions();
+#endif /* HDS_POLICY_H_ */
@@ -0,0 +1,362 @@
+/**
+ * @file hds_rbtree.c
+ * @brief Intrusive red-black tree of processes, used by the scheduling
+ * 		  policies which order processes on a key (remaining cpu time,
+ * 		  memory needed, vruntime) instead of a priority level. Insert and
+ * 		  erase are O(log n). The first process which passes the admission
+ * 		  test is found through the minimum need kept for every subtree,
+ * 		  without visiting subtrees which can not hold one.
+ */
+#include "hds_core.h"
+//=========== routines declaration============
+static bool node_less(const struct process_queue_t *a,
+		const struct process_queue_t *b);
+static void update_node(struct process_queue_t *n);
+static void update_to_root(struct process_queue_t *n);
+static void rotate_left(struct hds_rbtree_t *t, struct process_queue_t *x);
+static void rotate_right(struct hds_rbtree_t *t, struct process_queue_t *x);
+static void insert_fixup(struct hds_rbtree_t *t, struct process_queue_t *z);
+static void erase_fixup(struct hds_rbtree_t *t, struct process_queue_t *x,
+		struct process_queue_t *xp);
+static void transplant(struct hds_rbtree_t *t, struct process_queue_t *u,
+		struct process_queue_t *v);
+static struct process_queue_t *leftmost(struct process_queue_t *n);
+static struct process_queue_t *first_fit(struct process_queue_t *n,
+		const hds_resvec_t *avail);
+static bool is_red(const struct process_queue_t *n);
+//===========================================
+/**
+ * @brief Initialise an empty tree.
+ */
+void hds_rbtree_init(struct hds_rbtree_t *t) {
+	t->root = NULL;
+	t->count = 0;
+	t->next_seq = 0;
+}
+/**
+ * @brief Insert a node. Among nodes with the same key it goes last.
+ * @param key Position of the node in the tree, smallest first.
+ * @param tickets Weight of the node for hds_rbtree_draw(), at least 1.
+ */
+void hds_rbtree_insert(struct hds_rbtree_t *t, struct process_queue_t *node,
+		unsigned long int key, unsigned long int tickets) {
+	struct process_queue_t *parent = NULL, *n = t->root;
+
+	node->rb.key = key;
+	node->rb.seq = t->next_seq++;
+	node->rb.tickets = tickets;
+	node->rb.left = node->rb.right = NULL;
+	node->rb.red = true;
+	while (n) {
+		parent = n;
+		n = node_less(node, n) ? n->rb.left : n->rb.right;
+	}
+	node->rb.parent = parent;
+	if (!parent) {
+		t->root = node;
+	} else if (node_less(node, parent)) {
+		parent->rb.left = node;
+	} else {
+		parent->rb.right = node;
+	}
+	update_to_root(node);
+	insert_fixup(t, node);
+	t->count++;
+}
+/**
+ * @brief Take a node out of the tree. The node is left to the caller.
+ */
+void hds_rbtree_erase(struct hds_rbtree_t *t, struct process_queue_t *z) {
+	struct process_queue_t *y = z, *x = NULL, *xp = NULL;
+	bool y_red = z->rb.red;
+
+	if (!z->rb.left) {
+		x = z->rb.right;
+		xp = z->rb.parent;
+		transplant(t, z, z->rb.right);
+	} else if (!z->rb.right) {
+		x = z->rb.left;
+		xp = z->rb.parent;
+		transplant(t, z, z->rb.left);
+	} else {
+		// successor takes the place of z
+		y = leftmost(z->rb.right);
+		y_red = y->rb.red;
+		x = y->rb.right;
+		if (y->rb.parent == z) {
+			xp = y;
+		} else {
+			xp = y->rb.parent;
+			transplant(t, y, y->rb.right);
+			y->rb.right = z->rb.right;
+			y->rb.right->rb.parent = y;
+		}
+		transplant(t, z, y);
+		y->rb.left = z->rb.left;
+		y->rb.left->rb.parent = y;
+		y->rb.red = z->rb.red;
+	}
+	// subtree values first, rotations done while fixing colours keep them
+	update_to_root(xp);
+	if (y_red == false) {
+		erase_fixup(t, x, xp);
+	}
+	t->count--;
+	z->rb.left = z->rb.right = z->rb.parent = NULL;
+}
+/**
+ * @brief Node with the smallest key, NULL if the tree is empty.
+ */
+struct process_queue_t *hds_rbtree_first(struct hds_rbtree_t *t) {
+	return t->root ? leftmost(t->root) : NULL;
+}
+/**
+ * @brief First node in key order whose need fits in avail, see
+ * 		hds_runq_need().
+ * @param avail Resources available for new processes.
+ * @return The node or NULL if none can be admitted.
+ */
+struct process_queue_t *hds_rbtree_first_fit(struct hds_rbtree_t *t,
+		const hds_resvec_t *avail) {
+	return first_fit(t->root, avail);
+}
+/**
+ * @brief Find the node holding a ticket. Tickets of the nodes are numbered
+ * 		one after the other in key order.
+ * @param ticket A no. below hds_rbtree_tickets().
+ * @return The node or NULL if ticket is out of range.
+ */
+struct process_queue_t *hds_rbtree_draw(struct hds_rbtree_t *t,
+		unsigned long int ticket) {
+	struct process_queue_t *n = t->root;
+	unsigned long int left;
+	while (n) {
+		left = n->rb.left ? n->rb.left->rb.sum_tickets : 0;
+		if (ticket < left) {
+			n = n->rb.left;
+		} else if (ticket < left + n->rb.tickets) {
+			return n;
+		} else {
+			ticket -= left + n->rb.tickets;
+			n = n->rb.right;
+		}
+	}
+	return NULL;
+}
+/**
+ * @brief Tickets of the nodes whose key is below limit. These are the first
+ * 		tickets in hds_rbtree_draw() order.
+ */
+unsigned long int hds_rbtree_tickets_below(struct hds_rbtree_t *t,
+		unsigned long int limit) {
+	struct process_queue_t *n = t->root;
+	unsigned long int sum = 0;
+	while (n) {
+		if (n->rb.key < limit) {
+			sum += n->rb.tickets
+					+ (n->rb.left ? n->rb.left->rb.sum_tickets : 0);
+			n = n->rb.right;
+		} else {
+			n = n->rb.left;
+		}
+	}
+	return sum;
+}
+static bool node_less(const struct process_queue_t *a,
+		const struct process_queue_t *b) {
+	return a->rb.key < b->rb.key
+			|| (a->rb.key == b->rb.key && a->rb.seq < b->rb.seq);
+}
+/**
+ * @brief Recompute subtree values of n from its children.
+ */
+static void update_node(struct process_queue_t *n) {
+	hds_resvec_t min = *hds_runq_need(n);
+	unsigned long int sum = n->rb.tickets;
+	if (n->rb.left) {
+		hds_resvec_min(&min, &min, &n->rb.left->rb.min_need);
+		sum += n->rb.left->rb.sum_tickets;
+	}
+	if (n->rb.right) {
+		hds_resvec_min(&min, &min, &n->rb.right->rb.min_need);
+		sum += n->rb.right->rb.sum_tickets;
+	}
+	n->rb.min_need = min;
+	n->rb.sum_tickets = sum;
+}
+static void update_to_root(struct process_queue_t *n) {
+	for (; n != NULL ; n = n->rb.parent) {
+		update_node(n);
+	}
+}
+static void rotate_left(struct hds_rbtree_t *t, struct process_queue_t *x) {
+	struct process_queue_t *y = x->rb.right;
+	x->rb.right = y->rb.left;
+	if (y->rb.left) {
+		y->rb.left->rb.parent = x;
+	}
+	transplant(t, x, y);
+	y->rb.left = x;
+	x->rb.parent = y;
+	update_node(x);
+	update_node(y);
+}
+static void rotate_right(struct hds_rbtree_t *t, struct process_queue_t *x) {
+	struct process_queue_t *y = x->rb.left;
+	x->rb.left = y->rb.right;
+	if (y->rb.right) {
+		y->rb.right->rb.parent = x;
+	}
+	transplant(t, x, y);
+	y->rb.right = x;
+	x->rb.parent = y;
+	update_node(x);
+	update_node(y);
+}
+static void insert_fixup(struct hds_rbtree_t *t, struct process_queue_t *z) {
+	struct process_queue_t *p = NULL, *g = NULL, *u = NULL;
+	while ((p = z->rb.parent) != NULL && p->rb.red) {
+		// a red parent is never the root, so g exists
+		g = p->rb.parent;
+		if (p == g->rb.left) {
+			u = g->rb.right;
+			if (is_red(u)) {
+				p->rb.red = u->rb.red = false;
+				g->rb.red = true;
+				z = g;
+				continue;
+			}
+			if (z == p->rb.right) {
+				z = p;
+				rotate_left(t, z);
+				p = z->rb.parent;
+			}
+			p->rb.red = false;
+			g->rb.red = true;
+			rotate_right(t, g);
+		} else {
+			u = g->rb.left;
+			if (is_red(u)) {
+				p->rb.red = u->rb.red = false;
+				g->rb.red = true;
+				z = g;
+				continue;
+			}
+			if (z == p->rb.left) {
+				z = p;
+				rotate_right(t, z);
+				p = z->rb.parent;
+			}
+			p->rb.red = false;
+			g->rb.red = true;
+			rotate_left(t, g);
+		}
+	}
+	t->root->rb.red = false;
+}
+/**
+ * @brief Restore colours after erase. x, which may be NULL, has one black too
+ * 		few on its side; xp is its parent.
+ */
+static void erase_fixup(struct hds_rbtree_t *t, struct process_queue_t *x,
+		struct process_queue_t *xp) {
+	struct process_queue_t *w = NULL;
+	while (x != t->root && !is_red(x)) {
+		if (x == xp->rb.left) {
+			w = xp->rb.right;
+			if (is_red(w)) {
+				w->rb.red = false;
+				xp->rb.red = true;
+				rotate_left(t, xp);
+				w = xp->rb.right;
+			}
+			if (!is_red(w->rb.left) && !is_red(w->rb.right)) {
+				w->rb.red = true;
+				x = xp;
+				xp = x->rb.parent;
+				continue;
+			}
+			if (!is_red(w->rb.right)) {
+				w->rb.left->rb.red = false;
+				w->rb.red = true;
+				rotate_right(t, w);
+				w = xp->rb.right;
+			}
+			w->rb.red = xp->rb.red;
+			xp->rb.red = false;
+			w->rb.right->rb.red = false;
+			rotate_left(t, xp);
+		} else {
+			w = xp->rb.left;
+			if (is_red(w)) {
+				w->rb.red = false;
+				xp->rb.red = true;
+				rotate_right(t, xp);
+				w = xp->rb.left;
+			}
+			if (!is_red(w->rb.left) && !is_red(w->rb.right)) {
+				w->rb.red = true;
+				x = xp;
+				xp = x->rb.parent;
+				continue;
+			}
+			if (!is_red(w->rb.left)) {
+				w->rb.right->rb.red = false;
+				w->rb.red = true;
+				rotate_left(t, w);
+				w = xp->rb.left;
+			}
+			w->rb.red = xp->rb.red;
+			xp->rb.red = false;
+			w->rb.left->rb.red = false;
+			rotate_right(t, xp);
+		}
+		x = t->root;
+	}
+	if (x) {
+		x->rb.red = false;
+	}
+}
+/**
+ * @brief Put v where u was as the child of u's parent.
+ */
+static void transplant(struct hds_rbtree_t *t, struct process_queue_t *u,
+		struct process_queue_t *v) {
+	if (!u->rb.parent) {
+		t->root = v;
+	} else if (u == u->rb.parent->rb.left) {
+		u->rb.parent->rb.left = v;
+	} else {
+		u->rb.parent->rb.right = v;
+	}
+	if (v) {
+		v->rb.parent = u->rb.parent;
+	}
+}
+static struct process_queue_t *leftmost(struct process_queue_t *n) {
+	while (n->rb.left) {
+		n = n->rb.left;
+	}
+	return n;
+}
+/**
+ * @brief First node of the subtree at n, in key order, whose need fits. A
+ * 		subtree whose minimum need does not fit is not entered.
+ */
+static struct process_queue_t *first_fit(struct process_queue_t *n,
+		const hds_resvec_t *avail) {
+	struct process_queue_t *found = NULL;
+	if (!n || !hds_resvec_fits(&n->rb.min_need, avail)) {
+		return NULL;
+	}
+	if ((found = first_fit(n->rb.left, avail)) != NULL) {
+		return found;
+	}
+	if (hds_resvec_fits(hds_runq_need(n), avail)) {
+		return n;
+	}
+	return first_fit(n->rb.right, avail);
+}
+static bool is_red(const struct process_queue_t *n) {
+	return n != NULL && n->rb.red;
+}
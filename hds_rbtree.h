@@ -0,0 +1,55 @@
+/**
+ * @file hds_rbtree.h
+ * @brief header file for hds_rbtree.c
+ */
+#ifndef HDS_RBTREE_H_
+#define HDS_RBTREE_H_
+
+#include "hds_common.h"
+#include "hds_resource.h"
+
+struct process_queue_t;
+/**
+ * @struct hds_rb_link_t
+ * @brief Links of a process in a hds_rbtree_t, kept in the process itself so
+ * 		that a tree never allocates. Only valid while the process is in a
+ * 		tree.
+ *
+ * Every node also holds two values over its whole subtree: the lane wise
+ * minimum of what its processes need, so that subtrees holding no process
+ * which can be admitted are skipped, and the sum of tickets, so that a
+ * ticket can be looked up by walking down from the root.
+ */
+struct hds_rb_link_t {
+	struct process_queue_t *left, *right, *parent;
+	bool red;
+	unsigned long int key; /**< Nodes are ordered on (key, seq) */
+	unsigned long int seq; /**< Insertion order, ties are FCFS */
+	unsigned long int tickets; /**< Weight of the node, see hds_rbtree_draw() */
+	hds_resvec_t min_need; /**< Lane wise minimum need in the subtree */
+	unsigned long int sum_tickets; /**< Tickets of the subtree */
+};
+/**
+ * @struct hds_rbtree_t
+ * @brief A red-black tree of processes. Not locked here: callers hold the
+ * 		lock of the cpu owning it.
+ */
+struct hds_rbtree_t {
+	struct process_queue_t *root;
+	unsigned long int count;
+	unsigned long int next_seq;
+};
+
+// --------routines-----------
+void hds_rbtree_init(struct hds_rbtree_t *t);
+void hds_rbtree_insert(struct hds_rbtree_t *t, struct process_queue_t *node,
+		unsigned long int key, unsigned long int tickets);
+void hds_rbtree_erase(struct hds_rbtree_t *t, struct process_queue_t *node);
+struct process_queue_t *hds_rbtree_first(struct hds_rbtree_t *t);
+struct process_queue_t *hds_rbtree_first_fit(struct hds_rbtree_t *t,
+		const hds_resvec_t *avail);
+struct process_queue_t *hds_rbtree_draw(struct hds_rbtree_t *t,
+		unsigned long int ticket);
+unsigned long int hds_rbtree_tickets_below(struct hds_rbtree_t *t,
+		unsigned long int limit);
+#endif /* HDS_RBTREE_H_ */
@@ -0,0 +1,382 @@
+/**
+ * @file hds_report.c
+ * @brief Writes per-job and aggregate results of a run in a machine readable
+ * 		  format (CSV or JSON).
+ */
+#include "hds_report.h"
+#include "hds_sim.h"
+#include "hds_workers.h"
+#include "hds_exec.h"
+//=========== routines declaration============
+static void write_summary_field(const char *name, double value, bool last);
+static void write_banker_fields();
+static void write_rt_fields();
+//===========================================
+/**
+ * @brief Start writing results.
+ * @param filename File to write results to. NULL or "-" means stdout.
+ * @param format One of HDS_REPORT_CSV or HDS_REPORT_JSON.
+ * @return HDS_OK on success else HDS_ERR_FILE_IO.
+ */
+int hds_report_open(const char *filename, hds_report_format_t format) {
+	memset(&hds_report, 0, sizeof(hds_report));
+	if (!filename || strcmp(filename, "-") == 0) {
+		hds_report.out = stdout;
+	} else if (!(hds_report.out = fopen(filename, "w"))) {
+		fprintf(stderr, "Failed to open results file: %s\n", filename);
+		return HDS_ERR_FILE_IO;
+	}
+	if (pthread_mutex_init(&hds_report.lock, NULL ) != 0) {
+		fprintf(stderr, "Failed to initialize mutex: report lock\n");
+		return HDS_ERR_GENERIC;
+	}
+	hds_report.format = format;
+	hds_report.first_arrival = (unsigned long int) -1;
+	hds_report.enabled = true;
+
+	switch (format) {
+	case HDS_REPORT_JSON:
+		fprintf(hds_report.out, "{\"jobs\":[");
+		break;
+	default:
+		fprintf(hds_report.out,
+				"job_id,pid,priority,cpu_req,cpu_consumed,cpu_wall,"
+				"memory_req,printer_req,scanner_req,"
+				"arrival,start,completion,turnaround,wait,response,preemptions,status\n");
+		break;
+	}
+	return HDS_OK;
+}
+/**
+ * @brief Record a process leaving the system. Called by the cpu thread and the
+ * 		event engine. Does nothing unless results are being written.
+ * @param process The process, times are taken from it and hds_core_now().
+ * @param status Whether it completed or was dropped.
+ */
+void hds_report_job(struct process_queue_t *process, hds_job_status_t status) {
+	unsigned long int now, turnaround, wait, response = 0;
+	double consumed, wall;
+	int cpu_used;
+	if (hds_report.enabled == false) {
+		return;
+	}
+	now = hds_core_now();
+	turnaround = now - process->arrival_time;
+	cpu_used = process->cpu_total
+			- (process->cpu_req > 0 ? process->cpu_req : 0);
+	wait = turnaround - cpu_used;
+	// in quanta, next to cpu_req; the event engine runs exactly what it is
+	// charged for
+	if (hds_config.engine == HDS_ENGINE_REALTIME) {
+		consumed = (double) process->cpu_ns / HDS_QUANTUM_NS;
+		wall = (double) process->wall_ns / HDS_QUANTUM_NS;
+	} else {
+		consumed = wall = cpu_used;
+	}
+	if (status == HDS_JOB_COMPLETED) {
+		response = process->start_time - process->arrival_time;
+	}
+
+	pthread_mutex_lock(&hds_report.lock);
+	switch (hds_report.format) {
+	case HDS_REPORT_JSON:
+		fprintf(hds_report.out,
+				"%s\n{\"job_id\":%u,\"pid\":%d,\"priority\":%d,\"cpu_req\":%d,"
+				"\"cpu_consumed\":%.3f,\"cpu_wall\":%.3f,"
+				"\"memory_req\":%d,\"printer_req\":%d,\"scanner_req\":%d,"
+				"\"arrival\":%lu,\"start\":%lu,\"completion\":%lu,"
+				"\"turnaround\":%lu,\"wait\":%lu,\"response\":%lu,"
+				"\"preemptions\":%d,\"status\":\"%s\"}",
+				hds_report.rows ? "," : "", process->job_id, process->pid,
+				process->priority, process->cpu_total, consumed, wall,
+				process->req[HDS_RES_MEMORY], process->req[HDS_RES_PRINTER],
+				process->req[HDS_RES_SCANNER],
+				process->arrival_time, process->start_time, now, turnaround,
+				wait, response, process->preemptions,
+				status == HDS_JOB_COMPLETED ? "completed" : "failed");
+		break;
+	default:
+		fprintf(hds_report.out,
+				"%u,%d,%d,%d,%.3f,%.3f,%d,%d,%d,%lu,%lu,%lu,%lu,%lu,%lu,%d,%s\n",
+				process->job_id, process->pid, process->priority,
+				process->cpu_total, consumed, wall, process->req[HDS_RES_MEMORY],
+				process->req[HDS_RES_PRINTER], process->req[HDS_RES_SCANNER],
+				process->arrival_time,
+				process->start_time, now, turnaround, wait, response,
+				process->preemptions,
+				status == HDS_JOB_COMPLETED ? "completed" : "failed");
+		break;
+	}
+	hds_report.rows++;
+
+	hds_report.preemptions += process->preemptions;
+	if (process->arrival_time < hds_report.first_arrival) {
+		hds_report.first_arrival = process->arrival_time;
+	}
+	if (now > hds_report.last_completion) {
+		hds_report.last_completion = now;
+	}
+	if (status == HDS_JOB_COMPLETED) {
+		hds_report.jobs_completed++;
+		hds_report.cpu_time += cpu_used;
+		hds_report.cpu_ns += process->cpu_ns;
+		hds_report.wall_ns += process->wall_ns;
+		hds_report.total_turnaround += turnaround;
+		hds_report.total_wait += wait;
+		hds_report.total_response += response;
+		hds_hist_add(&hds_report.turnaround, turnaround);
+		hds_hist_add(&hds_report.wait, wait);
+		if (process->sched.base_priority >= 1
+				&& process->sched.base_priority <= HDS_USER_PRIORITIES) {
+			hds_hist_add(
+					&hds_report.wait_by_priority[process->sched.base_priority
+							- 1], wait);
+		}
+		if (turnaround > hds_report.max_turnaround) {
+			hds_report.max_turnaround = turnaround;
+		}
+		if (wait > hds_report.max_wait) {
+			hds_report.max_wait = wait;
+		}
+		if (response > hds_report.max_response) {
+			hds_report.max_response = response;
+		}
+	} else {
+		hds_report.jobs_failed++;
+	}
+	pthread_mutex_unlock(&hds_report.lock);
+}
+/**
+ * @brief Record how long a realtime process waited for a cpu, from being
+ * 		queued until it first ran. Called by the cpu thread. Does nothing
+ * 		unless results are being written.
+ */
+void hds_report_rt_latency(unsigned long int latency_ns) {
+	if (hds_report.enabled == false) {
+		return;
+	}
+	pthread_mutex_lock(&hds_report.lock);
+	hds_hist_add(&hds_report.rt_latency, latency_ns / 1000);
+	pthread_mutex_unlock(&hds_report.lock);
+}
+/**
+ * @brief Write aggregate results and stop writing.
+ * @param wall_time_ns Wall clock time taken by the whole run.
+ */
+void hds_report_close(long int wall_time_ns) {
+	unsigned long int makespan = 0, completed = hds_report.jobs_completed;
+	unsigned long int reaped, bad_exits;
+	double div;
+	char name[32];
+	int i;
+	if (hds_report.enabled == false) {
+		return;
+	}
+	if (hds_report.rows > 0) {
+		makespan = hds_report.last_completion - hds_report.first_arrival;
+	}
+	div = completed ? completed : 1;
+
+	switch (hds_report.format) {
+	case HDS_REPORT_JSON:
+		fprintf(hds_report.out,
+				"\n],\n\"summary\":{\"engine\":\"%s\",\"policy\":\"%s\",",
+				hds_config.engine == HDS_ENGINE_EVENT ? "event" : "realtime",
+				hds_core_state.policy->name);
+		break;
+	default:
+		fprintf(hds_report.out, "# summary\n# engine,%s\n# policy,%s\n",
+				hds_config.engine == HDS_ENGINE_EVENT ? "event" : "realtime",
+				hds_core_state.policy->name);
+		break;
+	}
+	write_summary_field("cpus", hds_core_state.ncpus, false);
+	write_summary_field("jobs_completed", completed, false);
+	write_summary_field("jobs_failed", hds_report.jobs_failed, false);
+	write_summary_field("jobs_stranded", count_queued_processes(), false);
+	write_summary_field("preemptions", hds_report.preemptions, false);
+	write_summary_field("makespan", makespan, false);
+	write_summary_field("throughput",
+			makespan ? (double) completed / makespan : 0, false);
+	// share of the time all cpus together could have run a process
+	write_summary_field("cpu_utilisation",
+			makespan ?
+					(double) hds_report.cpu_time
+							/ (makespan * hds_core_state.ncpus) :
+					0, false);
+	write_summary_field("avg_turnaround", hds_report.total_turnaround / div,
+			false);
+	write_summary_field("p95_turnaround",
+			hds_hist_quantile(&hds_report.turnaround, 0.95), false);
+	write_summary_field("p99_turnaround",
+			hds_hist_quantile(&hds_report.turnaround, 0.99), false);
+	write_summary_field("max_turnaround", hds_report.max_turnaround, false);
+	write_summary_field("avg_wait", hds_report.total_wait / div, false);
+	write_summary_field("p95_wait", hds_hist_quantile(&hds_report.wait, 0.95),
+			false);
+	write_summary_field("p99_wait", hds_hist_quantile(&hds_report.wait, 0.99),
+			false);
+	write_summary_field("max_wait", hds_report.max_wait, false);
+	write_summary_field("avg_response", hds_report.total_response / div,
+			false);
+	write_summary_field("max_response", hds_report.max_response, false);
+	// starvation: how long low priority work waits, and how often aging
+	// had to step in
+	for (i = 0; i < HDS_USER_PRIORITIES; i++) {
+		snprintf(name, sizeof(name), "p99_wait_p%d", i + 1);
+		write_summary_field(name,
+				hds_hist_quantile(&hds_report.wait_by_priority[i], 0.99),
+				false);
+		snprintf(name, sizeof(name), "max_wait_p%d", i + 1);
+		write_summary_field(name, hds_report.wait_by_priority[i].max, false);
+	}
+	write_summary_field("promotions", hds_policy_promotions(), false);
+	write_summary_field("steals", hds_core_steals(), false);
+	if (hds_config.engine == HDS_ENGINE_EVENT) {
+		write_summary_field("events", hds_sim_stats.events, false);
+	}
+	if (hds_config.engine == HDS_ENGINE_EVENT
+			&& hds_core_waits_for_resources()) {
+		write_summary_field("resource_waits", hds_sim_stats.resource_waits,
+				false);
+	}
+	if (hds_config.deadlock_avoidance == HDS_AVOID_BANKER) {
+		write_banker_fields();
+	}
+	if (hds_config.engine == HDS_ENGINE_REALTIME) {
+		write_rt_fields();
+		// processes a cpu had to fork itself, the worker pool was empty
+		write_summary_field("worker_pool_misses", hds_workers_misses(),
+				false);
+		hds_exec_children(&reaped, &bad_exits);
+		write_summary_field("children_reaped", reaped, false);
+		write_summary_field("children_bad_exits", bad_exits, false);
+	}
+	write_summary_field("wall_time_ms", wall_time_ns / 1000000.0, true);
+
+	if (hds_report.format == HDS_REPORT_JSON) {
+		fprintf(hds_report.out, "}}\n");
+	}
+	if (hds_report.out != stdout) {
+		fclose(hds_report.out);
+	} else {
+		fflush(hds_report.out);
+	}
+	hds_report.enabled = false;
+	pthread_mutex_destroy(&hds_report.lock);
+}
+/**
+ * @brief Write what the safety checks of deadlock avoidance cost, the time
+ * 		is the latency they added to admissions.
+ */
+static void write_banker_fields() {
+	struct hds_banker_t *b = &max_available_resource.banker;
+	pthread_mutex_lock(&max_available_resource.avail_resource_mutex);
+	write_summary_field("safety_checks", b->checks, false);
+	write_summary_field("safety_holders_checked", b->holders_checked, false);
+	write_summary_field("safety_full_checks", b->full_checks, false);
+	write_summary_field("safety_refusals", b->refusals, false);
+	write_summary_field("safety_wall_ns", b->check_ns, false);
+	write_summary_field("safety_wall_ns_avg",
+			b->checks ? (double) b->check_ns / b->checks : 0, false);
+	write_summary_field("safety_wall_ns_max", b->check_ns_max, false);
+	pthread_mutex_unlock(&max_available_resource.avail_resource_mutex);
+}
+/**
+ * @brief Write how long realtime processes waited for a cpu: percentiles and
+ * 		a count for every power of two range of microseconds which has any,
+ * 		e.g. rt_latency_us_lt_1024 for those from 512 to 1023 us.
+ */
+static void write_rt_fields() {
+	struct hds_hist_t *h = &hds_report.rt_latency;
+	unsigned long int count;
+	char name[40];
+	int i, j, e;
+	pthread_mutex_lock(&hds_report.lock);
+	write_summary_field("rt_preemptions", hds_core_rt_preemptions(), false);
+	write_summary_field("rt_jobs", h->count, false);
+	write_summary_field("p50_rt_latency_us", hds_hist_quantile(h, 0.5), false);
+	write_summary_field("p99_rt_latency_us", hds_hist_quantile(h, 0.99),
+			false);
+	write_summary_field("max_rt_latency_us", h->max, false);
+	// what completed jobs consumed against what they were charged, in quanta
+	write_summary_field("cpu_consumed",
+			(double) hds_report.cpu_ns / HDS_QUANTUM_NS, false);
+	write_summary_field("cpu_wall", (double) hds_report.wall_ns / HDS_QUANTUM_NS,
+			false);
+	// every HDS_HIST_SUB buckets are one range, values below HDS_HIST_SUB
+	// are the first
+	for (i = 0, e = HDS_HIST_SUB_BITS; e < 64; i += HDS_HIST_SUB, e++) {
+		count = 0;
+		for (j = i; j < i + HDS_HIST_SUB; j++) {
+			count += h->bucket[j];
+		}
+		if (count == 0) {
+			continue;
+		}
+		snprintf(name, sizeof(name), "rt_latency_us_lt_%lu", 1UL << e);
+		write_summary_field(name, count, false);
+	}
+	pthread_mutex_unlock(&hds_report.lock);
+}
+static void write_summary_field(const char *name, double value, bool last) {
+	switch (hds_report.format) {
+	case HDS_REPORT_JSON:
+		fprintf(hds_report.out, "\"%s\":%.15g%s", name, value, last ? "" : ",");
+		break;
+	default:
+		fprintf(hds_report.out, "# %s,%.15g\n", name, value);
+		break;
+	}
+}
+/**
+ * @brief Count a value in a histogram.
+ */
+void hds_hist_add(struct hds_hist_t *h, unsigned long int value) {
+	int e, i;
+	if (value < HDS_HIST_SUB) {
+		i = value;
+	} else {
+		e = 63 - __builtin_clzl(value);
+		i = HDS_HIST_SUB * (e - HDS_HIST_SUB_BITS + 1)
+				+ ((value >> (e - HDS_HIST_SUB_BITS)) & (HDS_HIST_SUB - 1));
+	}
+	h->bucket[i]++;
+	h->count++;
+	if (value > h->max) {
+		h->max = value;
+	}
+}
+/**
+ * @brief Smallest value such that a share q of the counted values are not
+ * 		above it, rounded up to the end of its bucket but never above the
+ * 		largest value counted.
+ * @param q Between 0 and 1, e.g. 0.99 for the 99th percentile.
+ * @return The value or 0 if nothing was counted.
+ */
+unsigned long int hds_hist_quantile(const struct hds_hist_t *h, double q) {
+	unsigned long int rank, seen = 0, value;
+	int i, e;
+	if (h->count == 0) {
+		return 0;
+	}
+	rank = (unsigned long int) (q * h->count + 0.999999);
+	if (rank < 1) {
+		rank = 1;
+	}
+	for (i = 0; i < HDS_HIST_BUCKETS; i++) {
+		seen += h->bucket[i];
+		if (seen >= rank) {
+			break;
+		}
+	}
+	if (i < HDS_HIST_SUB) {
+		return i;
+	}
+	// last value of the bucket
+	e = i / HDS_HIST_SUB + HDS_HIST_SUB_BITS - 1;
+	value = ((unsigned long int) (HDS_HIST_SUB + i % HDS_HIST_SUB)
+			<< (e - HDS_HIST_SUB_BITS))
+			+ ((1UL << (e - HDS_HIST_SUB_BITS)) - 1);
+	return value < h->max ? value : h->max;
+}
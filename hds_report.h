@@ -0,0 +1,83 @@
+/**
+ * @file hds_report.h
+ * @brief header file for hds_report.c
+ */
+#ifndef HDS_REPORT_H_
+#define HDS_REPORT_H_
+
+#include "hds_core.h"
+
+/**
+ * @enum hds_report_format_t
+ * @brief Output formats for per-job and aggregate results.
+ */
+typedef enum {
+	HDS_REPORT_CSV, /**< One header line, one line per job, summary as comments */
+	HDS_REPORT_JSON /**< A single object with "jobs" array and "summary" object */
+} hds_report_format_t;
+/**
+ * @enum hds_job_status_t
+ * @brief How a process left the system.
+ */
+typedef enum {
+	HDS_JOB_COMPLETED, /**< Ran until its cpu_req was used up */
+	HDS_JOB_FAILED /**< Could not get its resources and was dropped */
+} hds_job_status_t;
+/**
+ * @def HDS_HIST_SUB_BITS
+ * @brief Every power of two range of a hds_hist_t is split into
+ * 		2^HDS_HIST_SUB_BITS buckets, so a percentile is off by at most 1/16th.
+ */
+#define HDS_HIST_SUB_BITS 4
+#define HDS_HIST_SUB (1 << HDS_HIST_SUB_BITS)
+#define HDS_HIST_BUCKETS (HDS_HIST_SUB * (64 - HDS_HIST_SUB_BITS + 1))
+/**
+ * @struct hds_hist_t
+ * @brief Log-linear histogram of times. Values below HDS_HIST_SUB are kept
+ * 		exactly. Fixed size, so percentiles of any no. of jobs can be given
+ * 		without keeping every value.
+ */
+struct hds_hist_t {
+	unsigned long int bucket[HDS_HIST_BUCKETS];
+	unsigned long int count;
+	unsigned long int max;
+};
+/**
+ * @struct hds_report_t
+ * @brief State of the results writer. Rows are written as jobs leave the
+ * 		system, aggregates are kept as running sums so memory use does not
+ * 		grow with the workload.
+ */
+struct hds_report_t {
+	FILE *out;
+	bool enabled; /**< Only set while a headless run is writing results */
+	hds_report_format_t format;
+	pthread_mutex_t lock; //cpu thread and main thread may both report
+	unsigned long int rows;
+
+	unsigned long int jobs_completed;
+	unsigned long int jobs_failed;
+	unsigned long int preemptions;
+	unsigned long int cpu_time; /**< Sum of cpu_total of completed jobs */
+	/** Realtime engine: CPU time consumed and time run by completed jobs */
+	unsigned long int cpu_ns, wall_ns;
+	unsigned long int first_arrival;
+	unsigned long int last_completion;
+	unsigned long int total_turnaround, max_turnaround;
+	unsigned long int total_wait, max_wait;
+	unsigned long int total_response, max_response;
+	struct hds_hist_t turnaround, wait; /**< For tail percentiles */
+	/** Wait of completed jobs by the priority they arrived with, p1 to p3 */
+	struct hds_hist_t wait_by_priority[HDS_USER_PRIORITIES];
+	/** Realtime engine: from a realtime process being queued until it runs, us */
+	struct hds_hist_t rt_latency;
+} hds_report;
+
+// --------routines-----------
+int hds_report_open(const char *filename, hds_report_format_t format);
+void hds_report_job(struct process_queue_t *process, hds_job_status_t status);
+void hds_report_close(long int wall_time_ns);
+void hds_report_rt_latency(unsigned long int latency_ns);
+void hds_hist_add(struct hds_hist_t *h, unsigned long int value);
+unsigned long int hds_hist_quantile(const struct hds_hist_t *h, double q);
+#endif /* HDS_REPORT_H_ */
@@ -0,0 +1,81 @@
+/**
+ * @file hds_resource.h
+ * @brief Resource vectors. Every kind of resource (memory, printer, scanner
+ * 		  and any kind added in hds.conf) is one lane of a hds_resvec_t, so
+ * 		  what a process needs is checked against what is available with one
+ * 		  vector compare, and handed out or given back with one vector
+ * 		  subtract or add.
+ */
+#ifndef HDS_RESOURCE_H_
+#define HDS_RESOURCE_H_
+
+#include <stdbool.h>
+
+/**
+ * @def HDS_MAX_RESOURCES
+ * @brief Most kinds of resources, i.e. lanes of a hds_resvec_t. hds.conf
+ * 		decides how many of them are used; unused lanes stay 0.
+ */
+#define HDS_MAX_RESOURCES 8
+/**
+ * @def HDS_RES_MEMORY
+ * @brief Lanes of the kinds every job carries. Kinds added in hds.conf
+ * 		follow from HDS_RES_BUILTIN on.
+ */
+#define HDS_RES_MEMORY 0
+#define HDS_RES_PRINTER 1
+#define HDS_RES_SCANNER 2
+#define HDS_RES_BUILTIN 3
+/**
+ * @def HDS_RES_NAME_LEN
+ * @brief Longest name of a resource kind, including the terminating null.
+ */
+#define HDS_RES_NAME_LEN 32
+
+/**
+ * @typedef hds_resvec_t
+ * @brief Units of every kind of resource, memory in MB. Only aligned like an
+ * 		int, so it can sit in any struct, malloc()ed or packed.
+ */
+typedef int hds_resvec_t __attribute__((vector_size(HDS_MAX_RESOURCES
+		* sizeof(int)), aligned(sizeof(int))));
+
+/*
+ * Vectors are passed by pointer: a hds_resvec_t is wider than the vector
+ * registers the default target may pass arguments in.
+ */
+/**
+ * @brief Set every lane of v to units.
+ */
+static inline void hds_resvec_fill(hds_resvec_t *v, int units) {
+	hds_resvec_t zero = { 0 };
+	*v = zero + units;
+}
+/**
+ * @brief Tells if need fits in avail in every lane.
+ */
+static inline bool hds_resvec_fits(const hds_resvec_t *need,
+		const hds_resvec_t *avail) {
+	hds_resvec_t over = *need > *avail;
+	int i, any = 0;
+	for (i = 0; i < HDS_MAX_RESOURCES; i++) {
+		any |= over[i];
+	}
+	return any == 0;
+}
+/**
+ * @brief Tells if v has no units of any kind.
+ */
+static inline bool hds_resvec_empty(const hds_resvec_t *v) {
+	hds_resvec_t zero = { 0 };
+	return hds_resvec_fits(v, &zero);
+}
+/**
+ * @brief Set dst to the smaller of a and b in every lane. dst may be a or b.
+ */
+static inline void hds_resvec_min(hds_resvec_t *dst, const hds_resvec_t *a,
+		const hds_resvec_t *b) {
+	hds_resvec_t less = *a < *b;
+	*dst = (*a & less) | (*b & ~less);
+}
+#endif /* HDS_RESOURCE_H_ */
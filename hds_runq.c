@@ -0,0 +1,267 @@
+/**
+ * @file hds_runq.c
+ * @brief Run queue used by the scheduler and the event engine. Levels
+ * 		  without work are skipped through the nonempty bitmap, and within a
+ * 		  level the earliest process which passes the admission test is
+ * 		  found through its resource index, usually in O(log n), instead of
+ * 		  testing every node. A level is kept in arrays, the handles of its
+ * 		  nodes in FCFS order and the index over their needs, so neither
+ * 		  the search nor squeezing out empty slots follows links between
+ * 		  nodes.
+ */
+#include "hds_core.h"
+//=========== routines declaration============
+static void set_slot(struct hds_runq_level_t *l, unsigned int slot,
+		const hds_resvec_t *need);
+static struct process_queue_t *first_fit(struct hds_runq_level_t *l,
+		const hds_resvec_t *avail);
+static int make_room(struct hds_runq_level_t *l);
+//===========================================
+static hds_resvec_t empty_slot; /**< INT_MAX in every lane, fits nothing */
+/**
+ * @brief Initialise an empty run queue.
+ * @return HDS_OK on success else an error code.
+ */
+int hds_runq_init(struct hds_runq_t *rq) {
+	struct hds_runq_level_t *l = NULL;
+	unsigned int s;
+	int i;
+
+	memset(rq, 0, sizeof(struct hds_runq_t));
+	hds_resvec_fill(&empty_slot, INT_MAX);
+	for (i = 0; i < HDS_RUNQ_LEVELS; i++) {
+		l = &rq->level[i];
+		l->capacity = HDS_RUNQ_INITIAL_SLOTS;
+		l->min_need = (hds_resvec_t *) malloc(
+				2 * l->capacity * sizeof(hds_resvec_t));
+		l->slots = (unsigned int *) calloc(l->capacity, sizeof(unsigned int));
+		if (!l->min_need || !l->slots) {
+			serror("Failed to allocate run queue index");
+			return HDS_ERR_NO_MEM;
+		}
+		for (s = 0; s < 2 * l->capacity; s++) {
+			l->min_need[s] = empty_slot;
+		}
+	}
+	return HDS_OK;
+}
+/**
+ * @brief Attach a node at the end of the level given by its priority.
+ * @return HDS_OK, HDS_ERR_INVALID_PROCESS if priority is out of range or
+ * 		HDS_ERR_NO_MEM if the index could not grow. On error node is left to
+ * 		the caller.
+ */
+int hds_runq_append(struct hds_runq_t *rq, struct process_queue_t *node) {
+	struct hds_runq_level_t *l = NULL;
+	if (node->priority < 0 || node->priority >= HDS_RUNQ_LEVELS) {
+		return HDS_ERR_INVALID_PROCESS;
+	}
+	l = &rq->level[node->priority];
+	node->next = NULL;
+
+	if (l->next_slot == l->capacity && make_room(l) != HDS_OK) {
+		serror("Failed to grow run queue index");
+		return HDS_ERR_NO_MEM;
+	}
+	l->count++;
+	node->runq_slot = l->next_slot++;
+	l->slots[node->runq_slot] = node->handle;
+	set_slot(l, node->runq_slot, hds_runq_need(node));
+	rq->nonempty |= 1U << node->priority;
+	hds_pcb_track(node, HDS_PCB_RUNQ);
+	return HDS_OK;
+}
+/**
+ * @brief Find the process which should run next: the first one, in FCFS
+ * 		order, of the highest priority level which has an admissible process.
+ * 		On the realtime level only the head is considered. The node remains
+ * 		in its queue.
+ * @param avail Resources available for new processes.
+ * @return The selected process or NULL if none could be admitted.
+ */
+struct process_queue_t *hds_runq_find(struct hds_runq_t *rq,
+		const hds_resvec_t *avail) {
+	struct process_queue_t *node = NULL;
+	struct hds_runq_level_t *l = NULL;
+	unsigned int levels;
+	int i;
+
+	for (levels = rq->nonempty; levels != 0 && !node; levels &= levels - 1) {
+		i = __builtin_ctz(levels);
+		l = &rq->level[i];
+		if (i == HDS_RUNQ_RT_LEVEL) {
+			// if realtime head can't get its resources yet, user processes
+			// are looked at so that the ones holding them can finish
+			node = hds_runq_head(rq, i);
+			if (!hds_resvec_fits(hds_runq_need(node), avail)) {
+				node = NULL;
+			}
+			continue;
+		}
+		node = first_fit(l, avail);
+	}
+	return node;
+}
+/**
+ * @brief Unlink a node from its level. The node is left to the caller.
+ * @param node A node which was returned by hds_runq_find().
+ */
+void hds_runq_unlink(struct hds_runq_t *rq, struct process_queue_t *node) {
+	struct hds_runq_level_t *l = &rq->level[node->priority];
+	l->count--;
+	l->slots[node->runq_slot] = HDS_PCB_NONE;
+	set_slot(l, node->runq_slot, &empty_slot);
+	if (l->count == 0) {
+		// every slot is empty, start again from the first
+		rq->nonempty &= ~(1U << node->priority);
+		l->first = l->next_slot = 0;
+	}
+	hds_pcb_track(node, HDS_PCB_HELD);
+}
+/**
+ * @brief First node, in FCFS order, of a level. The node remains in its
+ * 		queue.
+ * @return The node or NULL if the level is empty.
+ */
+struct process_queue_t *hds_runq_head(struct hds_runq_t *rq, int level) {
+	struct hds_runq_level_t *l = &rq->level[level];
+	if (l->count == 0) {
+		return NULL;
+	}
+	// slots before first stay empty, so each is skipped once
+	while (l->slots[l->first] == HDS_PCB_NONE) {
+		l->first++;
+	}
+	return hds_pcb_get(l->slots[l->first]);
+}
+/**
+ * @brief Count processes waiting on every level.
+ */
+unsigned long int hds_runq_count(struct hds_runq_t *rq) {
+	unsigned long int count = 0;
+	int i;
+	for (i = 0; i < HDS_RUNQ_LEVELS; i++) {
+		count += rq->level[i].count;
+	}
+	return count;
+}
+/**
+ * @brief Resources a node still has to be given before it can run. A node
+ * 		passes the admission test when this fits in what is available. A
+ * 		process which has run before still holds what it was given and only
+ * 		needs a request it has not been granted yet.
+ */
+const hds_resvec_t *hds_runq_need(const struct process_queue_t *node) {
+	return &node->allocate_resource.pending;
+}
+static void set_slot(struct hds_runq_level_t *l, unsigned int slot,
+		const hds_resvec_t *need) {
+	unsigned int i = l->capacity + slot;
+	hds_resvec_t *t = l->min_need;
+	t[i] = *need;
+	for (i >>= 1; i >= 1; i >>= 1) {
+		hds_resvec_min(&t[i], &t[2 * i], &t[2 * i + 1]);
+	}
+}
+/**
+ * @brief Earliest node of a level whose need fits in avail, NULL if there
+ * 		is none. Subtrees whose minimum does not fit are never entered; one
+ * 		whose minimum fits may still hold no node that fits, then the walk
+ * 		goes on with the next subtree to the right. A subtree of
+ * 		HDS_RUNQ_SCAN_SLOTS slots is not walked but scanned by the admission
+ * 		kernel, which is where most of the stepping back used to be.
+ */
+static struct process_queue_t *first_fit(struct hds_runq_level_t *l,
+		const hds_resvec_t *avail) {
+	hds_resvec_t *t = l->min_need;
+	unsigned int i = 1, span = l->capacity, from, n, s;
+
+	if (!hds_resvec_fits(&t[1], avail)) {
+		return NULL;
+	}
+	while (1) {
+		if (span <= HDS_RUNQ_SCAN_SLOTS) {
+			// slots below i, only up to the last one handed out
+			from = i * span - l->capacity;
+			n = from + span <= l->next_slot ? span : l->next_slot - from;
+			s = hds_admit_first(&t[l->capacity + from], n, avail);
+			if (s < n) {
+				return hds_pcb_get(l->slots[from + s]);
+			}
+		} else if (hds_resvec_fits(&t[2 * i], avail)) {
+			i = 2 * i;
+			span /= 2;
+			continue;
+		} else if (hds_resvec_fits(&t[2 * i + 1], avail)) {
+			i = 2 * i + 1;
+			span /= 2;
+			continue;
+		}
+		// nothing below i fits: go up to the first right sibling which may
+		while (i > 1 && ((i & 1) || !hds_resvec_fits(&t[i + 1], avail))) {
+			i >>= 1;
+			span *= 2;
+		}
+		if (i == 1) {
+			return NULL;
+		}
+		i++;
+	}
+}
+/**
+ * @brief Last slot has been used: move live nodes to the front, in their
+ * 		order, and double the no. of slots if more than half are live. Their
+ * 		handles and needs are moved within the level's arrays, only the
+ * 		slot each node keeps is written to the node.
+ */
+static int make_room(struct hds_runq_level_t *l) {
+	unsigned int capacity = l->capacity, old = l->capacity, *slots = NULL;
+	unsigned int s, from;
+	hds_resvec_t *min_need = NULL;
+
+	while (l->count * 2 > capacity) {
+		capacity *= 2;
+	}
+	if (capacity != l->capacity) {
+		min_need = (hds_resvec_t *) realloc(l->min_need,
+				2 * capacity * sizeof(hds_resvec_t));
+		if (!min_need) {
+			return HDS_ERR_NO_MEM;
+		}
+		l->min_need = min_need;
+		slots = (unsigned int *) realloc(l->slots,
+				capacity * sizeof(unsigned int));
+		if (!slots) {
+			return HDS_ERR_NO_MEM;
+		}
+		l->slots = slots;
+		l->capacity = capacity;
+	}
+	/*
+	 * Leaves move to the front of the new leaf range: which starts past the
+	 * old leaves when the level grew, or at them when it did not, where a
+	 * leaf only moves down. Either way one forward pass reads every old
+	 * leaf before it is overwritten.
+	 */
+	s = 0;
+	for (from = l->first; from < l->next_slot; from++) {
+		if (l->slots[from] == HDS_PCB_NONE) {
+			continue;
+		}
+		l->slots[s] = l->slots[from];
+		l->min_need[capacity + s] = l->min_need[old + from];
+		hds_pcb_get(l->slots[s])->runq_slot = s;
+		s++;
+	}
+	l->first = 0;
+	l->next_slot = s;
+	for (; s < capacity; s++) {
+		l->slots[s] = HDS_PCB_NONE;
+		l->min_need[capacity + s] = empty_slot;
+	}
+	for (s = capacity - 1; s >= 1; s--) {
+		hds_resvec_min(&l->min_need[s], &l->min_need[2 * s],
+				&l->min_need[2 * s + 1]);
+	}
+	return HDS_OK;
+}
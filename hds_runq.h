@@ -0,0 +1,86 @@
+/**
+ * @file hds_runq.h
+ * @brief header file for hds_runq.c
+ */
+#ifndef HDS_RUNQ_H_
+#define HDS_RUNQ_H_
+
+#include "hds_common.h"
+#include "hds_resource.h"
+#include <limits.h>
+#include <stdint.h>
+
+/**
+ * @def HDS_RUNQ_LEVELS
+ * @brief No. of priority levels: realtime (0) and user priorities 1 to 3.
+ * 		A process is queued on the level equal to its priority.
+ */
+#define HDS_RUNQ_LEVELS 4
+/**
+ * @def HDS_RUNQ_RT_LEVEL
+ * @brief Realtime level, served strictly FCFS: only its head is considered.
+ */
+#define HDS_RUNQ_RT_LEVEL 0
+/**
+ * @def HDS_RUNQ_INITIAL_SLOTS
+ * @brief Slots of a level's resource index before it has to grow. Always a
+ * 		power of two.
+ */
+#define HDS_RUNQ_INITIAL_SLOTS 64
+/**
+ * @def HDS_RUNQ_SCAN_SLOTS
+ * @brief Slots below which the search stops walking the index and hands the
+ * 		needs of the subtree to the admission kernel (hds_admit.c). A power
+ * 		of two, at most HDS_RUNQ_INITIAL_SLOTS.
+ */
+#define HDS_RUNQ_SCAN_SLOTS 64
+
+struct process_queue_t;
+/**
+ * @struct hds_runq_level_t
+ * @brief One FCFS queue of the run queue, indexed on what its processes need.
+ *
+ * Nodes take slots in the order they are appended, so slot order is FCFS
+ * order and the level is just the array of their handles; a node which is
+ * unlinked leaves its slot empty, and empty slots are squeezed out when the
+ * last slot has been used. min_need is a segment tree over the slots: leaf capacity + s holds
+ * hds_runq_need() of the node in slot s (INT_MAX in every lane for an empty
+ * slot) and every other entry the lane wise minimum of its two children. A
+ * subtree whose minimum does not fit holds no node that fits, so the
+ * earliest node that fits is found by walking down from the root and only
+ * stepping back where the lanes of a minimum came from different nodes.
+ * The walk stops at subtrees of HDS_RUNQ_SCAN_SLOTS slots, whose leaves are
+ * scanned in one go by the admission kernel.
+ */
+struct hds_runq_level_t {
+	unsigned long int count;
+
+	hds_resvec_t *min_need; /**< 2 * capacity entries, entry 0 unused */
+	unsigned int *slots; /**< Handle of the node in each slot, HDS_PCB_NONE
+	 	 	 	 	 	  if empty */
+	unsigned int capacity; /**< No. of slots, a power of two */
+	unsigned int first; /**< Every slot before it is empty */
+	unsigned int next_slot; /**< Slot for the next appended node */
+};
+/**
+ * @struct hds_runq_t
+ * @brief Process queues of every priority level. Bit i of nonempty is set
+ * 		while level i holds a node, so the highest priority level with work
+ * 		is found with one bit scan. Not locked here: callers hold the lock
+ * 		of the cpu owning the run queue.
+ */
+struct hds_runq_t {
+	unsigned int nonempty;
+	struct hds_runq_level_t level[HDS_RUNQ_LEVELS];
+};
+
+// --------routines-----------
+int hds_runq_init(struct hds_runq_t *rq);
+int hds_runq_append(struct hds_runq_t *rq, struct process_queue_t *node);
+struct process_queue_t *hds_runq_find(struct hds_runq_t *rq,
+		const hds_resvec_t *avail);
+void hds_runq_unlink(struct hds_runq_t *rq, struct process_queue_t *node);
+struct process_queue_t *hds_runq_head(struct hds_runq_t *rq, int level);
+unsigned long int hds_runq_count(struct hds_runq_t *rq);
+const hds_resvec_t *hds_runq_need(const struct process_queue_t *node);
+#endif /* HDS_RUNQ_H_ */
@@ -0,0 +1,341 @@
+/**
+ * @file hds_sim.c
+ * @brief Discrete event engine. Drives the same process queues, admission
+ * 		  test and memory management as the dispatcher, scheduler and cpu
+ * 		  threads, but on a virtual clock so that a workload runs at full
+ * 		  speed instead of one second per quantum.
+ */
+#include "hds_sim.h"
+#include "hds_report.h"
+//=========== routines declaration============
+static int push_event(unsigned long int t, sim_event_type_t type, void *data);
+static void schedule_arrival_event(unsigned long int not_before);
+static void handle_arrival();
+static void handle_quantum_expiry(struct hds_cpu_t *cpu);
+static void handle_completion(struct hds_cpu_t *cpu);
+static void handle_preemption(struct hds_cpu_t *cpu);
+static void schedule_idle_cpus();
+static void schedule_next_process(struct hds_cpu_t *cpu);
+static int start_active_process(struct hds_cpu_t *cpu);
+static void print_sim_stats();
+//===========================================
+static struct hds_heap_t event_q;
+static int next_sim_pid;
+static bool arrival_pending; // an arrival event is queued for arrival_at
+static unsigned long int arrival_at;
+/**
+ * @brief Main routine of the event engine.
+ *
+ * Processes in the job dispatch list are moved to the arrival queue, and an
+ * arrival event is kept pending for the earliest arrival offset. Events are
+ * then handled in order of virtual time until none are left.
+ * @return HDS_OK when the workload has run to completion else an error code.
+ */
+int hds_sim_run() {
+	/*
+	 * Working of event engine:
+	 * ------------------------
+	 * 1. arrival: every process whose arrival offset has come is placed
+	 * 		into rtq/user job queue of the least loaded cpu. Every idle cpu
+	 * 		selects a new process right away. Arrival event for next offset is
+	 * 		queued. Processes submitted through the submission ring are picked
+	 * 		up before every event.
+	 * 2. quantum expiry: active process is charged one quantum. If it has no
+	 * 		cpu time left, it completes. If the policy says a waiting process
+	 * 		should take over, active process is preempted, else it runs for
+	 * 		another quantum.
+	 * 3. preemption: active process is saved back to the queues holding its
+	 * 		resources, the waiting process takes the cpu.
+	 * 4. completion: resources are freed and next process is selected, first
+	 * 		on the cpu which became idle, then on any other idle cpu as the
+	 * 		freed memory may admit a process there.
+	 * Quantum expiry, completion and preemption events carry the cpu they
+	 * happen on. An idle cpu with nothing admissible in its own queues steals
+	 * from the busiest other cpu. Events are handled one at a time, so a run
+	 * is as repeatable with many cpus as with one.
+	 */
+	unsigned long int key;
+	void *data = NULL;
+	struct timespec start, end;
+
+	memset(&hds_sim_stats, 0, sizeof(hds_sim_stats));
+	if (hds_heap_init(&event_q, 0) != HDS_OK) {
+		serror("event engine: Failed to allocate event queue");
+		return HDS_ERR_NO_MEM;
+	}
+	next_sim_pid = SIM_FIRST_PID;
+	arrival_pending = false;
+	hds_core_state.virtual_time = 0;
+	hds_core_state.virtual_clock = true;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	if (load_arrival_queue() != HDS_OK) {
+		serror("event engine: Failed to load arrival queue");
+		cleanup_arrival_queue();
+		hds_heap_destroy(&event_q);
+		return HDS_ERR_NO_MEM;
+	}
+	schedule_arrival_event(0);
+
+	while (hds_heap_pop(&event_q, &key, &data) == HDS_OK) {
+		if (hds_state.shutdown_in_progress == true) {
+			break;
+		}
+		if (hds_submit_pending() > 0
+				&& drain_submitted_jobs(key / SIM_EV_TYPES) > 0) {
+			schedule_arrival_event(key / SIM_EV_TYPES);
+		}
+		hds_core_state.virtual_time = key / SIM_EV_TYPES;
+		hds_sim_stats.events++;
+		switch (key % SIM_EV_TYPES) {
+		case SIM_EV_ARRIVAL:
+			handle_arrival();
+			break;
+		case SIM_EV_QUANTUM_EXPIRY:
+			handle_quantum_expiry((struct hds_cpu_t *) data);
+			break;
+		case SIM_EV_COMPLETION:
+			handle_completion((struct hds_cpu_t *) data);
+			break;
+		case SIM_EV_PREEMPTION:
+			handle_preemption((struct hds_cpu_t *) data);
+			break;
+		default:
+			serror("event engine: Found an event of unknown type");
+			break;
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	hds_sim_stats.virtual_time = hds_core_state.virtual_time;
+	hds_sim_stats.wall_time_ns = (end.tv_sec - start.tv_sec) * 1000000000L
+			+ (end.tv_nsec - start.tv_nsec);
+	hds_sim_stats.jobs_stranded = count_queued_processes();
+	hds_heap_destroy(&event_q);
+
+	//only left over if run was cut short
+	cleanup_arrival_queue();
+
+	print_sim_stats();
+	return HDS_OK;
+}
+/**
+ * @brief Main routine for event engine thread.
+ * @param args
+ */
+void *hds_sim_engine(void *args) {
+	if (hds_sim_run() != HDS_OK) {
+		serror("event engine: Simulation aborted");
+	}
+	sdebug("event engine: Shutting down..");
+	pthread_exit(NULL );
+}
+static int push_event(unsigned long int t, sim_event_type_t type, void *data) {
+	if (hds_heap_push(&event_q, SIM_EVENT_KEY(t, type), data) != HDS_OK) {
+		serror("event engine: Failed to queue an event");
+		return HDS_ERR_NO_MEM;
+	}
+	return HDS_OK;
+}
+/**
+ * @brief Make sure an arrival event is queued for the next arrival offset.
+ * @param not_before Earliest time the event may be queued for.
+ */
+static void schedule_arrival_event(unsigned long int not_before) {
+	unsigned long int t;
+	if (next_arrival_time(&t) == false) {
+		return;
+	}
+	if (t < not_before) {
+		t = not_before;
+	}
+	if (arrival_pending == true && arrival_at <= t) {
+		return;
+	}
+	if (push_event(t, SIM_EV_ARRIVAL, NULL ) == HDS_OK) {
+		arrival_pending = true;
+		arrival_at = t;
+	}
+}
+static void handle_arrival() {
+	unsigned long int now = hds_core_state.virtual_time;
+	if (arrival_pending == false || arrival_at != now) {
+		// superseded by an earlier arrival event
+		return;
+	}
+	arrival_pending = false;
+	hds_sim_stats.jobs_dispatched += release_due_arrivals(now);
+	// a process which could not be queued is retried a quantum later
+	schedule_arrival_event(now + SMALLEST_TIME_QUANTUM);
+	schedule_idle_cpus();
+}
+static void handle_quantum_expiry(struct hds_cpu_t *cpu) {
+	struct process_queue_t *next_process = NULL;
+	unsigned long int now = hds_core_state.virtual_time;
+	int rc;
+
+	pthread_mutex_lock(&cpu->active_process_lock);
+	cpu->active_process->cpu_req =
+			cpu->active_process->cpu_req - 1;
+	cpu->slice_expired = hds_policy_on_tick(cpu, cpu->active_process);
+	pthread_mutex_unlock(&cpu->active_process_lock);
+	hds_sim_stats.busy_time += SMALLEST_TIME_QUANTUM;
+
+	if (cpu->active_process->cpu_req <= 0) {
+		push_event(now, SIM_EV_COMPLETION, cpu);
+		return;
+	}
+	// with staged acquisition it may be time to ask for another device
+	if (hds_core_next_request(cpu->active_process)
+			&& (rc = allocate_resources(cpu->active_process)) != HDS_OK) {
+		var_debug("event engine: pid %d waits for resources (%d)",
+				cpu->active_process->pid, rc);
+		hds_sim_stats.resource_waits++;
+		block_on_resources(cpu->active_process);
+		cpu->active_process = NULL;
+		cpu->active_process_valid = false;
+		schedule_next_process(cpu);
+		return;
+	}
+	// same rule as cpu thread: the policy tells if the active process is
+	// to be interrupted
+	next_process = find_next_process_tobe_executed(cpu);
+	if (next_process
+			&& hds_policy_should_switch(next_process, cpu->active_process,
+					cpu->slice_expired)) {
+		push_event(now, SIM_EV_PREEMPTION, cpu);
+		return;
+	}
+	push_event(now + SMALLEST_TIME_QUANTUM, SIM_EV_QUANTUM_EXPIRY, cpu);
+}
+static void handle_completion(struct hds_cpu_t *cpu) {
+	unsigned long int now = hds_core_state.virtual_time;
+	if (cpu->active_process->pid > 1) {
+		free_resources(cpu->active_process);
+	}
+	hds_policy_on_complete(cpu, cpu->active_process);
+	hds_sim_stats.total_turnaround += now
+			- cpu->active_process->arrival_time;
+	hds_sim_stats.jobs_completed++;
+	hds_report_job(cpu->active_process, HDS_JOB_COMPLETED);
+	hds_core_retire(cpu);
+	schedule_next_process(cpu);
+	// freed memory may admit a process on another idle cpu
+	schedule_idle_cpus();
+}
+static void handle_preemption(struct hds_cpu_t *cpu) {
+	struct process_queue_t *next_process = NULL;
+	next_process = find_next_process_tobe_executed(cpu);
+	if (!next_process
+			|| !hds_policy_should_switch(next_process,
+					cpu->active_process, cpu->slice_expired)) {
+		// the situation has changed in the meantime, keep running
+		push_event(hds_core_state.virtual_time + SMALLEST_TIME_QUANTUM,
+				SIM_EV_QUANTUM_EXPIRY, cpu);
+		return;
+	}
+	// active process keeps its pid and resources while it waits
+	degrade_priority_and_save_to_q(cpu, cpu->active_process);
+	hds_sim_stats.preemptions++;
+
+	set_active_process(cpu, next_process);
+	remove_process_from_queue(cpu, next_process);
+	if (start_active_process(cpu) != HDS_OK) {
+		schedule_next_process(cpu);
+	}
+}
+/**
+ * @brief Select a new process on every cpu which is idle, lowest id first.
+ */
+static void schedule_idle_cpus() {
+	int i;
+	for (i = 0; i < hds_core_state.ncpus; i++) {
+		if (hds_core_state.cpu[i].active_process_valid == false) {
+			schedule_next_process(&hds_core_state.cpu[i]);
+		}
+	}
+}
+/**
+ * @brief cpu is idle, pick the next process which passes the admission test.
+ * 		If none is queued on it, one is stolen from another cpu.
+ */
+static void schedule_next_process(struct hds_cpu_t *cpu) {
+	struct process_queue_t *next_process = NULL;
+	while (cpu->active_process_valid == false) {
+		next_process = find_next_process_tobe_executed(cpu);
+		if (!next_process) {
+			next_process = steal_process(cpu);
+		}
+		if (!next_process) {
+			// cpu stays idle until next arrival
+			return;
+		}
+		set_active_process(cpu, next_process);
+		remove_process_from_queue(cpu, next_process);
+		start_active_process(cpu);
+	}
+}
+/**
+ * @brief Give the cpu to the active process for one quantum. On its first run
+ * 		a process gets a pid and its resources, a process which waited for
+ * 		resources gets what it asked for.
+ * @return HDS_OK if process is running else an error code, in which case
+ * 		active process has been dropped or waits for resources.
+ */
+static int start_active_process(struct hds_cpu_t *cpu) {
+	unsigned long int now = hds_core_state.virtual_time;
+	bool first = cpu->active_process->pid == 0;
+	int rc;
+	if (first) {
+		cpu->active_process->pid = next_sim_pid++;
+		cpu->active_process->start_time = now;
+	}
+	if (first
+			|| !hds_resvec_empty(
+					&cpu->active_process->allocate_resource.pending)) {
+		rc = allocate_resources(cpu->active_process);
+		if (rc != HDS_OK && hds_core_waits_for_resources()) {
+			var_debug("event engine: pid %d waits for resources (%d)",
+					cpu->active_process->pid, rc);
+			if (cpu->active_process->allocate_resource.stage == 0) {
+				// holds nothing, it starts afresh
+				cpu->active_process->pid = 0;
+				cpu->active_process->start_time = 0;
+			}
+			hds_sim_stats.resource_waits++;
+			block_on_resources(cpu->active_process);
+			cpu->active_process = NULL;
+			cpu->active_process_valid = false;
+			return rc;
+		}
+		if (rc != HDS_OK) {
+			var_error("event engine: Resource allocation failed for pid: %d",
+					cpu->active_process->pid);
+			hds_sim_stats.jobs_failed++;
+			hds_report_job(cpu->active_process, HDS_JOB_FAILED);
+			hds_core_retire(cpu);
+			return HDS_ERR_NO_RESOURCE;
+		}
+	}
+	if (cpu->active_process->cpu_req <= 0) {
+		// nothing to run, it completes right away
+		return push_event(now, SIM_EV_COMPLETION, cpu);
+	}
+	return push_event(now + SMALLEST_TIME_QUANTUM, SIM_EV_QUANTUM_EXPIRY, cpu);
+}
+static void print_sim_stats() {
+	var_debug(
+			"event engine: %lu events, virtual time %lu quanta, wall time %ld us",
+			hds_sim_stats.events, hds_sim_stats.virtual_time,
+			hds_sim_stats.wall_time_ns / 1000);
+	var_debug(
+			"event engine: dispatched %lu completed %lu failed %lu stranded %lu preemptions %lu",
+			hds_sim_stats.jobs_dispatched, hds_sim_stats.jobs_completed,
+			hds_sim_stats.jobs_failed, hds_sim_stats.jobs_stranded,
+			hds_sim_stats.preemptions);
+	if (hds_sim_stats.jobs_completed > 0) {
+		var_debug("event engine: avg turnaround %.2f quanta, cpu busy %lu quanta",
+				(double) hds_sim_stats.total_turnaround
+						/ hds_sim_stats.jobs_completed, hds_sim_stats.busy_time);
+	}
+}
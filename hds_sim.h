@@ -0,0 +1,56 @@
+/**
+ * @file hds_sim.h
+ * @brief header file for hds_sim.c
+ */
+#ifndef HDS_SIM_H_
+#define HDS_SIM_H_
+
+#include "hds_core.h"
+#include "hds_heap.h"
+
+/**
+ * @enum sim_event_type_t
+ * @brief Kinds of events handled by the event engine. When two events fall on
+ * 		the same virtual time, they are handled in the order listed here.
+ */
+typedef enum {
+	SIM_EV_ARRIVAL, /**< A process leaves the job dispatch list */
+	SIM_EV_QUANTUM_EXPIRY, /**< Active process has used up one time quantum */
+	SIM_EV_COMPLETION, /**< Active process has no cpu time left */
+	SIM_EV_PREEMPTION, /**< A higher priority process takes over the cpu */
+	SIM_EV_TYPES /**< No. of event types. Must be last. */
+} sim_event_type_t;
+/**
+ * @def SIM_EVENT_KEY(t, type)
+ * @brief Packs virtual time and event type into a single heap key.
+ */
+#define SIM_EVENT_KEY(t, type) (((unsigned long int) (t)) * SIM_EV_TYPES + (type))
+/**
+ * @def SIM_FIRST_PID
+ * @brief Processes run by the event engine are not forked. They are given
+ * 		pids starting from this value so that memory blocks can still be
+ * 		tracked per process.
+ */
+#define SIM_FIRST_PID 2
+/**
+ * @struct hds_sim_stats_t
+ * @brief Counters collected while the event engine runs.
+ */
+struct hds_sim_stats_t {
+	unsigned long int events; /**< Events handled */
+	unsigned long int jobs_dispatched;
+	unsigned long int jobs_completed;
+	unsigned long int jobs_failed; /**< Resource allocation failed, job dropped */
+	unsigned long int jobs_stranded; /**< Left in queues, never admitted */
+	unsigned long int preemptions;
+	unsigned long int resource_waits; /**< Requests which were not granted */
+	unsigned long int busy_time; /**< Quanta run by a process, summed over cpus */
+	unsigned long int total_turnaround; /**< Sum of (completion - arrival) */
+	unsigned long int virtual_time; /**< Virtual time when engine stopped */
+	long int wall_time_ns; /**< Wall clock time taken by the run */
+} hds_sim_stats;
+
+// --------routines-----------
+int hds_sim_run();
+void *hds_sim_engine(void *args);
+#endif /* HDS_SIM_H_ */
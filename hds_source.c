@@ -0,0 +1,579 @@
+/**
+ * @file hds_source.c
+ * @brief Streaming job sources. Lets hds replay workloads which are too large
+ * 		  to be listed in hds.conf: jobs are read just ahead of the current
+ * 		  time instead of being loaded before the run. A trace file is either
+ * 		  CSV text or a binary job file, told apart by the magic at its start.
+ * 		  Without a trace file, jobs may come from the workload generator.
+ */
+#include "hds_source.h"
+#include "hds_kernel.h"
+//=========== routines declaration============
+static int trace_open(const char *filename);
+static int trace_read_job(struct hds_process_t *job);
+static int trace_fill_buffer();
+static int trace_parse_line(char *line, struct hds_process_t *job);
+static int trace_parse_kernel(char **p, hds_kernel_t *kernel);
+static void fetch_next_job();
+static bool is_job_file(const char *filename);
+static int binary_open(const char *filename);
+static int binary_read_job(struct hds_process_t *job);
+static int write_jobs(FILE *out,
+		int (*write_job)(FILE *out, const struct hds_process_t *job),
+		unsigned long int *count);
+static int write_job_record(FILE *out, const struct hds_process_t *job);
+static int write_job_line(FILE *out, const struct hds_process_t *job);
+//===========================================
+/**
+ * @brief Open the job source selected in hds.conf, if any.
+ * @return HDS_OK on success else an error code.
+ */
+int hds_source_open() {
+	memset(&hds_source, 0, sizeof(hds_source));
+	hds_source.fd = -1;
+	hds_source.exhausted = true;
+
+	if (hds_config.trace_file[0] == '\0') {
+		if (hds_config.generator.enabled == false) {
+			hds_source.type = HDS_SOURCE_NONE;
+			return HDS_OK;
+		}
+		hds_source.type = HDS_SOURCE_GENERATOR;
+		hds_gen_init();
+	} else if (is_job_file(hds_config.trace_file) == true) {
+		hds_source.type = HDS_SOURCE_BINARY;
+		if (binary_open(hds_config.trace_file) != HDS_OK) {
+			return HDS_ERR_FILE_IO;
+		}
+	} else {
+		hds_source.type = HDS_SOURCE_TRACE;
+		if (trace_open(hds_config.trace_file) != HDS_OK) {
+			return HDS_ERR_FILE_IO;
+		}
+	}
+	hds_source.exhausted = false;
+	fetch_next_job();
+	return HDS_OK;
+}
+/**
+ * @brief Look at the arrival of the next job without taking it.
+ * @param arrival Set to the arrival offset of the next job.
+ * @return false if the source has no more jobs.
+ */
+bool hds_source_peek(unsigned long int *arrival) {
+	if (hds_source.has_next == false) {
+		return false;
+	}
+	*arrival = hds_source.next.arrival;
+	return true;
+}
+/**
+ * @brief Take the next job from the source.
+ * @param job Filled with the job, which is given the next job_id.
+ * @return HDS_OK on success or HDS_ERR_NO_SUCH_ELEMENT if there are no more
+ * 		jobs.
+ */
+int hds_source_next(struct hds_process_t *job) {
+	if (hds_source.has_next == false) {
+		return HDS_ERR_NO_SUCH_ELEMENT;
+	}
+	*job = hds_source.next;
+	// ids stored in a job file are not trusted, they may clash with those of
+	// process_list
+	job->job_id = ++hds_config.job_id_counter;
+	hds_source.jobs_read++;
+	fetch_next_job();
+	return HDS_OK;
+}
+/**
+ * @brief Tells if every job of the source has been taken. A source which has
+ * 		not been opened yet is not done.
+ */
+bool hds_source_done() {
+	return hds_source.exhausted == true && hds_source.has_next == false;
+}
+/**
+ * @brief Close the source and release its buffers.
+ */
+void hds_source_close() {
+	if (hds_source.type == HDS_SOURCE_TRACE) {
+		var_debug("source: %lu jobs read from %s, %lu lines skipped",
+				hds_source.jobs_read, hds_config.trace_file,
+				hds_source.lines_skipped);
+	} else if (hds_source.type == HDS_SOURCE_BINARY) {
+		var_debug("source: %lu of %lu jobs read from %s, %lu skipped",
+				hds_source.jobs_read,
+				(unsigned long int) hds_source.record_count,
+				hds_config.trace_file, hds_source.records_skipped);
+	} else if (hds_source.type == HDS_SOURCE_GENERATOR) {
+		var_debug("source: %lu of %lu jobs generated with seed %lu",
+				hds_source.jobs_read, hds_config.generator.jobs,
+				hds_config.generator.seed);
+	}
+	if (hds_source.fd >= 0) {
+		close(hds_source.fd);
+	}
+	if (hds_source.map) {
+		munmap(hds_source.map, hds_source.map_len);
+		hds_source.map = NULL;
+		hds_source.records = NULL;
+	}
+	free(hds_source.buf);
+	hds_source.buf = NULL;
+	hds_source.fd = -1;
+	hds_source.has_next = false;
+	hds_source.exhausted = true;
+}
+static void fetch_next_job() {
+	hds_source.has_next = false;
+	if (hds_source.exhausted == true) {
+		return;
+	}
+	switch (hds_source.type) {
+	case HDS_SOURCE_TRACE:
+		if (trace_read_job(&hds_source.next) == HDS_OK) {
+			hds_source.has_next = true;
+			return;
+		}
+		break;
+	case HDS_SOURCE_BINARY:
+		if (binary_read_job(&hds_source.next) == HDS_OK) {
+			hds_source.has_next = true;
+			return;
+		}
+		break;
+	case HDS_SOURCE_GENERATOR:
+		if (hds_gen_next(&hds_source.next) == HDS_OK) {
+			hds_source.has_next = true;
+			return;
+		}
+		break;
+	default:
+		break;
+	}
+	hds_source.exhausted = true;
+}
+// //////////// CSV trace reader ////////////////////////
+static int trace_open(const char *filename) {
+	if ((hds_source.fd = open(filename, O_RDONLY)) < 0) {
+		var_error("source: Failed to open trace file: %s", filename);
+		return HDS_ERR_FILE_IO;
+	}
+	// the file is only read front to back
+	posix_fadvise(hds_source.fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+	// one more byte so that the last line can always be terminated
+	hds_source.buf = (char *) malloc(HDS_TRACE_BUF_SIZE + 1);
+	if (!hds_source.buf) {
+		serror("source: Failed to allocate trace buffer");
+		close(hds_source.fd);
+		hds_source.fd = -1;
+		return HDS_ERR_NO_MEM;
+	}
+	hds_source.buf_len = hds_source.buf_pos = 0;
+	hds_source.line_no = 0;
+	return HDS_OK;
+}
+/**
+ * @brief Move unparsed bytes to the front of the buffer and read more.
+ * @return HDS_OK if more bytes were read, HDS_ERR_NO_SUCH_ELEMENT at end of
+ * 		file, HDS_ERR_FILE_IO on a read error.
+ */
+static int trace_fill_buffer() {
+	ssize_t n;
+	unsigned int left = hds_source.buf_len - hds_source.buf_pos;
+
+	memmove(hds_source.buf, hds_source.buf + hds_source.buf_pos, left);
+	hds_source.buf_len = left;
+	hds_source.buf_pos = 0;
+	if (left == HDS_TRACE_BUF_SIZE) {
+		// a single line fills the whole buffer, drop it
+		var_error("source: Line %lu of trace file is too long",
+				hds_source.line_no + 1);
+		hds_source.buf_len = 0;
+		left = 0;
+	}
+	do {
+		n = read(hds_source.fd, hds_source.buf + left,
+				HDS_TRACE_BUF_SIZE - left);
+	} while (n < 0 && errno == EINTR);
+	if (n < 0) {
+		var_error("source: Failed to read trace file: %s", strerror(errno));
+		return HDS_ERR_FILE_IO;
+	}
+	if (n == 0) {
+		return HDS_ERR_NO_SUCH_ELEMENT;
+	}
+	hds_source.buf_len += n;
+	return HDS_OK;
+}
+/**
+ * @brief Read lines until one holds a job. Blank lines, comments ('#') and
+ * 		a header line are skipped, as are malformed lines (with an error).
+ */
+static int trace_read_job(struct hds_process_t *job) {
+	char *line, *eol;
+	int rc;
+	bool at_eof = false;
+
+	while (1) {
+		line = hds_source.buf + hds_source.buf_pos;
+		eol = memchr(line, '\n', hds_source.buf_len - hds_source.buf_pos);
+		if (!eol) {
+			if (at_eof == true) {
+				if (hds_source.buf_pos == hds_source.buf_len) {
+					return HDS_ERR_NO_SUCH_ELEMENT;
+				}
+				// last line has no newline
+				eol = hds_source.buf + hds_source.buf_len;
+			} else {
+				rc = trace_fill_buffer();
+				if (rc == HDS_ERR_NO_SUCH_ELEMENT) {
+					at_eof = true;
+				} else if (rc != HDS_OK) {
+					return rc;
+				}
+				continue;
+			}
+		}
+		*eol = '\0';
+		hds_source.buf_pos = eol - hds_source.buf + 1;
+		if (hds_source.buf_pos > hds_source.buf_len) {
+			hds_source.buf_pos = hds_source.buf_len;
+		}
+		hds_source.line_no++;
+		if (trace_parse_line(line, job) == HDS_OK) {
+			return HDS_OK;
+		}
+	}
+}
+/**
+ * @brief Parse "arrival,priority,cpu,mem,printer,scanner", followed by a
+ * 		column for each kind added in max_resources, in their order. Those
+ * 		columns may be left out from the right, they are 0 then. A last
+ * 		column may name the kernel, as in process_list; sleep if none.
+ * @return HDS_OK if line holds a job else an error code.
+ */
+static int trace_parse_line(char *line, struct hds_process_t *job) {
+	long int v[3 + HDS_MAX_RESOURCES];
+	char *p = line, *end = NULL;
+	int i, k, n = 3 + hds_config.max_resources.kinds;
+	hds_kernel_t kernel = HDS_KERNEL_SLEEP;
+	bool negative = false, comma = false, bad_kernel = false;
+
+	while (*p == ' ' || *p == '\t') {
+		p++;
+	}
+	if (*p == '\0' || *p == '\r' || *p == '#') {
+		return HDS_ERR_NO_SUCH_ELEMENT;
+	}
+	for (i = 0; i < n; i++) {
+		v[i] = strtol(p, &end, 10);
+		if (end == p) {
+			break;
+		}
+		negative |= i != 1 && v[i] < 0;
+		p = end;
+		while (*p == ' ' || *p == '\t') {
+			p++;
+		}
+		if (!(comma = *p == ',')) {
+			i++;
+			break;
+		}
+		p++;
+	}
+	if (i == 0 && hds_source.line_no == 1) {
+		// header line
+		return HDS_ERR_NO_SUCH_ELEMENT;
+	}
+	// whatever follows a comma and is not a number must name a kernel
+	if (comma) {
+		bad_kernel = trace_parse_kernel(&p, &kernel) != HDS_OK;
+	}
+	// anything after the last column, e.g. a column too many, is left in p
+	if (i < 3 + HDS_RES_BUILTIN || bad_kernel || (*p != '\0' && *p != '\r')
+			|| negative || v[1] < 0 || v[1] > 3) {
+		var_error("source: Skipping malformed line %lu of trace file",
+				hds_source.line_no);
+		hds_source.lines_skipped++;
+		return HDS_ERR_INVALID_PROCESS;
+	}
+	memset(job, 0, sizeof(*job));
+	job->arrival = v[0];
+	job->priority = v[1];
+	job->cpu_req = v[2];
+	for (k = 0; k < i - 3; k++) {
+		job->req[k] = v[3 + k];
+	}
+	job->kernel = kernel;
+	return HDS_OK;
+}
+/**
+ * @brief Parse a kernel name at *p, moving *p past it and any blanks.
+ * @return HDS_OK if it names a kernel else an error code.
+ */
+static int trace_parse_kernel(char **p, hds_kernel_t *kernel) {
+	char name[16], *s = *p;
+	size_t len;
+	int found;
+
+	while (*s == ' ' || *s == '\t') {
+		s++;
+	}
+	len = strspn(s, "abcdefghijklmnopqrstuvwxyz");
+	if (len == 0 || len >= sizeof(name)) {
+		return HDS_ERR_NO_SUCH_ELEMENT;
+	}
+	memcpy(name, s, len);
+	name[len] = '\0';
+	if ((found = hds_kernel_lookup(name)) == -1) {
+		return HDS_ERR_NO_SUCH_ELEMENT;
+	}
+	s += len;
+	while (*s == ' ' || *s == '\t') {
+		s++;
+	}
+	*kernel = found;
+	*p = s;
+	return HDS_OK;
+}
+// //////////// Binary job file ////////////////////////
+static bool is_job_file(const char *filename) {
+	char magic[sizeof(((struct hds_job_file_header_t *) 0)->magic)];
+	int fd;
+	bool found = false;
+	if ((fd = open(filename, O_RDONLY)) < 0) {
+		return false;
+	}
+	if (read(fd, magic, sizeof(magic)) == sizeof(magic)
+			&& memcmp(magic, HDS_JOB_FILE_MAGIC, sizeof(HDS_JOB_FILE_MAGIC))
+					== 0) {
+		found = true;
+	}
+	close(fd);
+	return found;
+}
+/**
+ * @brief Map a binary job file and check its header.
+ */
+static int binary_open(const char *filename) {
+	const struct hds_job_file_header_t *header = NULL;
+	struct stat st;
+
+	if ((hds_source.fd = open(filename, O_RDONLY)) < 0
+			|| fstat(hds_source.fd, &st) != 0) {
+		var_error("source: Failed to open job file: %s", filename);
+		return HDS_ERR_FILE_IO;
+	}
+	if ((size_t) st.st_size < sizeof(struct hds_job_file_header_t)) {
+		var_error("source: Job file %s is truncated", filename);
+		return HDS_ERR_FILE_IO;
+	}
+	hds_source.map_len = st.st_size;
+	hds_source.map = mmap(NULL, hds_source.map_len, PROT_READ, MAP_PRIVATE,
+			hds_source.fd, 0);
+	if (hds_source.map == MAP_FAILED) {
+		hds_source.map = NULL;
+		var_error("source: Failed to map job file %s: %s", filename,
+				strerror(errno));
+		return HDS_ERR_FILE_IO;
+	}
+	// records are walked front to back, once
+	madvise(hds_source.map, hds_source.map_len, MADV_SEQUENTIAL);
+
+	header = (const struct hds_job_file_header_t *) hds_source.map;
+	if (le32toh(header->version) != HDS_JOB_FILE_VERSION
+			|| le32toh(header->record_size)
+					!= sizeof(struct hds_job_record_t)) {
+		var_error("source: Job file %s has unsupported version/record size, convert it again",
+				filename);
+		return HDS_ERR_FILE_IO;
+	}
+	hds_source.record_count = le64toh(header->count);
+	if (hds_source.record_count
+			> (hds_source.map_len - sizeof(struct hds_job_file_header_t))
+					/ sizeof(struct hds_job_record_t)) {
+		var_error("source: Job file %s is truncated", filename);
+		return HDS_ERR_FILE_IO;
+	}
+	hds_source.records = (const struct hds_job_record_t *) (header + 1);
+	hds_source.record_pos = 0;
+	return HDS_OK;
+}
+/**
+ * @brief Take the next record which holds a job. A record which needs a kind
+ * 		of resource hds.conf does not have is skipped (with an error): it
+ * 		was written with other max_resources and could never run. So is
+ * 		one whose kernel is unknown.
+ */
+static int binary_read_job(struct hds_process_t *job) {
+	const struct hds_job_record_t *r = NULL;
+	uint32_t kernel;
+	int k;
+	while (hds_source.record_pos < hds_source.record_count) {
+		r = &hds_source.records[hds_source.record_pos++];
+		memset(job, 0, sizeof(*job));
+		job->arrival = le64toh(r->arrival);
+		job->priority = (int32_t) le32toh(r->priority);
+		job->cpu_req = (int32_t) le32toh(r->cpu_req);
+		if ((kernel = le32toh(r->kernel)) >= HDS_KERNELS) {
+			var_error("source: Skipping record %lu of job file, it has unknown kernel %u",
+					(unsigned long int) hds_source.record_pos, kernel);
+			hds_source.records_skipped++;
+			continue;
+		}
+		job->kernel = kernel;
+		for (k = 0; k < HDS_MAX_RESOURCES; k++) {
+			job->req[k] = (int32_t) le32toh(r->req[k]);
+			if (k >= hds_config.max_resources.kinds && job->req[k] != 0) {
+				break;
+			}
+		}
+		if (k == HDS_MAX_RESOURCES) {
+			return HDS_OK;
+		}
+		var_error("source: Skipping record %lu of job file, it needs resource kind %d which is not in max_resources",
+				(unsigned long int) hds_source.record_pos, k + 1);
+		hds_source.records_skipped++;
+	}
+	return HDS_ERR_NO_SUCH_ELEMENT;
+}
+/**
+ * @brief Write every job of trace_file or the generator into a binary job
+ * 		file, in order of arrival.
+ * @param filename Job file to be written.
+ * @return HDS_OK on success else an error code.
+ */
+int hds_source_convert(const char *filename) {
+	struct hds_job_file_header_t header;
+	unsigned long int count = 0;
+	FILE *out = NULL;
+	int rc = HDS_OK;
+
+	if (!(out = fopen(filename, "wb"))) {
+		var_error("convert: Failed to open %s", filename);
+		return HDS_ERR_FILE_IO;
+	}
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, HDS_JOB_FILE_MAGIC, sizeof(HDS_JOB_FILE_MAGIC));
+	header.version = htole32(HDS_JOB_FILE_VERSION);
+	header.record_size = htole32(sizeof(struct hds_job_record_t));
+	// count is filled in once every record is written
+	if (fwrite(&header, sizeof(header), 1, out) != 1) {
+		rc = HDS_ERR_FILE_IO;
+	} else {
+		rc = write_jobs(out, write_job_record, &count);
+	}
+	if (rc == HDS_OK) {
+		header.count = htole64(count);
+		if (fseek(out, 0, SEEK_SET) != 0
+				|| fwrite(&header, sizeof(header), 1, out) != 1) {
+			rc = HDS_ERR_FILE_IO;
+		}
+	}
+	if (fclose(out) != 0 || rc != HDS_OK) {
+		var_error("convert: Failed to write %s", filename);
+		return HDS_ERR_FILE_IO;
+	}
+	var_debug("convert: Wrote %lu jobs to %s", count, filename);
+	return HDS_OK;
+}
+/**
+ * @brief Same as hds_source_convert() but writes a CSV trace, which can be
+ * 		read back as trace_file. Used to keep a generated workload; like
+ * 		there, process_list is not written.
+ * @param filename Trace file to be written, "-" for stdout.
+ * @return HDS_OK on success else an error code.
+ */
+int hds_source_dump(const char *filename) {
+	unsigned long int count = 0;
+	FILE *out = NULL;
+	int k, rc = HDS_OK;
+
+	if (strcmp(filename, "-") == 0) {
+		out = stdout;
+	} else if (!(out = fopen(filename, "w"))) {
+		var_error("dump: Failed to open %s", filename);
+		return HDS_ERR_FILE_IO;
+	}
+	if (fprintf(out, "arrival,priority,cpu,mem,printer,scanner") < 0) {
+		rc = HDS_ERR_FILE_IO;
+	}
+	for (k = HDS_RES_BUILTIN; rc == HDS_OK && k < hds_config.max_resources.kinds;
+			k++) {
+		if (fprintf(out, ",%s", hds_config.max_resources.name[k]) < 0) {
+			rc = HDS_ERR_FILE_IO;
+		}
+	}
+	if (rc == HDS_OK && fputs(",kernel\n", out) == EOF) {
+		rc = HDS_ERR_FILE_IO;
+	}
+	if (rc == HDS_OK) {
+		rc = write_jobs(out, write_job_line, &count);
+	}
+	if ((out == stdout ? fflush(out) : fclose(out)) != 0 || rc != HDS_OK) {
+		var_error("dump: Failed to write %s", filename);
+		return HDS_ERR_FILE_IO;
+	}
+	var_debug("dump: Wrote %lu jobs to %s", count, filename);
+	return HDS_OK;
+}
+/**
+ * @brief Write every job of the streamed source, in order of arrival. The
+ * 		source is streamed, so sources of any size can be written.
+ *
+ * process_list is left out: it stays in hds.conf, so a run with the file
+ * written as trace_file would get those jobs twice.
+ * @param out File to write to.
+ * @param write_job Writes a single job in the output format.
+ * @param count Set to the no. of jobs written.
+ * @return HDS_OK on success else an error code.
+ */
+static int write_jobs(FILE *out,
+		int (*write_job)(FILE *out, const struct hds_process_t *job),
+		unsigned long int *count) {
+	struct hds_process_t job;
+	int rc = HDS_OK;
+
+	*count = 0;
+	if (hds_source_open() != HDS_OK) {
+		rc = HDS_ERR_FILE_IO;
+	} else if (hds_source.type == HDS_SOURCE_NONE) {
+		swarn("convert: No trace_file or generator, no jobs to write");
+	}
+	while (rc == HDS_OK && hds_source_next(&job) == HDS_OK) {
+		rc = write_job(out, &job);
+		(*count)++;
+	}
+	hds_source_close();
+	return rc;
+}
+static int write_job_record(FILE *out, const struct hds_process_t *job) {
+	struct hds_job_record_t r;
+	int k;
+	memset(&r, 0, sizeof(r));
+	r.arrival = htole64(job->arrival);
+	r.job_id = htole32(job->job_id);
+	r.priority = htole32(job->priority);
+	r.cpu_req = htole32(job->cpu_req);
+	for (k = 0; k < HDS_MAX_RESOURCES; k++) {
+		r.req[k] = htole32(job->req[k]);
+	}
+	r.kernel = htole32(job->kernel);
+	return fwrite(&r, sizeof(r), 1, out) == 1 ? HDS_OK : HDS_ERR_FILE_IO;
+}
+static int write_job_line(FILE *out, const struct hds_process_t *job) {
+	int k;
+	if (fprintf(out, "%lu,%d,%d", job->arrival, job->priority, job->cpu_req)
+			< 0) {
+		return HDS_ERR_FILE_IO;
+	}
+	// memory, printer, scanner and every kind added in max_resources
+	for (k = 0; k < hds_config.max_resources.kinds; k++) {
+		if (fprintf(out, ",%d", job->req[k]) < 0) {
+			return HDS_ERR_FILE_IO;
+		}
+	}
+	return fprintf(out, ",%s\n", hds_kernel_name(job->kernel)) < 0 ?
+			HDS_ERR_FILE_IO : HDS_OK;
+}
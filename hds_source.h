@@ -0,0 +1,112 @@
+/**
+ * @file hds_source.h
+ * @brief header file for hds_source.c
+ */
+#ifndef HDS_SOURCE_H_
+#define HDS_SOURCE_H_
+
+#include "hds_common.h"
+#include "hds_gen.h"
+#include <stdint.h>
+#include <endian.h>
+#include <sys/mman.h>
+
+/**
+ * @def HDS_TRACE_BUF_SIZE
+ * @brief Bytes read from a trace file at a time. Also the longest line a
+ * 		trace file may have.
+ */
+#define HDS_TRACE_BUF_SIZE (64 * 1024)
+/**
+ * @enum hds_source_type_t
+ * @brief Where jobs are streamed from, in addition to process_list.
+ */
+typedef enum {
+	HDS_SOURCE_NONE, /**< Only process_list from hds.conf */
+	HDS_SOURCE_TRACE, /**< CSV trace: arrival,priority,cpu,mem,printer,scanner
+						   and one column per kind added in max_resources */
+	HDS_SOURCE_BINARY, /**< Job file of fixed size records, see below */
+	HDS_SOURCE_GENERATOR /**< Jobs drawn by the seeded workload generator */
+} hds_source_type_t;
+/*
+ * Binary job file
+ * ---------------
+ * A header followed by 'count' records sorted on arrival. All fields are
+ * little-endian. The file is mapped and records are read in place, nothing
+ * is parsed. Written by 'hds -b --convert FILE'.
+ */
+/**
+ * @def HDS_JOB_FILE_MAGIC
+ * @brief First 8 bytes of a binary job file.
+ */
+#define HDS_JOB_FILE_MAGIC "HDSJOBS"
+#define HDS_JOB_FILE_VERSION 2
+/**
+ * @struct hds_job_file_header_t
+ * @brief Header of a binary job file, 32 bytes.
+ */
+struct hds_job_file_header_t {
+	char magic[8]; /**< HDS_JOB_FILE_MAGIC, NUL padded */
+	uint32_t version; /**< HDS_JOB_FILE_VERSION */
+	uint32_t record_size; /**< sizeof(struct hds_job_record_t) */
+	uint64_t count; /**< No. of records following the header */
+	uint64_t reserved;
+}__attribute__((packed));
+/**
+ * @struct hds_job_record_t
+ * @brief One job of a binary job file, 64 bytes.
+ */
+struct hds_job_record_t {
+	uint64_t arrival; /**< Offset from start of run, in time quanta */
+	uint32_t job_id; /**< As written; jobs read are given new ones */
+	int32_t priority;
+	int32_t cpu_req;
+	/** memory_req, printer_req, scanner_req, then kinds added in
+	 * max_resources in their order; 0 past the kinds in use */
+	int32_t req[HDS_MAX_RESOURCES];
+	uint32_t kernel; /**< hds_kernel_t, 0 is sleep */
+	uint32_t reserved[2]; /**< Zero, kept for future per-job fields */
+}__attribute__((packed));
+_Static_assert(sizeof(struct hds_job_file_header_t) == 32,
+		"job file header must be 32 bytes");
+_Static_assert(sizeof(struct hds_job_record_t) == 64,
+		"job record must be 64 bytes");
+/**
+ * @struct hds_source_t
+ * @brief A streaming job source. Jobs are read one at a time, so memory use
+ * 		does not depend on the size of the source. The next job is kept in
+ * 		'next' so that its arrival can be looked at before it is taken.
+ */
+struct hds_source_t {
+	hds_source_type_t type;
+	bool has_next; /**< 'next' holds a job which has not been taken yet */
+	bool exhausted; /**< Nothing left to read, or source is closed */
+	struct hds_process_t next;
+	unsigned long int jobs_read;
+
+	// trace reader
+	int fd;
+	char *buf;
+	unsigned int buf_len; /**< Bytes of buf holding data */
+	unsigned int buf_pos; /**< Start of the first unparsed line */
+	unsigned long int line_no;
+	unsigned long int lines_skipped;
+
+	// binary job file
+	const struct hds_job_record_t *records; /**< Mapped records */
+	void *map; /**< Whole mapped file */
+	size_t map_len;
+	uint64_t record_count;
+	uint64_t record_pos; /**< Next record to be read */
+	unsigned long int records_skipped;
+} hds_source;
+
+// --------routines-----------
+int hds_source_open();
+bool hds_source_peek(unsigned long int *arrival);
+int hds_source_next(struct hds_process_t *job);
+bool hds_source_done();
+void hds_source_close();
+int hds_source_convert(const char *filename);
+int hds_source_dump(const char *filename);
+#endif /* HDS_SOURCE_H_ */
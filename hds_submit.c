@@ -0,0 +1,195 @@
+/**
+ * @file hds_submit.c
+ * @brief Lock-free submission ring for adding jobs while the engine runs.
+ *
+ * Any thread may submit jobs (one at a time or in bulk) without taking a
+ * mutex. The dispatcher drains the ring into the arrival queue. When the ring
+ * is full the submission is refused and counted, so that a fast producer
+ * sees backpressure instead of blocking the engine.
+ */
+#include "hds_submit.h"
+#include "hds_core.h"
+//=========== routines declaration============
+static void update_high_watermark(unsigned long int tail);
+//===========================================
+/**
+ * @brief Allocate the submission ring.
+ * @param capacity No. of slots, rounded up to a power of two. 0 means
+ * 		HDS_SUBMIT_RING_SIZE.
+ * @return HDS_OK on success else HDS_ERR_NO_MEM.
+ */
+int hds_submit_init(unsigned int capacity) {
+	unsigned long int size = 2, i;
+	if (capacity == 0) {
+		capacity = HDS_SUBMIT_RING_SIZE;
+	}
+	while (size < capacity) {
+		size <<= 1;
+	}
+	hds_submit_ring.cells = (struct hds_submit_cell_t *) malloc(
+			size * sizeof(struct hds_submit_cell_t));
+	if (!hds_submit_ring.cells) {
+		serror("Failed to allocate submission ring");
+		return HDS_ERR_NO_MEM;
+	}
+	for (i = 0; i < size; i++) {
+		atomic_init(&hds_submit_ring.cells[i].seq, i);
+	}
+	hds_submit_ring.mask = size - 1;
+	atomic_init(&hds_submit_ring.enqueue_pos, 0);
+	atomic_init(&hds_submit_ring.dequeue_pos, 0);
+	atomic_init(&hds_submit_ring.submitted, 0);
+	atomic_init(&hds_submit_ring.rejected, 0);
+	atomic_init(&hds_submit_ring.drained, 0);
+	atomic_init(&hds_submit_ring.high_watermark, 0);
+	return HDS_OK;
+}
+/**
+ * @brief Free the submission ring. Jobs still in it are dropped.
+ */
+void hds_submit_destroy() {
+	free(hds_submit_ring.cells);
+	hds_submit_ring.cells = NULL;
+}
+/**
+ * @brief Submit a single job.
+ * @param job The job. Its arrival is taken as a delay, in time quanta, from
+ * 		the time the dispatcher picks it up.
+ * @return HDS_OK if it was queued, HDS_ERR_QUEUE_FULL if the ring is full.
+ */
+int hds_submit_job(const struct hds_process_t *job) {
+	return hds_submit_jobs(job, 1) == 1 ? HDS_OK : HDS_ERR_QUEUE_FULL;
+}
+/**
+ * @brief Submit several jobs with a single claim on the ring.
+ *
+ * As many jobs as there are free slots are accepted, in order, the rest are
+ * refused and counted as rejected.
+ * @param jobs Array of jobs.
+ * @param n No. of jobs in the array.
+ * @return No. of jobs accepted, from the start of the array.
+ */
+unsigned int hds_submit_jobs(const struct hds_process_t *jobs, unsigned int n) {
+	struct hds_submit_cell_t *cell = NULL;
+	unsigned long int pos, seq, k;
+
+	if (n == 0 || !hds_submit_ring.cells) {
+		return 0;
+	}
+	pos = atomic_load_explicit(&hds_submit_ring.enqueue_pos,
+			memory_order_relaxed);
+	while (1) {
+		// count free slots from pos onwards, up to n
+		for (k = 0; k < n; k++) {
+			cell = &hds_submit_ring.cells[(pos + k) & hds_submit_ring.mask];
+			seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+			if (seq != pos + k) {
+				break;
+			}
+		}
+		if (k == 0) {
+			if ((long int) (seq - pos) < 0) {
+				// slot still holds a job from the previous lap: ring is full
+				atomic_fetch_add_explicit(&hds_submit_ring.rejected, n,
+						memory_order_relaxed);
+				return 0;
+			}
+			// another producer got here first
+			pos = atomic_load_explicit(&hds_submit_ring.enqueue_pos,
+					memory_order_relaxed);
+			continue;
+		}
+		if (atomic_compare_exchange_weak_explicit(&hds_submit_ring.enqueue_pos,
+				&pos, pos + k, memory_order_relaxed, memory_order_relaxed)) {
+			break;
+		}
+		//pos has been reloaded by the failed compare-and-swap
+	}
+	// slots pos .. pos+k-1 are ours now
+	for (seq = 0; seq < k; seq++) {
+		cell = &hds_submit_ring.cells[(pos + seq) & hds_submit_ring.mask];
+		cell->job = jobs[seq];
+		cell->job.next = NULL;
+		atomic_store_explicit(&cell->seq, pos + seq + 1, memory_order_release);
+	}
+	atomic_fetch_add_explicit(&hds_submit_ring.submitted, k,
+			memory_order_relaxed);
+	if (k < n) {
+		atomic_fetch_add_explicit(&hds_submit_ring.rejected, n - k,
+				memory_order_relaxed);
+	}
+	update_high_watermark(pos + k);
+	// dispatcher may be asleep waiting for the next arrival
+	hds_wakeup_signal(&hds_core_state.dispatcher_wakeup);
+	return k;
+}
+/**
+ * @brief Take jobs out of the ring. Must only be called by one thread.
+ * @param jobs Array to copy jobs into.
+ * @param max Size of the array.
+ * @return No. of jobs copied.
+ */
+unsigned int hds_submit_drain(struct hds_process_t *jobs, unsigned int max) {
+	struct hds_submit_cell_t *cell = NULL;
+	unsigned long int pos;
+	unsigned int i;
+
+	if (!hds_submit_ring.cells) {
+		return 0;
+	}
+	pos = atomic_load_explicit(&hds_submit_ring.dequeue_pos,
+			memory_order_relaxed);
+	for (i = 0; i < max; i++, pos++) {
+		cell = &hds_submit_ring.cells[pos & hds_submit_ring.mask];
+		if (atomic_load_explicit(&cell->seq, memory_order_acquire) != pos + 1) {
+			// empty, or producer has claimed the slot but not yet written it
+			break;
+		}
+		jobs[i] = cell->job;
+		// free for the producer one lap ahead
+		atomic_store_explicit(&cell->seq, pos + hds_submit_ring.mask + 1,
+				memory_order_release);
+	}
+	atomic_store_explicit(&hds_submit_ring.dequeue_pos, pos,
+			memory_order_relaxed);
+	if (i > 0) {
+		atomic_fetch_add_explicit(&hds_submit_ring.drained, i,
+				memory_order_relaxed);
+	}
+	return i;
+}
+/**
+ * @brief No. of jobs claimed by producers and not yet drained.
+ */
+unsigned long int hds_submit_pending() {
+	// dequeue_pos first: enqueue_pos read after it can not be behind it
+	unsigned long int head = atomic_load(&hds_submit_ring.dequeue_pos);
+	return atomic_load(&hds_submit_ring.enqueue_pos) - head;
+}
+/**
+ * @brief Read the backpressure counters.
+ */
+void hds_submit_get_stats(struct hds_submit_stats_t *stats) {
+	stats->capacity = hds_submit_ring.cells ? hds_submit_ring.mask + 1 : 0;
+	stats->pending = hds_submit_pending();
+	stats->submitted = atomic_load(&hds_submit_ring.submitted);
+	stats->rejected = atomic_load(&hds_submit_ring.rejected);
+	stats->drained = atomic_load(&hds_submit_ring.drained);
+	stats->high_watermark = atomic_load(&hds_submit_ring.high_watermark);
+}
+/**
+ * @brief Record the ring depth seen by a producer.
+ * @param tail enqueue_pos right after the producer's claim.
+ */
+static void update_high_watermark(unsigned long int tail) {
+	unsigned long int head = atomic_load(&hds_submit_ring.dequeue_pos), depth;
+	unsigned long int cur = atomic_load_explicit(
+			&hds_submit_ring.high_watermark, memory_order_relaxed);
+	// consumer may already have drained past our claim
+	depth = tail > head ? tail - head : 0;
+	while (depth > cur
+			&& !atomic_compare_exchange_weak_explicit(
+					&hds_submit_ring.high_watermark, &cur, depth,
+					memory_order_relaxed, memory_order_relaxed)) {
+	}
+}
@@ -0,0 +1,72 @@
+/**
+ * @file hds_submit.h
+ * @brief header file for hds_submit.c
+ */
+#ifndef HDS_SUBMIT_H_
+#define HDS_SUBMIT_H_
+
+#include "hds_common.h"
+#include <stdatomic.h>
+
+/**
+ * @def HDS_SUBMIT_RING_SIZE
+ * @brief Default no. of slots in the submission ring. Rounded up to a power
+ * 		of two, can be changed with submit_ring_size in hds.conf.
+ */
+#define HDS_SUBMIT_RING_SIZE 1024
+/**
+ * @def HDS_SUBMIT_DRAIN_BATCH
+ * @brief No. of jobs the dispatcher takes out of the ring at a time.
+ */
+#define HDS_SUBMIT_DRAIN_BATCH 64
+/**
+ * @struct hds_submit_cell_t
+ * @brief One slot of the submission ring. seq tells whose turn it is: equal
+ * 		to the slot's position when free for producers, position + 1 once a
+ * 		job has been written and it can be read by the consumer.
+ */
+struct hds_submit_cell_t {
+	atomic_ulong seq;
+	struct hds_process_t job;
+};
+/**
+ * @struct hds_submit_ring_t
+ * @brief Bounded multi-producer/single-consumer ring through which jobs are
+ * 		submitted while the engine is running. Producers (console, or any
+ * 		other thread) claim slots with a compare-and-swap on enqueue_pos and
+ * 		never block; the dispatcher is the only consumer.
+ */
+struct hds_submit_ring_t {
+	struct hds_submit_cell_t *cells;
+	unsigned long int mask; /**< capacity - 1 */
+	atomic_ulong enqueue_pos;
+	atomic_ulong dequeue_pos; /**< Only written by the consumer */
+
+	// backpressure counters
+	atomic_ulong submitted; /**< Jobs accepted into the ring */
+	atomic_ulong rejected; /**< Jobs refused because the ring was full */
+	atomic_ulong drained; /**< Jobs taken out by the consumer */
+	atomic_ulong high_watermark; /**< Most jobs seen waiting at one time */
+} hds_submit_ring;
+/**
+ * @struct hds_submit_stats_t
+ * @brief Snapshot of the submission ring counters.
+ */
+struct hds_submit_stats_t {
+	unsigned long int capacity;
+	unsigned long int pending;
+	unsigned long int submitted;
+	unsigned long int rejected;
+	unsigned long int drained;
+	unsigned long int high_watermark;
+};
+
+// --------routines-----------
+int hds_submit_init(unsigned int capacity);
+void hds_submit_destroy();
+int hds_submit_job(const struct hds_process_t *job);
+unsigned int hds_submit_jobs(const struct hds_process_t *jobs, unsigned int n);
+unsigned int hds_submit_drain(struct hds_process_t *jobs, unsigned int max);
+unsigned long int hds_submit_pending();
+void hds_submit_get_stats(struct hds_submit_stats_t *stats);
+#endif /* HDS_SUBMIT_H_ */
@@ -3,6 +3,7 @@
  * @brief This source file contains code for rendering curses based UI.
  */
 #include "hds_ui.h"
+#include "hds_kernel.h"
 //========== routines declarations ==============
 static WINDOW *create_newwin(int height, int width, int starty, int startx);
 
@@ -15,6 +16,16 @@ static void draw_input_window();
 static void create_cdkscreens();
 static void draw_console();
 static void draw_output_console();
+static void ui_log_sink(const char* msg, log_level_t log_level);
+static int calculate_msg_center_position(int msg_len);
+static void log_msg_to_console(const char* msg, log_level_t level);
+static void init_window_pointers();
+static void init_cdks_pointers();
+static void destroy_hds_window(); //main routine for deleting windows
+static void redraw_cdkscreens(); //draw cdkscrens after drawing a popup window or
+static void print_loaded_configs() ;
+static void print_current_cpu_stats();
+static void submit_job_from_console(const char *command);
 
 static BINDFN_PROTO (XXXCB);
 //===============================================
@@ -23,14 +34,50 @@ static int XXXCB(EObjectType cdktype GCC_UNUSED, void *object GCC_UNUSED,
 	return (TRUE);
 }
 
+/**
+ * @brief Init the hds_ui_state
+ *
+ * Ensure that window and CDK pointers are initialized to null or empty or
+ * relevant values before curses mode is entered.
+ */
+void init_hds_ui_state() {
+	init_window_pointers();
+	init_cdks_pointers();
+	hds_ui_state.color_ok = false;
+	hds_ui_state.gui_ready = false;
+	hds_ui_state.curses_ready = false;
+	hds_ui_state.cursesWin = NULL;
+	/*
+	 * now for all three windows we set the cur_x and cur_y to 0
+	 */
+
+	hds_ui_state.output_win.beg_x = hds_ui_state.output_win.beg_y =
+			hds_ui_state.output_win.cur_x = hds_ui_state.output_win.cur_y =
+					hds_ui_state.output_win.height =
+							hds_ui_state.output_win.width = 0;
+
+	hds_ui_state.input_win.beg_x = hds_ui_state.input_win.beg_y =
+			hds_ui_state.input_win.cur_x = hds_ui_state.input_win.cur_y =
+					hds_ui_state.input_win.height =
+							hds_ui_state.input_win.width = 0;
+
+	hds_ui_state.console_win.beg_x = hds_ui_state.console_win.beg_y =
+			hds_ui_state.console_win.cur_x = hds_ui_state.console_win.cur_y =
+					hds_ui_state.console_win.height =
+							hds_ui_state.console_win.width = 0;
+	//init cdk specific pointers
+	hds_ui_state.console = NULL;
+	hds_ui_state.read_input = NULL;
+	hds_ui_state.output_screen = NULL;
+}
 /**
  * @brief Initialise curses mode for hds.
  * @return Return HDS_OK if successful else an error code.
  */
 int init_curses() {
 	//master curses window
-	hds_state.cursesWin = initscr();
-	if (hds_state.cursesWin == NULL ) {
+	hds_ui_state.cursesWin = initscr();
+	if (hds_ui_state.cursesWin == NULL ) {
 		fprintf(stderr, "init_curses(): initscr() failed. Aborting");
 		return HDS_ERR_INIT_UI;
 	}
@@ -52,7 +99,9 @@ int init_curses() {
 	if (NOECHO)
 		noecho(); //disable echoing
 
-	hds_state.curses_ready = true;
+	hds_ui_state.curses_ready = true;
+	//from now on log messages are displayed by us
+	hds_state.log_sink = ui_log_sink;
 	return HDS_OK;
 }
 /**
@@ -75,7 +124,7 @@ int hds_ui_main() {
 	draw_console();
 	draw_output_console();
 	//set gui_ok in hds_state
-	hds_state.gui_ready = TRUE;
+	hds_ui_state.gui_ready = TRUE;
 	//every thing is fine so far
 	return HDS_OK;
 }
@@ -87,12 +136,12 @@ int hds_ui_main() {
  */
 static void create_cdkscreens() {
 	//by now we have window pointers, lets create cdkscreens out of them.
-	hds_state.console_win.cdksptr = initCDKScreen(hds_state.console_win.wptr);
-	hds_state.output_win.cdksptr = initCDKScreen(hds_state.output_win.wptr);
-	hds_state.input_win.cdksptr = initCDKScreen(hds_state.input_win.wptr);
+	hds_ui_state.console_win.cdksptr = initCDKScreen(hds_ui_state.console_win.wptr);
+	hds_ui_state.output_win.cdksptr = initCDKScreen(hds_ui_state.output_win.wptr);
+	hds_ui_state.input_win.cdksptr = initCDKScreen(hds_ui_state.input_win.wptr);
 
 	//also create the master cdkscreen which will be used for popup messages.
-	hds_state.master_screen = initCDKScreen(hds_state.cursesWin);
+	hds_ui_state.master_screen = initCDKScreen(hds_ui_state.cursesWin);
 }
 /**
  * @brief Draw master windows. Actual implementation.
@@ -126,18 +175,18 @@ static int draw_windows() {
 	width = MIN_COLS;
 	startx = horizontal_padding;
 	starty = vertical_padding;
-	if ((hds_state.output_win.wptr = create_newwin(height, width, starty,
+	if ((hds_ui_state.output_win.wptr = create_newwin(height, width, starty,
 			startx)) == NULL ) {
 		serror("Error: failed to create window:menubar");
 		return HDS_ERR_DRAW_WINDOWS;
 	}
 	//save the starting coordinates of menubar
-	hds_state.output_win.beg_x = startx;
-	hds_state.output_win.beg_y = starty;
-	hds_state.output_win.cur_x = startx;
-	hds_state.output_win.cur_y = starty;
-	hds_state.output_win.height = height;
-	hds_state.output_win.width = width;
+	hds_ui_state.output_win.beg_x = startx;
+	hds_ui_state.output_win.beg_y = starty;
+	hds_ui_state.output_win.cur_x = startx;
+	hds_ui_state.output_win.cur_y = starty;
+	hds_ui_state.output_win.height = height;
+	hds_ui_state.output_win.width = width;
 
 	//draw window input_win
 	starty += height + 1;
@@ -145,17 +194,17 @@ static int draw_windows() {
 	height = INPUT_WINDOW_SIZE;
 	width = MIN_COLS;
 
-	if ((hds_state.input_win.wptr = create_newwin(height, width, starty, startx))
+	if ((hds_ui_state.input_win.wptr = create_newwin(height, width, starty, startx))
 			== NULL ) {
 		serror("Error: failed to create window:info_win");
 		return HDS_ERR_DRAW_WINDOWS;
 	}
-	hds_state.input_win.beg_x = startx;
-	hds_state.input_win.beg_y = starty;
-	hds_state.input_win.cur_x = startx;
-	hds_state.input_win.cur_y = starty;
-	hds_state.input_win.height = height;
-	hds_state.input_win.width = width;
+	hds_ui_state.input_win.beg_x = startx;
+	hds_ui_state.input_win.beg_y = starty;
+	hds_ui_state.input_win.cur_x = startx;
+	hds_ui_state.input_win.cur_y = starty;
+	hds_ui_state.input_win.height = height;
+	hds_ui_state.input_win.width = width;
 
 	//draw window console
 	starty += height + 1;
@@ -163,7 +212,7 @@ static int draw_windows() {
 	height = MIN_LINES - (OUTPUT_WINDOW_SIZE + 1 + INPUT_WINDOW_SIZE + 1);
 	width = MIN_COLS;
 
-	if ((hds_state.console_win.wptr = create_newwin(height, width, starty,
+	if ((hds_ui_state.console_win.wptr = create_newwin(height, width, starty,
 			startx)) == NULL ) {
 		serror("Error: failed to create window:console_win");
 		return HDS_ERR_DRAW_WINDOWS;
@@ -204,7 +253,7 @@ static void draw_output_window() {
 	const char *lblText[2]; //means 2 lines of strings of indefinite length
 	//label for this window
 	lblText[0] = "<C>Output";
-	lblHelp = newCDKLabel(hds_state.output_win.cdksptr, CENTER, TOP,
+	lblHelp = newCDKLabel(hds_ui_state.output_win.cdksptr, CENTER, TOP,
 			(CDK_CSTRING2) lblText, 1, FALSE, FALSE);
 	drawCDKLabel(lblHelp, ObjOf (lblHelp)->box);
 }
@@ -219,8 +268,8 @@ static void draw_output_window() {
 static void calculate_padding(int *hor_padding, int *ver_padding) {
 	*hor_padding = (COLS - MIN_COLS) / 2;
 	*ver_padding = (LINES - MIN_LINES) / 2;
-	hds_state.hori_pad = *hor_padding;
-	hds_state.vert_pad = *ver_padding;
+	hds_ui_state.hori_pad = *hor_padding;
+	hds_ui_state.vert_pad = *ver_padding;
 }
 /**
  * @brief Initialize CDK specific features
@@ -265,22 +314,22 @@ static void draw_input_window() {
 	CDKLABEL *lblTitle = NULL;
 	//set the title bar
 	lblText[0] = "<C>Input";
-	lblTitle = newCDKLabel(hds_state.input_win.cdksptr, CENTER, TOP,
+	lblTitle = newCDKLabel(hds_ui_state.input_win.cdksptr, CENTER, TOP,
 			(CDK_CSTRING2) lblText, 1, FALSE, FALSE);
 	drawCDKLabel(lblTitle, ObjOf (lblTitle)->box);
 
 	//draw the input widget
-	hds_state.read_input = newCDKEntry(hds_state.input_win.cdksptr,
-			hds_state.input_win.cur_x + 1, hds_state.input_win.cur_y + 1, "",
+	hds_ui_state.read_input = newCDKEntry(hds_ui_state.input_win.cdksptr,
+			hds_ui_state.input_win.cur_x + 1, hds_ui_state.input_win.cur_y + 1, "",
 			"<C>HDS>", A_NORMAL, '.', vMIXED, 40, 0, 256, false, false);
 
-	bindCDKObject(vENTRY, hds_state.read_input, '?', XXXCB, 0);
+	bindCDKObject(vENTRY, hds_ui_state.read_input, '?', XXXCB, 0);
 
-	if (!hds_state.read_input) {
+	if (!hds_ui_state.read_input) {
 		serror("Failed to create input widget !!");
 		return;
 	}
-	refreshCDKScreen(hds_state.input_win.cdksptr);
+	refreshCDKScreen(hds_ui_state.input_win.cdksptr);
 }
 /**
  * @brief Draws result window.
@@ -288,20 +337,20 @@ static void draw_input_window() {
 static void draw_output_console() {
 	const char *console_title = "<C></B/U/7>Results";
 	/* Create the scrolling window. */
-	hds_state.output_screen = newCDKSwindow(hds_state.output_win.cdksptr,
-			CDKparamValue(&hds_state.params, 'X', CENTER),
-			CDKparamValue(&hds_state.params, 'Y', CENTER),
-			CDKparamValue(&hds_state.params, 'H', hds_state.output_win.height),
-			CDKparamValue(&hds_state.params, 'W', hds_state.output_win.width),
-			console_title, 100, CDKparamValue(&hds_state.params, 'N', TRUE),
-			CDKparamValue(&hds_state.params, 'S', FALSE));
+	hds_ui_state.output_screen = newCDKSwindow(hds_ui_state.output_win.cdksptr,
+			CDKparamValue(&hds_ui_state.params, 'X', CENTER),
+			CDKparamValue(&hds_ui_state.params, 'Y', CENTER),
+			CDKparamValue(&hds_ui_state.params, 'H', hds_ui_state.output_win.height),
+			CDKparamValue(&hds_ui_state.params, 'W', hds_ui_state.output_win.width),
+			console_title, 100, CDKparamValue(&hds_ui_state.params, 'N', TRUE),
+			CDKparamValue(&hds_ui_state.params, 'S', FALSE));
 
 	/* Is the window null. */
-	if (hds_state.output_screen == 0) {
+	if (hds_ui_state.output_screen == 0) {
 		report_error(HDS_ERR_CDK_CONSOLE_DRAW);
 	}
 	/* Draw the scrolling window. */
-	drawCDKSwindow(hds_state.output_screen, ObjOf (hds_state.output_screen)->box);
+	drawCDKSwindow(hds_ui_state.output_screen, ObjOf (hds_ui_state.output_screen)->box);
 }
 /**
  * @brief Draws console window.
@@ -309,18 +358,386 @@ static void draw_output_console() {
 static void draw_console() {
 	const char *console_title = "<C></B/U/7>Log Window";
 	/* Create the scrolling window. */
-	hds_state.console = newCDKSwindow(hds_state.console_win.cdksptr,
-			CDKparamValue(&hds_state.params, 'X', CENTER),
-			CDKparamValue(&hds_state.params, 'Y', CENTER),
-			CDKparamValue(&hds_state.params, 'H', hds_state.console_win.height),
-			CDKparamValue(&hds_state.params, 'W', hds_state.console_win.width),
-			console_title, 100, CDKparamValue(&hds_state.params, 'N', TRUE),
-			CDKparamValue(&hds_state.params, 'S', FALSE));
+	hds_ui_state.console = newCDKSwindow(hds_ui_state.console_win.cdksptr,
+			CDKparamValue(&hds_ui_state.params, 'X', CENTER),
+			CDKparamValue(&hds_ui_state.params, 'Y', CENTER),
+			CDKparamValue(&hds_ui_state.params, 'H', hds_ui_state.console_win.height),
+			CDKparamValue(&hds_ui_state.params, 'W', hds_ui_state.console_win.width),
+			console_title, 100, CDKparamValue(&hds_ui_state.params, 'N', TRUE),
+			CDKparamValue(&hds_ui_state.params, 'S', FALSE));
 
 	/* Is the window null. */
-	if (hds_state.console == 0) {
+	if (hds_ui_state.console == 0) {
 		report_error(HDS_ERR_CDK_CONSOLE_DRAW);
 	}
 	/* Draw the scrolling window. */
-	drawCDKSwindow(hds_state.console, ObjOf (hds_state.console)->box);
+	drawCDKSwindow(hds_ui_state.console, ObjOf (hds_ui_state.console)->box);
+}
+/**
+ * @brief Log sink of the curses frontend, called by log_generic().
+ *
+ * Once UI is fully ready the message goes to the console window, before that
+ * it is printed at LINES-1,COLS/2. The latter will overwrite last logged
+ * message and requires a full screen refresh.
+ * @param msg The message which is to be logged
+ * @param log_level One of LOG_DEBUG,LOG_WARN or LOG_ERR
+ */
+static void ui_log_sink(const char* msg, log_level_t log_level) {
+	int msg_len = strlen(msg);
+	int beg_x = 0;
+	if (hds_ui_state.gui_ready) {
+		//log this msg to console
+		log_msg_to_console(msg, log_level);
+	} else if (hds_ui_state.curses_ready) {
+		beg_x = calculate_msg_center_position(msg_len);
+		/*
+		 * if previously a message was logged, then logging this msg will
+		 * corrupt the display. so we will delete this line and write the msg
+		 */
+		move(LINES - 1, 0);
+		deleteln();
+		//donot forget to add horizontal padding
+		mvprintw(LINES - 1, beg_x + hds_ui_state.hori_pad, "%s", msg);
+		refresh();
+	} else {
+		fprintf(stderr, "%s", msg);
+	}
+}
+/**
+ * @brief Destroy cdk screen pointers that are present in hds_ui_state.
+ */
+void destroy_cdkscreens() {
+	destroyCDKScreen(hds_ui_state.output_win.cdksptr);
+
+	//first desteoy the entry widget
+	destroyCDKEntry(hds_ui_state.read_input);
+	destroyCDKScreen(hds_ui_state.input_win.cdksptr);
+
+	destroyCDKScreen(hds_ui_state.console_win.cdksptr);
+}
+/**
+ * @brief Initialize window pointers of hds_state
+ */
+static void init_window_pointers() {
+	hds_ui_state.output_win.wptr = hds_ui_state.input_win.wptr =
+			hds_ui_state.console_win.wptr = NULL;
+}
+/**
+ * @brief Initialize cdk screen pointers of hds_state
+ */
+static void init_cdks_pointers() {
+	hds_ui_state.output_win.cdksptr = hds_ui_state.input_win.cdksptr =
+			hds_ui_state.console_win.cdksptr = NULL;
+	hds_ui_state.master_screen = NULL;
+}
+/**
+ * @brief Finds central position where a message can be displayed.
+ *
+ * Returns the position where message should be displayed such that	it appears
+ * in the center of screen.
+ * @param msg_len Length of message to be displayed
+ * @return The beginning location from where message will be displayed
+ */
+static int calculate_msg_center_position(int msg_len) {
+	return ((MIN_COLS - msg_len) / 2);
+}
+/**
+ * @brief Destroys all windows and clears UI.
+ *
+ * Call it when hds is being closed down.
+ */
+void close_ui() {
+	sdebug("Closing down UI");
+	//delete windows
+	destroy_hds_window();
+	//all windows and associated cdkscreens are gone now
+	hds_ui_state.gui_ready = false;
+
+//    sdebug("Press any key to exit!!");
+//    getch();
+
+	/* Exit CDK. */
+	endCDK();
+	refresh();
+	endwin();
+}
+/**
+ * @brief Destroys all window pointers.
+ */
+static void destroy_hds_window() {
+	//destroy window as well as evrything it contains--label,cdkscreens,widgets
+	//etc.
+	//order can be widgets->cdkscreen->window_pointers
+	//place any window specific code in the case that matches
+
+	//first cdkscreens
+	destroy_cdkscreens();
+
+	//now window pointers
+	delwin(hds_ui_state.output_win.wptr);
+	delwin(hds_ui_state.input_win.wptr);
+	delwin(hds_ui_state.console_win.wptr);
+
+}
+/**
+ * @brief Brings focus to console window
+ *
+ * When processing user response through key presses one of the keys might
+ * trigger events in other windows causing console window to loose focus. Then it
+ * becomes necessary to transfer focus to console window. For e.g. as F2 will
+ * bring Help window, giving focus to console is necessary else, program will
+ * no longer be able to get attention.
+ */
+void set_focus_to_console() {
+	activateCDKSwindow(hds_ui_state.console, 0);
+}
+/**
+ * @brief log message to console window
+ *
+ * Log a message to CDK console that we have created. When UI is fully ready,
+ * then log_generic() will call this routine only.
+ * @param msg The message which is to be logged
+ * @param log_level One of LOG_DEBUG,LOG_WARN or LOG_ERR
+ */
+static void log_msg_to_console(const char *msg, log_level_t log_level) {
+	char log_msg[LOG_BUFF_SIZE];
+	/*
+	 * color scheme: <C> is for centering
+	 * </XX> defines a color scheme out of 64 available
+	 * <!XX> ends turns this scheme off
+	 *
+	 * some of interest:
+	 * 	32: yellow foreground on black background
+	 * 	24: green foreground on black background
+	 * 	16: red foreground on black background
+	 * 	17: white foreground on black background
+	 */
+	switch (log_level) {
+	case LOG_DEBUG:
+		snprintf(log_msg, LOG_BUFF_SIZE, "<C></24>%s<!24>", msg);
+		break;
+	case LOG_WARN:
+		snprintf(log_msg, LOG_BUFF_SIZE, "<C></32>%s<!32>", msg);
+		break;
+	case LOG_ERROR:
+		snprintf(log_msg, LOG_BUFF_SIZE, "<C></16>%s<!16>", msg);
+		break;
+	default:
+		//centre placement but no color
+		snprintf(log_msg, LOG_BUFF_SIZE, "<C>%s", msg);
+		break;
+	}
+	addCDKSwindow(hds_ui_state.console, log_msg, BOTTOM);
+}
+/**
+ * @brief Redraw cdk screens.
+ *
+ * After a popup screen is drawn in CDK, it is necessary to redraw under-
+ * lying CDK windows otherwise they will not be displayed on the screen and
+ * program is left in an inconsistent state.
+ */
+static void redraw_cdkscreens() {
+	drawCDKScreen(hds_ui_state.output_win.cdksptr);
+	drawCDKScreen(hds_ui_state.input_win.cdksptr);
+	drawCDKScreen(hds_ui_state.console_win.cdksptr);
+}
+void write_to_result_window(const char* msg,int num_rows){
+	/*
+	 * addCDKSWindow,cleanCDKSWindow and trimCDKSWindow should manage cdkswindows.
+	 */
+	addCDKSwindow(hds_ui_state.output_screen, msg, BOTTOM);
+}
+void execute_commands(const char *command){
+	if ( (strcmp(command,"help") ==0) || (strcmp(command,"HELP") ==0) ){
+		hds_state.stats_manager_active = false;
+		print_help();
+	}
+	else if ((strcmp(command,"print_dl") == 0)){
+		hds_state.stats_manager_active = false;
+		print_loaded_configs();
+	}else if ((strcmp(command,"print_stats") == 0)){
+		hds_state.stats_manager_active = true;
+	}else if ((strncmp(command,"submit",6) == 0)){
+		hds_state.stats_manager_active = false;
+		submit_job_from_console(command);
+	}
+	else{
+		hds_state.stats_manager_active = false;
+		clear_result_window();
+		vprint_result("<C></16>Command <%s> is not recognized !!<!16>",command);
+	}
+}
+void clear_result_window(){
+	cleanCDKSwindow(hds_ui_state.output_screen);
+}
+void print_help(){
+	clear_result_window();
+	sprint_result("<C>Help Options for HOST Shell");
+	sprint_result("<C>---------------------------------------");
+	sprint_result("\tKeyboard shortcuts:");
+	sprint_result("\t\t F4 - Exit HOST");
+	sprint_result("\t\t PAGE_UP - Focus Result window");
+	sprint_result("\t\t PAGE_DOWN - Focus Console window");
+	sprint_result("\t\t Press <ENTER> to complete one command.");
+	sprint_result(" ");
+	sprint_result("Following lists supported commands.");
+	sprint_result("\t\t</32>Command<!32>\t\t\t </24>Action<!24>");
+	sprint_result("\t\tprint_dl\t Shows the job dispatch list of processes loaded from config file.");
+	sprint_result("\t\tprint_stats\t Shows the current system statistics.");
+	sprint_result("\t\tsubmit PRI CPU MEM PRN SCN [DELAY] [KERNEL]\t Submits a new process, arriving after DELAY quanta.");
+	sprint_result(" ");
+	sprint_result("</16>Note:<!16> Commands are case sensitive.");
+}
+/**
+ * @brief Display the configuration that has been parsed from the configuration
+ * file.
+ */
+static void print_loaded_configs() {
+	struct hds_process_t *pclist_iter = hds_config.job_dispatch_list;
+	int i;
+	clear_result_window();
+	sprint_result("Loaded from configuration file:");
+	vprint_result("\tlog_filename: %s", hds_config.log_filename);
+	sprint_result("Max. resource available:");
+	vprint_result("\t memory(MB): %d",
+			hds_config.max_resources.units[HDS_RES_MEMORY]);
+	for (i = HDS_RES_PRINTER; i < hds_config.max_resources.kinds; i++) {
+		vprint_result("\t %s(units): %d", hds_config.max_resources.name[i],
+				hds_config.max_resources.units[i]);
+	}
+	sprint_result("Loaded process dispatch list:");
+	for (; pclist_iter != NULL ; pclist_iter = pclist_iter->next) {
+		vprint_result("\tloaded: pid: %u arrival: %lu priority: %d cpu_req: %d memory_req: %d printer_req: %d scanner_req: %d",
+				pclist_iter->pid, pclist_iter->arrival, pclist_iter->priority,pclist_iter->cpu_req,
+				pclist_iter->req[HDS_RES_MEMORY],
+				pclist_iter->req[HDS_RES_PRINTER], pclist_iter->req[HDS_RES_SCANNER]);
+	}
+	//once the engine starts, processes wait in the arrival queue instead
+	vprint_result("Processes yet to arrive: %u", hds_core_state.arrival_q.size);
+	sprint_result(" ");
+}
+/**
+ * @brief Print info about active process,next_to_run_process and available
+ * 		resources in the result window.
+ */
+static void print_current_cpu_stats() {
+	struct hds_submit_stats_t submit_stats;
+	struct hds_pcb_census_t census;
+	struct hds_cpu_t *cpu = NULL;
+	struct process_queue_t view;
+	int i;
+	/*
+	 * We will print info about active process,next_to_run_process and available
+	 * resources when demanded.
+	 */
+	sprint_result("<C>System Statistics");
+	sprint_result("<C>Resource Status");
+	sprint_result("\t\tMax.\tAvail.");
+	pthread_mutex_lock(&max_available_resource.avail_resource_mutex);
+	for (i = 0; i < hds_config.max_resources.kinds; i++) {
+		vprint_result("%-14s\t%d\t%d", hds_config.max_resources.name[i],
+				hds_config.max_resources.units[i],
+				max_available_resource.avail[i]);
+	}
+	pthread_mutex_unlock(&max_available_resource.avail_resource_mutex);
+	sprint_result("<C>Process Status");
+	sprint_result("\t\t PID\tPRI\tCPU_REQ\tMEM_REQ\tPRN_REQ\tSCN_REQ");
+	for (i = 0; i < hds_core_state.ncpus; i++) {
+		cpu = &hds_core_state.cpu[i];
+		vprint_result("cpu %d: queued %lu stolen %lu promoted %lu", cpu->id,
+				hds_core_queued(cpu), cpu->steals, cpu->policy.promotions);
+		pthread_mutex_lock(&cpu->active_process_lock);
+		if (cpu->active_process_valid == true) {
+			vprint_result("Active:\t\t%d\t%d\t%d\t%d\t%d\t%d",
+					cpu->active_process->pid, cpu->active_process->priority,
+					cpu->active_process->cpu_req,
+					cpu->active_process->req[HDS_RES_MEMORY],
+					cpu->active_process->req[HDS_RES_PRINTER],
+					cpu->active_process->req[HDS_RES_SCANNER]);
+		} else {
+			sprint_result("Active:\t\t-");
+		}
+		pthread_mutex_unlock(&cpu->active_process_lock);
+		if (hds_core_next_to_run(cpu, &view) == true) {
+			vprint_result("NextSchdld:\t%d\t%d\t%d\t%d\t%d\t%d", view.pid,
+					view.priority, view.cpu_req, view.req[HDS_RES_MEMORY],
+					view.req[HDS_RES_PRINTER], view.req[HDS_RES_SCANNER]);
+		} else {
+			sprint_result("NextSchdld:\t-");
+		}
+	}
+	hds_pcb_census(&census);
+	sprint_result("<C>Process Table");
+	sprint_result("\t\t InUse\tRtQ\tP1Q\tP2Q\tP3Q\tResWait\tBacklog");
+	vprint_result("\t\t %lu\t%lu\t%lu\t%lu\t%lu\t%lu\t%lu",
+			hds_pcb_in_use(), census.queued[0], census.queued[1],
+			census.queued[2], census.queued[3],
+			census.state[HDS_PCB_RESOURCE_WAIT], census.backlog);
+	hds_submit_get_stats(&submit_stats);
+	sprint_result("<C>Submission Ring");
+	sprint_result("\t\t Size\tPending\tSubmtd\tRejctd\tDrained\tHighWM");
+	vprint_result("\t\t %lu\t%lu\t%lu\t%lu\t%lu\t%lu", submit_stats.capacity,
+			submit_stats.pending, submit_stats.submitted, submit_stats.rejected,
+			submit_stats.drained, submit_stats.high_watermark);
+	// we can print the original loaded process dispactch queue
+	// we will need to maintain one extra field in process structure that is name.
+	// it can be populated at runtime by dispatcher and will help in giving a
+	// proper identification. names will be like: P1,P2,P3 etc. Note that name will
+	// be just an integer but when accessing it, prefix it by 'P'
+	// also we will maintaina execution queue which will be an array maintained
+	// by cpu thread which will just point out that for every quantum which process
+	// was executed. like : 1,3,3,3,2,1,4,1 but will be printed as :
+	// P1,P3,P3,P3,P2,P1,P4,P1
+	// also print lets say 20 such entries per line only.
+}
+/**
+ * @brief Main routine for stats manager thread. Refreshes the result window
+ * 		every second while print_stats is active.
+ * @param args
+ */
+void *hds_stats_manager(void *args) {
+	while (1) {
+		if (hds_state.shutdown_in_progress == true) {
+			break;
+		}
+		if (hds_state.stats_manager_active == true) {
+			clear_result_window();
+			print_current_cpu_stats();
+			sleep(1);
+		} else {
+			sleep(1);
+		}
+	}
+	sdebug("stats manager shutting down");
+	pthread_exit(NULL );
+}
+/**
+ * @brief Parse a submit command and put the process into the submission ring.
+ * @param command "submit PRI CPU MEM PRN SCN [DELAY] [KERNEL]"
+ */
+static void submit_job_from_console(const char *command) {
+	struct hds_process_t job;
+	char kernel[16] = "sleep";
+	int delay = 0, mem = 0, prn = 0, scn = 0, kernel_id;
+	clear_result_window();
+	memset(&job, 0, sizeof(job));
+	if (sscanf(command, "submit %d %d %d %d %d %d %15s", &job.priority,
+			&job.cpu_req, &mem, &prn, &scn, &delay, kernel) < 5
+			|| job.priority < 0 || job.priority > 3 || delay < 0
+			|| (kernel_id = hds_kernel_lookup(kernel)) == -1) {
+		sprint_result("Usage: submit PRI(0-3) CPU MEM PRN SCN [DELAY] [sleep|simd|stream|chase|io]");
+		return;
+	}
+	job.kernel = kernel_id;
+	job.req[HDS_RES_MEMORY] = mem;
+	job.req[HDS_RES_PRINTER] = prn;
+	job.req[HDS_RES_SCANNER] = scn;
+	job.arrival = delay;
+	if (hds_submit_job(&job) != HDS_OK) {
+		sprint_result("</16>Submission ring is full, try again later.<!16>");
+		return;
+	}
+	vprint_result("Submitted process: priority: %d cpu_req: %d memory_req: %d printer_req: %d scanner_req: %d kernel: %s",
+			job.priority, job.cpu_req, mem, prn, scn,
+			hds_kernel_name(job.kernel));
 }
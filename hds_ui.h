@@ -4,7 +4,7 @@
  */
 /* WINDOW drawing rules
  * --------------------
- * window's coordinates are specified in its handle in hds_state
+ * window's coordinates are specified in its handle in hds_ui_state
  *  do not cross these coordinates for.e.g writing must be in between
  *  console.wptr.beg_x+1 till console.wptr.height-1
  *  and width:
@@ -18,9 +18,66 @@
 	#include "hds_dtypes.h"
 #endif
 
+#include<curses.h>
 #include "hds_common.h"
+#include "hds_core.h"
+#include "cdk_wrap.h"
+
+#ifdef HAVE_XCURSES
+char *XCursesProgramName = "HOST";
+#endif
+/**
+ * @struct window_state_t
+ * @brief A structure for holding window related information.
+ */
+struct window_state_t {
+	WINDOW *wptr;
+	int beg_x, beg_y, height, width; //window coordinates
+	int cur_x, cur_y;
+	CDKSCREEN *cdksptr;
+};
+/**
+ * @struct HDS_UI_STATE
+ * @brief State of the curses/CDK frontend. Kept apart from hds_state so that
+ * 		the core can be built and run without curses.
+ */
+struct HDS_UI_STATE {
+	struct window_state_t output_win, input_win, console_win;
+	// ----------global labels------------------------
+	bool color_ok;
+	char result_msg[LOG_BUFF_SIZE];
+
+	bool curses_ready;
+	bool gui_ready;
+	int hori_pad, vert_pad;
+
+	//cdk specific window pointers
+	CDK_PARAMS params;
+	CDKSWINDOW *console;
+	CDKSWINDOW *output_screen;
+	CDKSCREEN *master_screen;
+	WINDOW *cursesWin; //main curses window--stdscr
+	CDKENTRY *read_input;
+} hds_ui_state;
+
+#define sprint_result(s) snprintf(hds_ui_state.result_msg, LOG_BUFF_SIZE,s );\
+		write_to_result_window(hds_ui_state.result_msg,1);
+
+#define vprint_result(s,...) snprintf(hds_ui_state.result_msg, LOG_BUFF_SIZE,s,__VA_ARGS__ );\
+		write_to_result_window(hds_ui_state.result_msg,1);
+
 //routines
+void init_hds_ui_state();
 int init_curses(); //initialize curses mode and other secondary routines
 int hds_ui_main(); //draw the curses UI for HDS
+void close_ui();
+void destroy_win(WINDOW *local_win);
+void set_focus_to_console();
+void destroy_cdkscreens();
+void display_help();
+void write_to_result_window(const char* msg,int num_rows);
+void print_help();
+void execute_commands(const char *command);
+void clear_result_window();
+void *hds_stats_manager(void *args);
 #endif
-
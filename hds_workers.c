@@ -0,0 +1,243 @@
+/**
+ * @file hds_workers.c
+ * @brief Worker processes forked ahead of need, for the realtime engine.
+ * 		  Starting a process used to be a fork() by its cpu thread, between
+ * 		  the process being picked and it running, and fork() costs more the
+ * 		  larger hds has grown. A few workers are kept parked instead,
+ * 		  listed in memory shared with hds and each waiting for a signal; a
+ * 		  cpu starts a process by taking one off the list and queueing it
+ * 		  HDS_WORKER_SIGNAL with what the process is to do.
+ *
+ * 		  Workers are not forked by hds itself: that would still stall every
+ * 		  thread of hds while its pages are copied. A small spawner process,
+ * 		  forked once when the pool starts, keeps the pool full. It creates
+ * 		  workers with CLONE_PARENT, so they are children of hds, which
+ * 		  signals, stops and collects them like any process it forked.
+ */
+#define _GNU_SOURCE // CLONE_PARENT
+#include "hds_workers.h"
+#include "hds_core.h"
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+//=========== routines declaration============
+static void spawner_main();
+static void worker_main();
+static unsigned int parked_workers();
+static int wait_sem(sem_t *sem);
+//===========================================
+static struct hds_workers_t {
+	struct hds_workers_shm_t *shm; /**< NULL without a pool */
+	pid_t spawner;
+	void (*work)(unsigned long int arg); /**< What a worker does once it has
+	 	 	 	 	 	 	 	 	 	 	 	 a job, given what came with it */
+	unsigned long int misses; /**< Processes started without a parked worker */
+} pool;
+
+/**
+ * @brief Start the spawner, which forks size workers and keeps them parked.
+ * 		Waits a little for the first ones so that early processes find them.
+ * @param size No. of workers to keep parked, 0 for none.
+ * @param work Run by a worker once it has a job, must not return. Given the
+ * 		arg the job was handed over with.
+ * @return HDS_OK on success else an error code.
+ */
+int hds_workers_start(unsigned int size, void (*work)(unsigned long int arg)) {
+	unsigned int waited;
+	memset(&pool, 0, sizeof(pool));
+	pool.work = work;
+	if (size == 0) {
+		return HDS_OK;
+	}
+	pool.shm = (struct hds_workers_shm_t *) mmap(NULL,
+			sizeof(struct hds_workers_shm_t), PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (pool.shm == MAP_FAILED) {
+		pool.shm = NULL;
+		serror("worker pool: Failed to map shared memory");
+		return HDS_ERR_NO_MEM;
+	}
+	pool.shm->hds_pid = getpid();
+	pool.shm->size = size;
+	sem_init(&pool.shm->refill, 1, 0);
+	switch (pool.spawner = fork()) {
+	case -1:
+		serror("worker pool: fork() failed");
+		munmap(pool.shm, sizeof(struct hds_workers_shm_t));
+		pool.shm = NULL;
+		return HDS_ERR_GENERIC;
+	case 0:
+		spawner_main();
+		break;
+	default:
+		break;
+	}
+	for (waited = 0; parked_workers() < size && waited < 1000; waited++) {
+		usleep(1000);
+	}
+	var_debug("worker pool: %u workers parked", parked_workers());
+	return HDS_OK;
+}
+/**
+ * @brief Stop the spawner and collect every parked worker. Called once no
+ * 		cpu takes workers anymore.
+ */
+void hds_workers_stop() {
+	struct hds_worker_slot_t *slot = NULL;
+	unsigned int i;
+	int status, parked = HDS_WORKER_PARKED;
+	if (!pool.shm) {
+		return;
+	}
+	__atomic_store_n(&pool.shm->stop, true, __ATOMIC_RELEASE);
+	sem_post(&pool.shm->refill);
+	waitpid(pool.spawner, &status, 0);
+	for (i = 0; i < pool.shm->size; i++) {
+		slot = &pool.shm->slot[i];
+		if (__atomic_compare_exchange_n(&slot->state, &parked,
+				HDS_WORKER_TAKEN, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+			kill(slot->pid, SIGKILL);
+			waitpid(slot->pid, &status, 0);
+		}
+		parked = HDS_WORKER_PARKED;
+	}
+	munmap(pool.shm, sizeof(struct hds_workers_shm_t));
+	pool.shm = NULL;
+}
+/**
+ * @brief Hand a job to a parked worker, which then runs as its process. Any
+ * 		cpu thread may call it, slots are claimed with compare and swap.
+ * @param arg Queued with the signal and given to work() by the worker.
+ * @return pid of the worker or 0 if none is parked; the caller forks the
+ * 		process itself then.
+ */
+pid_t hds_workers_take(unsigned int job_id, unsigned long int arg) {
+	struct hds_worker_slot_t *slot = NULL;
+	union sigval job;
+	unsigned int i;
+	int parked = HDS_WORKER_PARKED;
+	pid_t pid = 0;
+	if (!pool.shm) {
+		return 0;
+	}
+	for (i = 0; i < pool.shm->size; i++) {
+		slot = &pool.shm->slot[i];
+		if (__atomic_compare_exchange_n(&slot->state, &parked,
+				HDS_WORKER_TAKEN, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+			break;
+		}
+		parked = HDS_WORKER_PARKED;
+	}
+	if (i < pool.shm->size) {
+		pid = slot->pid;
+		// the signal is queued to the worker, the slot is free right away
+		__atomic_store_n(&slot->state, HDS_WORKER_EMPTY, __ATOMIC_RELEASE);
+		job.sival_ptr = (void *) arg;
+		if (sigqueue(pid, HDS_WORKER_SIGNAL, job) != 0) {
+			var_error("worker pool: Failed to hand job %u to worker %d",
+					job_id, pid);
+			kill(pid, SIGKILL);
+			waitpid(pid, NULL, 0);
+			pid = 0;
+		}
+	}
+	sem_post(&pool.shm->refill);
+	if (i == pool.shm->size || pid == 0) {
+		__atomic_add_fetch(&pool.misses, 1, __ATOMIC_RELAXED);
+		return 0;
+	}
+	return pid;
+}
+/**
+ * @brief No. of processes which were started without a parked worker.
+ */
+unsigned long int hds_workers_misses() {
+	return __atomic_load_n(&pool.misses, __ATOMIC_RELAXED);
+}
+/**
+ * @brief Body of the spawner: park a worker in an empty slot whenever fewer
+ * 		than size are parked. Leaves on stop or once hds is gone.
+ */
+static void spawner_main() {
+	struct hds_workers_shm_t *shm = pool.shm;
+	unsigned int i;
+	sigset_t set;
+	pid_t pid;
+	// workers only take it from sigtimedwait()
+	sigemptyset(&set);
+	sigaddset(&set, HDS_WORKER_SIGNAL);
+	sigprocmask(SIG_BLOCK, &set, NULL );
+	while (__atomic_load_n(&shm->stop, __ATOMIC_ACQUIRE) == false
+			&& getppid() == shm->hds_pid) {
+		for (i = 0; i < shm->size; i++) {
+			if (__atomic_load_n(&shm->slot[i].state, __ATOMIC_ACQUIRE)
+					== HDS_WORKER_EMPTY) {
+				break;
+			}
+		}
+		if (i == shm->size) {
+			wait_sem(&shm->refill);
+			continue;
+		}
+		// a child of hds rather than of the spawner
+		pid = syscall(SYS_clone, CLONE_PARENT | SIGCHLD, 0, 0, 0, 0);
+		if (pid == 0) {
+			worker_main();
+		}
+		if (pid == -1) {
+			wait_sem(&shm->refill);
+			continue;
+		}
+		shm->slot[i].pid = pid;
+		__atomic_store_n(&shm->slot[i].state, HDS_WORKER_PARKED,
+				__ATOMIC_RELEASE);
+	}
+	_exit(EXIT_SUCCESS);
+}
+/**
+ * @brief Body of a worker: wait for a job and run it. Leaves if hds goes
+ * 		away first.
+ */
+static void worker_main() {
+	struct timespec second = { 1, 0 };
+	siginfo_t job;
+	sigset_t set;
+	sigemptyset(&set);
+	sigaddset(&set, HDS_WORKER_SIGNAL);
+	while (sigtimedwait(&set, &job, &second) != HDS_WORKER_SIGNAL) {
+		if (getppid() != pool.shm->hds_pid) {
+			_exit(EXIT_SUCCESS);
+		}
+	}
+	pool.work((unsigned long int) job.si_value.sival_ptr);
+	_exit(EXIT_SUCCESS);
+}
+/**
+ * @brief No. of workers parked right now.
+ */
+static unsigned int parked_workers() {
+	unsigned int i, parked = 0;
+	for (i = 0; i < pool.shm->size; i++) {
+		if (__atomic_load_n(&pool.shm->slot[i].state, __ATOMIC_ACQUIRE)
+				== HDS_WORKER_PARKED) {
+			parked++;
+		}
+	}
+	return parked;
+}
+/**
+ * @brief Wait on a semaphore for at most a second, so that the spawner
+ * 		notices when hds has gone away.
+ * @return 0 if it was posted, -1 if the second has passed.
+ */
+static int wait_sem(sem_t *sem) {
+	struct timespec until;
+	clock_gettime(CLOCK_REALTIME, &until);
+	until.tv_sec += 1;
+	while (sem_timedwait(sem, &until) != 0) {
+		if (errno != EINTR) {
+			return -1;
+		}
+	}
+	return 0;
+}
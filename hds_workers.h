@@ -0,0 +1,52 @@
+/**
+ * @file hds_workers.h
+ * @brief header file for hds_workers.c
+ */
+#ifndef HDS_WORKERS_H_
+#define HDS_WORKERS_H_
+
+#include "hds_common.h"
+#include <semaphore.h>
+
+/**
+ * @def HDS_WORKER_SIGNAL
+ * @brief Queued to a parked worker to start it, with what it is to do.
+ */
+#define HDS_WORKER_SIGNAL SIGUSR1
+
+/**
+ * @enum hds_worker_state_t
+ * @brief What a slot of the worker pool holds.
+ */
+typedef enum {
+	HDS_WORKER_EMPTY, /**< No worker, the spawner may fill it */
+	HDS_WORKER_PARKED, /**< Worker waiting for a job */
+	HDS_WORKER_TAKEN /**< Being handed a job, empty again right after */
+} hds_worker_state_t;
+/**
+ * @struct hds_worker_slot_t
+ * @brief A parked worker as seen by hds and the spawner. state is only
+ * 		accessed atomically; pid is valid while it is HDS_WORKER_PARKED.
+ */
+struct hds_worker_slot_t {
+	pid_t pid;
+	int state; /**< hds_worker_state_t */
+};
+/**
+ * @struct hds_workers_shm_t
+ * @brief Memory shared by hds and the spawner.
+ */
+struct hds_workers_shm_t {
+	sem_t refill; /**< Posted when a worker is taken or on stop */
+	pid_t hds_pid; /**< Spawner and workers leave once their parent is not */
+	bool stop;
+	unsigned int size; /**< No. of workers to keep parked, one slot each */
+	struct hds_worker_slot_t slot[HDS_MAX_WORKERS];
+};
+
+// --------routines-----------
+int hds_workers_start(unsigned int size, void (*work)(unsigned long int arg));
+void hds_workers_stop();
+pid_t hds_workers_take(unsigned int job_id, unsigned long int arg);
+unsigned long int hds_workers_misses();
+#endif /* HDS_WORKERS_H_ */
@@ -0,0 +1,23 @@
+#!/bin/sh
+#
+# Runs 'hds -b' on the hds.conf of every directory in tests/ and fails
+# unless every job of it completed. HDS may name the binary to be run,
+# by absolute path; by default it is the one built in the top directory.
+#
+cd "$(dirname "$0")" || exit 1
+HDS=${HDS:-$(pwd)/../hds}
+status=0
+for dir in */; do
+	dir=${dir%/}
+	[ -f "$dir/hds.conf" ] || continue
+	if (cd "$dir" && "$HDS" -b -o result.csv > /dev/null 2>&1) \
+			&& grep -q "^# jobs_completed,[1-9]" "$dir/result.csv" \
+			&& ! grep -q "^# jobs_\(failed\|stranded\),[1-9]" "$dir/result.csv"; then
+		echo "ok: $dir"
+	else
+		echo "FAIL: $dir"
+		status=1
+	fi
+	rm -f "$dir/result.csv" "$dir/hds_output.log"
+done
+exit $status